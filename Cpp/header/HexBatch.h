@@ -0,0 +1,101 @@
+/*
+ * HexBatch.h
+ *
+ * Пакетные (SIMD) преобразования координат
+ */
+
+#pragma once
+#ifndef HEXBATCH_H
+#define HEXBATCH_H
+
+#include "HexGrid.h"
+
+#include <cstddef>
+
+// ================================================================
+// Реализация пакетных преобразований
+// ================================================================
+// HEX_BATCH_AUTO = Лучшая из поддерживаемых процессором
+// HEX_BATCH_SCALAR = Скалярная (без SIMD)
+// HEX_BATCH_SSE2 = SSE2 (2 значения double или 4 значения int за операцию)
+// HEX_BATCH_AVX2 = AVX2 (4 значения double или 8 значений int за операцию)
+// ================================================================
+enum HexBatchKernel_t {
+    HEX_BATCH_AUTO = -1,
+    HEX_BATCH_SCALAR = 0,
+    HEX_BATCH_SSE2 = 1,
+    HEX_BATCH_AVX2 = 2
+};
+
+// ================================================================
+// Реализация, которая будет использована для запрошенной
+// ================================================================
+// Если процессор не поддерживает запрошенную реализацию,
+// выбирается лучшая из доступных, но не выше запрошенной
+// ================================================================
+HexBatchKernel_t HexBatchKernel( HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+// ================================================================
+// Название реализации
+// ================================================================
+const char* HexBatchKernelName( HexBatchKernel_t kernel );
+
+// ================================================================
+// Координаты на плоскости => Координаты гекса (с округлением)
+// ================================================================
+// Массивы x, y (структура массивов) длины count => массивы q, r
+// Результат совпадает с PixelToHex( layout, Point( x, y ) ).Round( round_algorithm ),
+// алгоритм округления выбирается один раз на весь пакет
+// ================================================================
+void PixelToHexBatch( const HexLayout& layout, const double* x, const double* y, size_t count,
+                      int* q, int* r, int round_algorithm = HEX_ROUND_DEFAULT,
+                      HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+// ================================================================
+// Координаты гексов => Координаты центров на плоскости
+// ================================================================
+// Массивы q, r длины count => массивы x, y
+// Результат совпадает с Hex( q, r ).HexToPixel( layout )
+// ================================================================
+void HexToPixelBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                      double* x, double* y, HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+// ================================================================
+// Количество значений в буфере вершин на один гекс (6 углов * ( x, y ))
+// ================================================================
+const size_t HEX_CORNER_VERTEX_STRIDE = 12;
+
+// ================================================================
+// Углы гексов на плоскости => Буфер вершин
+// ================================================================
+// Массивы q, r длины count => буфер vertices длины count * HEX_CORNER_VERTEX_STRIDE,
+// для каждого гекса подряд x0, y0, x1, y1, ..., x5, y5
+// Результат совпадает с Hex( q, r ).HexCorners( layout ), смещения углов
+// вычисляются один раз на весь пакет
+// ================================================================
+void HexCornersBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                      double* vertices, HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+// ================================================================
+// Офсетные координаты => Кубические координаты
+// ================================================================
+// Массивы col, row длины count => массивы q, r
+// Результат совпадает с Offset_to_Cube( layout, OffsetHex( col, row ) ),
+// вариант ( Q_Offset_to_Cube / R_Offset_to_Cube, нечётный / чётный )
+// выбирается один раз на весь пакет. Массивы результата могут
+// совпадать с исходными ( q == col, r == row )
+// ================================================================
+void OffsetToCubeBatch( const HexLayout& layout, const int* col, const int* row, size_t count,
+                        int* q, int* r, HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+// ================================================================
+// Кубические координаты => Офсетные координаты
+// ================================================================
+// Массивы q, r длины count => массивы col, row
+// Результат совпадает с Cube_to_Offset( layout, Hex( q, r ) ),
+// массивы результата могут совпадать с исходными ( col == q, row == r )
+// ================================================================
+void CubeToOffsetBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                        int* col, int* row, HexBatchKernel_t kernel = HEX_BATCH_AUTO );
+
+#endif // HEXBATCH_H
@@ -0,0 +1,97 @@
+/*
+ * HexBinner.h
+ *
+ * Потоковый подсчёт точек по гексам (гистограмма)
+ */
+
+#pragma once
+#ifndef HEXBINNER_H
+#define HEXBINNER_H
+
+#include "HexGrid.h"
+#include "HexChunkMap.h"
+#include "HexThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+
+// ================================================================
+// Подсчёт точек плоскости по гексам
+// ================================================================
+// Точки обрабатываются частями: гексы вычисляются пакетами
+// PixelToHexBatch, счётчики увеличиваются в частичной гистограмме
+// своего потока (без синхронизации), Histogram() складывает частичные
+// гистограммы в общую. Потоки читаются блоками по chunk_points точек,
+// поэтому память ограничена буфером блока и гистограммами
+// (количество гексов с точками на поток), но не объёмом входных данных
+// ================================================================
+class HexBinner {
+public:
+    // Количество точек в блоке чтения по умолчанию
+    static constexpr size_t DEFAULT_CHUNK_POINTS = 1 << 20;
+
+    explicit HexBinner( const HexLayout& layout, HexThreadPool* pool = nullptr,
+                        size_t chunk_points = DEFAULT_CHUNK_POINTS );
+
+    HexBinner( const HexBinner& ) = delete;
+    HexBinner& operator =( const HexBinner& ) = delete;
+
+    // Точки с координатами x[ i ], y[ i ]
+    void Add( const double* x, const double* y, size_t count );
+
+    // ================================================================
+    // Точки из текстового потока: строка "x y" (разделители - пробелы,
+    // табуляция, ',' или ';'), пустые строки пропускаются,
+    // строки без двух чисел (например, заголовок CSV) учитываются в Rejected()
+    // ================================================================
+    uint64_t ReadText( std::istream& input );
+
+    // Точки из двоичного потока: пары double ( x, y ) подряд (порядок байтов машины)
+    uint64_t ReadBinary( std::istream& input );
+
+    // Количество учтённых точек и отвергнутых строк текста
+    uint64_t Points() const;
+    uint64_t Rejected() const;
+
+    // Гистограмма: количество точек в каждом гексе (частичные гистограммы складываются)
+    HexChunkMap<uint64_t>& Histogram();
+
+    // Сброс счётчиков
+    void Clear();
+
+private:
+    // Размер пакета вычисления гексов
+    static constexpr size_t BATCH_SIZE = 4096;
+
+    // Рабочие данные потока: буферы пакета и частичная гистограмма
+    struct Worker {
+        vector<double> x;
+        vector<double> y;
+        vector<int> q;
+        vector<int> r;
+        HexChunkMap<uint64_t> counts;
+        uint64_t points = 0;
+        uint64_t rejected = 0;
+    };
+
+    // Вызов task( index, worker ) для index = 0..tasks-1 (параллельно, если задан пул)
+    void Run( size_t tasks, const std::function<void( size_t, Worker& )>& task );
+
+    // Подсчёт count точек (не более BATCH_SIZE) в частичной гистограмме потока
+    void Bin( Worker& worker, const double* x, const double* y, size_t count ) const;
+
+    // Разбор текстовых строк [begin, end) (end - после '\n')
+    void ParseText( Worker& worker, const char* begin, const char* end ) const;
+
+    const HexLayout layout;
+    HexThreadPool* pool;
+    const size_t chunk_points;
+
+    vector<std::unique_ptr<Worker>> workers;
+    HexChunkMap<uint64_t> histogram;
+};
+
+#endif // HEXBINNER_H
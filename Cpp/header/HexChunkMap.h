@@ -0,0 +1,314 @@
+/*
+ * HexChunkMap.h
+ *
+ * Разреженная карта гексов: данные хранятся плотными блоками (чанками)
+ */
+
+#pragma once
+#ifndef HEXCHUNKMAP_H
+#define HEXCHUNKMAP_H
+
+#include "HexGrid.h"
+#include "HexKey.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+// ================================================================
+// Разреженная карта гексов для неограниченных миров
+// ================================================================
+// Плоскость разбита на ромбовидные чанки 2^chunk_bits x 2^chunk_bits
+// гексов (по осям Q и R). Внутри чанка ячейки хранятся плотно,
+// чанки находятся в хеш-таблице с открытой адресацией (линейное
+// пробирование) и создаются при первой записи
+// ================================================================
+template<class T, unsigned chunk_bits = 4>
+class HexChunkMap {
+public:
+    // Длина стороны чанка
+    static constexpr int CHUNK_SIDE = 1 << chunk_bits;
+
+    // Количество ячеек в чанке
+    static constexpr size_t CHUNK_SIZE = static_cast<size_t>( CHUNK_SIDE ) * CHUNK_SIDE;
+
+    // ================================================================
+    // Обработчик вытеснения чанка: начальный гекс чанка и его ячейки
+    // (CHUNK_SIZE значений, индекс ячейки см. ChunkCellHex)
+    // ================================================================
+    using EvictionCallback = std::function<void( const Hex& origin, T* cells )>;
+
+    explicit HexChunkMap( const T& default_value_ = T() ) :
+        default_value( default_value_ ), slots( MIN_CAPACITY ), chunk_count( 0 ) {}
+
+    HexChunkMap( const HexChunkMap& ) = delete;
+    HexChunkMap& operator =( const HexChunkMap& ) = delete;
+
+    // Начальный гекс чанка, содержащего гекс
+    static Hex ChunkOrigin( const Hex& hex ) {
+        return Hex( ( hex.Q() >> chunk_bits ) * CHUNK_SIDE, ( hex.R() >> chunk_bits ) * CHUNK_SIDE );
+    }
+
+    // Гекс ячейки чанка по индексу
+    static Hex ChunkCellHex( const Hex& origin, size_t index ) {
+        return Hex( origin.Q() + static_cast<int>( index % CHUNK_SIDE ), origin.R() + static_cast<int>( index / CHUNK_SIDE ) );
+    }
+
+    // Индекс ячейки гекса в его чанке
+    static size_t ChunkCellIndex( const Hex& hex ) { return CellIndex( hex ); }
+
+    // Установить обработчик вытеснения чанков
+    void SetEvictionCallback( EvictionCallback callback ) { eviction_callback = std::move( callback ); }
+
+    // Данные ячейки (чанк создаётся при необходимости)
+    T& operator []( const Hex& hex ) {
+        return FindOrCreateChunk( ChunkKey( hex ) )->cells[ CellIndex( hex ) ];
+    }
+
+    // ================================================================
+    // Ячейки чанка, содержащего гекс (CHUNK_SIZE значений, чанк создаётся при необходимости)
+    // ================================================================
+    // Указатель действителен до вытеснения чанка
+    // ================================================================
+    T* ChunkCells( const Hex& hex ) { return FindOrCreateChunk( ChunkKey( hex ) )->cells; }
+
+    // Данные ячейки или nullptr, если чанк не создан
+    T* Find( const Hex& hex ) {
+        Chunk* chunk = FindChunk( ChunkKey( hex ) );
+        return ( chunk != nullptr ? &chunk->cells[ CellIndex( hex ) ] : nullptr );
+    }
+
+    const T* Find( const Hex& hex ) const { return const_cast<HexChunkMap*>( this )->Find( hex ); }
+
+    // Данные ячейки или значение по умолчанию, если чанк не создан
+    const T& Get( const Hex& hex ) const {
+        const T* value = Find( hex );
+        return ( value != nullptr ? *value : default_value );
+    }
+
+    // Данные соседней ячейки или nullptr, если чанк не создан
+    T* Neighbor( const Hex& hex, int direction ) { return Find( hex + HexDirection( direction ) ); }
+
+    // ================================================================
+    // Вызов func( neighbor_hex, neighbor_value ) для соседей в созданных чанках
+    // ================================================================
+    // Соседи внутри того же чанка обходятся без обращения к хеш-таблице
+    // ================================================================
+    template<class Func>
+    void ForEachNeighbor( const Hex& hex, Func func ) {
+        const uint64_t key = ChunkKey( hex );
+        Chunk* chunk = FindChunk( key );
+
+        for ( const Hex& direction : HEX_DIRECTIONS ) {
+            const Hex neighbor = hex + direction;
+            const uint64_t neighbor_key = ChunkKey( neighbor );
+            Chunk* neighbor_chunk = ( neighbor_key == key ? chunk : FindChunk( neighbor_key ) );
+
+            if ( neighbor_chunk != nullptr ) {
+                func( neighbor, neighbor_chunk->cells[ CellIndex( neighbor ) ] );
+            }
+        }
+    }
+
+    // Количество чанков
+    size_t ChunkCount() const { return chunk_count; }
+
+    // Чанк, содержащий гекс, создан
+    bool HasChunk( const Hex& hex ) const { return const_cast<HexChunkMap*>( this )->FindChunk( ChunkKey( hex ) ) != nullptr; }
+
+    // Вызов func( origin, cells ) для каждого чанка
+    template<class Func>
+    void ForEachChunk( Func func ) {
+        for ( Slot& slot : slots ) {
+            if ( slot.chunk ) {
+                func( slot.chunk->origin, slot.chunk->cells );
+            }
+        }
+    }
+
+    // ================================================================
+    // Вытеснение чанка, содержащего гекс (с вызовом обработчика)
+    // ================================================================
+    bool EvictChunk( const Hex& hex ) {
+        const uint64_t key = ChunkKey( hex );
+        size_t i = Home( key );
+
+        while ( slots[ i ].chunk ) {
+            if ( slots[ i ].key == key ) {
+                Evict( slots[ i ].chunk );
+                EraseSlot( i );
+                return true;
+            }
+
+            i = ( i + 1 ) & ( slots.size() - 1 );
+        }
+
+        return false;
+    }
+
+    // ================================================================
+    // Вытеснение всех чанков, для которых predicate( origin, cells ) == true
+    // ================================================================
+    template<class Predicate>
+    size_t EvictChunks( Predicate predicate ) {
+        size_t evicted = 0;
+
+        for ( size_t i = 0; i < slots.size(); ) {
+            if ( slots[ i ].chunk && predicate( slots[ i ].chunk->origin, slots[ i ].chunk->cells ) ) {
+                Evict( slots[ i ].chunk );
+                // На место удалённого слота может сдвинуться следующий: проверяем его снова
+                EraseSlot( i );
+                ++evicted;
+            } else {
+                ++i;
+            }
+        }
+
+        return evicted;
+    }
+
+    // Вытеснение всех чанков
+    void Clear() {
+        for ( Slot& slot : slots ) {
+            if ( slot.chunk ) {
+                Evict( slot.chunk );
+                slot.chunk.reset();
+            }
+        }
+
+        chunk_count = 0;
+    }
+
+    // Занимаемая память (байт)
+    size_t MemoryUsage() const {
+        return sizeof( *this ) + slots.capacity() * sizeof( Slot ) + chunk_count * sizeof( Chunk );
+    }
+
+private:
+    // Минимальная ёмкость хеш-таблицы (степень двойки)
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    // Чанк: начальный гекс и плотный массив ячеек (индекс = lr * CHUNK_SIDE + lq)
+    struct Chunk {
+        explicit Chunk( const Hex& origin_, const T& value ) : origin( origin_ ) {
+            for ( T& cell : cells ) {
+                cell = value;
+            }
+        }
+
+        const Hex origin;
+        T cells[ CHUNK_SIZE ];
+    };
+
+    // Слот хеш-таблицы (пустой, если chunk == nullptr)
+    struct Slot {
+        uint64_t key = 0;
+        std::unique_ptr<Chunk> chunk;
+    };
+
+    // Ключ чанка: упакованные координаты чанка по Q и R ( HexPack )
+    static uint64_t ChunkKey( const Hex& hex ) {
+        return HexPack( Hex( hex.Q() >> chunk_bits, hex.R() >> chunk_bits ) );
+    }
+
+    // Индекс ячейки внутри чанка
+    static size_t CellIndex( const Hex& hex ) {
+        return ( static_cast<size_t>( hex.R() & ( CHUNK_SIDE - 1 ) ) << chunk_bits ) | ( hex.Q() & ( CHUNK_SIDE - 1 ) );
+    }
+
+    // Начальный слот ключа
+    size_t Home( uint64_t key ) const {
+        return static_cast<size_t>( HexHash64( key ) ) & ( slots.size() - 1 );
+    }
+
+    Chunk* FindChunk( uint64_t key ) {
+        for ( size_t i = Home( key ); slots[ i ].chunk; i = ( i + 1 ) & ( slots.size() - 1 ) ) {
+            if ( slots[ i ].key == key ) {
+                return slots[ i ].chunk.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    Chunk* FindOrCreateChunk( uint64_t key ) {
+        Chunk* chunk = FindChunk( key );
+
+        if ( chunk != nullptr ) {
+            return chunk;
+        }
+
+        // Коэффициент заполнения не более 1/2
+        if ( 2 * ( chunk_count + 1 ) > slots.size() ) {
+            Rehash( 2 * slots.size() );
+        }
+
+        const Hex origin = HexUnpack( key ) * CHUNK_SIDE;
+        size_t i = Home( key );
+
+        while ( slots[ i ].chunk ) {
+            i = ( i + 1 ) & ( slots.size() - 1 );
+        }
+
+        slots[ i ].key = key;
+        slots[ i ].chunk.reset( new Chunk( origin, default_value ) );
+        ++chunk_count;
+        return slots[ i ].chunk.get();
+    }
+
+    void Rehash( size_t capacity ) {
+        vector<Slot> old_slots( capacity );
+        old_slots.swap( slots );
+
+        for ( Slot& slot : old_slots ) {
+            if ( slot.chunk ) {
+                size_t i = Home( slot.key );
+
+                while ( slots[ i ].chunk ) {
+                    i = ( i + 1 ) & ( slots.size() - 1 );
+                }
+
+                slots[ i ] = std::move( slot );
+            }
+        }
+    }
+
+    // Удаление слота со сдвигом следующих слотов (без "надгробий")
+    void EraseSlot( size_t i ) {
+        const size_t mask = slots.size() - 1;
+        slots[ i ].chunk.reset();
+        --chunk_count;
+
+        for ( size_t j = ( i + 1 ) & mask; slots[ j ].chunk; j = ( j + 1 ) & mask ) {
+            const size_t home = Home( slots[ j ].key );
+
+            // Слот j можно перенести в i, если его начальный слот не лежит в ( i, j ]
+            if ( ( ( j - home ) & mask ) >= ( ( j - i ) & mask ) ) {
+                slots[ i ] = std::move( slots[ j ] );
+                i = j;
+            }
+        }
+    }
+
+    void Evict( const std::unique_ptr<Chunk>& chunk ) {
+        if ( eviction_callback ) {
+            eviction_callback( chunk->origin, chunk->cells );
+        }
+    }
+
+    // Значение ячеек несозданных чанков
+    const T default_value;
+
+    // Хеш-таблица чанков
+    vector<Slot> slots;
+
+    // Количество чанков
+    size_t chunk_count;
+
+    // Обработчик вытеснения чанков
+    EvictionCallback eviction_callback;
+};
+
+#endif // HEXCHUNKMAP_H
@@ -0,0 +1,534 @@
+/*
+ * HexFlowField.h
+ *
+ * Поле расстояний и направлений движения к общей цели
+ */
+
+#pragma once
+#ifndef HEXFLOWFIELD_H
+#define HEXFLOWFIELD_H
+
+#include "HexGrid.h"
+#include "HexIndexedHeap.h"
+#include "HexMap.h"
+#include "HexPathfinder.h"
+#include "HexThreadPool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ================================================================
+// Направление отсутствует (цель, непроходимая или недостижимая ячейка)
+// ================================================================
+const int8_t HEX_FLOW_NONE = -1;
+
+// ================================================================
+// Поле движения к ближайшей из целей
+// ================================================================
+// Distance( hex ) - стоимость пути от hex до ближайшей цели (сумма
+// стоимостей входа в ячейки пути, как в HexPathfinder),
+// HEX_PATH_BLOCKED - цель недостижима.
+// Direction( hex ) - индекс направления ( HexDirection ) на соседа,
+// через которого проходит кратчайший путь; при равенстве выбирается
+// наименьший индекс, поэтому направления не зависят от порядка
+// вычисления. Функция стоимости cost( hex, index ) та же, что у HexPathfinder
+// ================================================================
+class HexFlowField {
+public:
+    explicit HexFlowField( const HexMapShape& shape ) :
+        distances( shape, HEX_PATH_BLOCKED ), directions( shape, HEX_FLOW_NONE ),
+        heap( shape.Size() ), marks( shape.Size(), 0 ), mark( 0 ) {}
+
+    // Форма карты
+    const HexMapShape& Shape() const { return distances.Shape(); }
+
+    // Расстояние до ближайшей цели (гекс должен принадлежать карте)
+    float Distance( const Hex& hex ) const { return distances[ hex ]; }
+
+    // Направление движения (гекс должен принадлежать карте)
+    int Direction( const Hex& hex ) const { return directions[ hex ]; }
+
+    // Следующий гекс на пути к цели (для целей и недостижимых ячеек - сам гекс)
+    Hex Next( const Hex& hex ) const {
+        const int direction = directions[ hex ];
+        return ( direction == HEX_FLOW_NONE ? hex : hex + HexDirection( direction ) );
+    }
+
+    // Поля расстояний и направлений
+    const HexMap<float>& Distances() const { return distances; }
+    const HexMap<int8_t>& Directions() const { return directions; }
+
+    // Цели
+    const vector<Hex>& Goals() const { return goals; }
+
+    // ================================================================
+    // Полное вычисление поля
+    // ================================================================
+    // Без пула расстояния вычисляются алгоритмом Дейкстры от всех
+    // целей сразу, с пулом - параллельно волнами ( WaveDistances ),
+    // результат тот же. Направления
+    // вычисляются параллельно по строкам карты. Непроходимые цели и
+    // цели вне карты пропускаются
+    // ================================================================
+    template<class CostFunc>
+    void Compute( const vector<Hex>& goals_, CostFunc cost, HexThreadPool* pool = nullptr ) {
+        const HexMapShape& shape = Shape();
+        goals = goals_;
+
+        if ( pool != nullptr ) {
+            WaveDistances( cost, *pool );
+        } else {
+            distances.Fill( HEX_PATH_BLOCKED );
+            heap.Clear();
+
+            for ( const Hex& goal : goals ) {
+                if ( shape.Contains( goal ) && cost( goal, shape.Index( goal ) ) < HEX_PATH_BLOCKED ) {
+                    const uint32_t index = static_cast<uint32_t>( shape.Index( goal ) );
+                    distances.Cell( index ) = 0.0f;
+                    Push( index, goal, 0.0f );
+                }
+            }
+
+            Propagate( cost, false );
+        }
+
+        const auto row_directions = [&]( size_t row, unsigned ) {
+            const int length = static_cast<int>( shape.RowLength( row ) );
+
+            for ( int offset = 0; offset != length; ++offset ) {
+                const Hex hex = shape.RowHex( row, offset );
+                const size_t index = shape.Index( hex );
+                directions.Cell( index ) = BestDirection( hex, index, cost );
+            }
+        };
+
+        if ( pool != nullptr ) {
+            pool->ParallelFor( shape.Rows(), row_directions );
+        } else {
+            for ( size_t row = 0; row != shape.Rows(); ++row ) {
+                row_directions( row, 0 );
+            }
+        }
+    }
+
+    // ================================================================
+    // Пересчёт поля после изменения стоимости ячеек changed
+    // ================================================================
+    // Сбрасываются ячейки, путь которых проходит через изменённые,
+    // затем они заполняются заново от границы сброшенной области;
+    // уменьшение стоимости распространяется от изменённых ячеек.
+    // Результат совпадает с Compute() с теми же целями
+    // ================================================================
+    template<class CostFunc>
+    void Update( const vector<Hex>& changed, CostFunc cost ) {
+        const HexMapShape& shape = Shape();
+        NextMark();
+        heap.Clear();
+        affected.clear();
+
+        // Изменённые ячейки и все ячейки, направления которых ведут через них
+        for ( const Hex& hex : changed ) {
+            if ( shape.Contains( hex ) ) {
+                Affect( static_cast<uint32_t>( shape.Index( hex ) ), hex );
+            }
+        }
+
+        for ( size_t i = 0; i != affected.size(); ++i ) {
+            const Hex hex = affected[ i ].hex;
+
+            for ( int direction = 0; direction != static_cast<int>( HEX_DIRECTION_COUNT ); ++direction ) {
+                const Hex neighbor = hex + HexDirection( direction );
+
+                // Направление соседа указывает на hex
+                if ( shape.Contains( neighbor ) && directions[ neighbor ] == static_cast<int>( AbsDirection( direction + 3 ) ) ) {
+                    Affect( static_cast<uint32_t>( shape.Index( neighbor ) ), neighbor );
+                }
+            }
+        }
+
+        for ( const AffectedCell& cell : affected ) {
+            distances.Cell( cell.index ) = HEX_PATH_BLOCKED;
+        }
+
+        // Цели и граница сброшенной области
+        for ( const Hex& goal : goals ) {
+            if ( shape.Contains( goal ) && IsMarked( static_cast<uint32_t>( shape.Index( goal ) ) )
+                    && cost( goal, shape.Index( goal ) ) < HEX_PATH_BLOCKED ) {
+                distances[ goal ] = 0.0f;
+            }
+        }
+
+        for ( const AffectedCell& cell : affected ) {
+            if ( !( cost( cell.hex, cell.index ) < HEX_PATH_BLOCKED ) ) {
+                continue;
+            }
+
+            float& distance = distances.Cell( cell.index );
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                const Hex neighbor = cell.hex + direction;
+
+                if ( shape.Contains( neighbor ) ) {
+                    const size_t neighbor_index = shape.Index( neighbor );
+                    distance = std::min( distance, distances.Cell( neighbor_index ) + cost( neighbor, neighbor_index ) );
+                }
+            }
+
+            if ( distance < HEX_PATH_BLOCKED ) {
+                Push( cell.index, cell.hex, distance );
+            }
+        }
+
+        // Ячейки с изменённым расстоянием помечаются для пересчёта направлений
+        Propagate( cost, true );
+
+        // Направления пересчитываются у затронутых ячеек и их соседей
+        for ( size_t i = 0, count = affected.size(); i != count; ++i ) {
+            const Hex hex = affected[ i ].hex;
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                const Hex neighbor = hex + direction;
+
+                if ( shape.Contains( neighbor ) ) {
+                    Affect( static_cast<uint32_t>( shape.Index( neighbor ) ), neighbor );
+                }
+            }
+        }
+
+        for ( const AffectedCell& cell : affected ) {
+            directions.Cell( cell.index ) = BestDirection( cell.hex, cell.index, cost );
+        }
+    }
+
+    // ================================================================
+    // Вычисление и пересчёт по карте стоимостей
+    // ================================================================
+    void Compute( const vector<Hex>& goals_, const HexMap<float>& costs, HexThreadPool* pool = nullptr ) {
+        Compute( goals_, [&costs]( const Hex&, size_t index ) { return costs.Cell( index ); }, pool );
+    }
+
+    void Update( const vector<Hex>& changed, const HexMap<float>& costs ) {
+        Update( changed, [&costs]( const Hex&, size_t index ) { return costs.Cell( index ); } );
+    }
+
+private:
+    // Количество ячеек волны, обрабатываемых потоком за одно задание
+    static constexpr size_t WAVE_CHUNK = 256;
+
+    struct AffectedCell {
+        uint32_t index;
+        Hex hex;
+    };
+
+    // Ячейка волны: расстояние на момент улучшения
+    struct WaveCell {
+        uint32_t index;
+        float distance;
+        Hex hex;
+    };
+
+    // ================================================================
+    // Параллельное вычисление расстояний волнами (delta-stepping)
+    // ================================================================
+    // Ячейки с расстоянием не больше порога (ближайшее отложенное
+    // расстояние плюс ширина волны - средняя стоимость проходимой
+    // ячейки) обрабатываются параллельно порциями по WAVE_CHUNK, пока
+    // волна не опустеет; более дальние откладываются до следующей волны.
+    // Расстояния уменьшаются атомарно (неотрицательные float
+    // упорядочены так же, как их биты), ячейка с устаревшим расстоянием
+    // пропускается. Результат - наименьшее по всем путям расстояние,
+    // как у алгоритма Дейкстры, и не зависит от порядка обработки
+    // ================================================================
+    template<class CostFunc>
+    void WaveDistances( CostFunc& cost, HexThreadPool& pool ) {
+        const HexMapShape& shape = Shape();
+        const unsigned threads = pool.ThreadCount();
+
+        if ( wave_distances.size() != shape.Size() ) {
+            wave_distances = vector<std::atomic<uint32_t>>( shape.Size() );
+            wave_costs.resize( shape.Size() );
+        }
+
+        wave_cells.resize( threads );
+
+        // Стоимости входа в ячейки и средняя стоимость проходимой ячейки
+        vector<double> cost_sums( threads, 0.0 );
+        vector<size_t> cost_counts( threads, 0 );
+
+        pool.ParallelFor( shape.Rows(), [&]( size_t row, unsigned thread ) {
+            const int length = static_cast<int>( shape.RowLength( row ) );
+            double sum = 0.0;
+            size_t count = 0;
+
+            for ( int offset = 0; offset != length; ++offset ) {
+                const Hex hex = shape.RowHex( row, offset );
+                const size_t index = shape.Index( hex );
+                const float step = cost( hex, index );
+                wave_costs[ index ] = step;
+                wave_distances[ index ].store( WaveBits( HEX_PATH_BLOCKED ), std::memory_order_relaxed );
+
+                if ( step < HEX_PATH_BLOCKED ) {
+                    sum += step;
+                    ++count;
+                }
+            }
+
+            cost_sums[ thread ] += sum;
+            cost_counts[ thread ] += count;
+        } );
+
+        double sum = 0.0;
+        size_t count = 0;
+
+        for ( unsigned thread = 0; thread != threads; ++thread ) {
+            sum += cost_sums[ thread ];
+            count += cost_counts[ thread ];
+        }
+
+        const float width = ( count != 0 && sum > 0.0 ? static_cast<float>( sum / count ) : 1.0f );
+        wave.clear();
+        wave_far.clear();
+
+        for ( const Hex& goal : goals ) {
+            if ( shape.Contains( goal ) && wave_costs[ shape.Index( goal ) ] < HEX_PATH_BLOCKED ) {
+                const uint32_t index = static_cast<uint32_t>( shape.Index( goal ) );
+                wave_distances[ index ].store( WaveBits( 0.0f ), std::memory_order_relaxed );
+                wave.push_back( { index, 0.0f, goal } );
+            }
+        }
+
+        float threshold = width;
+
+        for ( ;; ) {
+            while ( !wave.empty() ) {
+                pool.ParallelFor( ( wave.size() + WAVE_CHUNK - 1 ) / WAVE_CHUNK, [&]( size_t chunk, unsigned thread ) {
+                    const size_t end = std::min( ( chunk + 1 ) * WAVE_CHUNK, wave.size() );
+
+                    for ( size_t i = chunk * WAVE_CHUNK; i != end; ++i ) {
+                        RelaxWave( wave[ i ], wave_cells[ thread ] );
+                    }
+                } );
+
+                wave.clear();
+
+                for ( vector<WaveCell>& cells : wave_cells ) {
+                    for ( const WaveCell& cell : cells ) {
+                        ( cell.distance <= threshold ? wave : wave_far ).push_back( cell );
+                    }
+
+                    cells.clear();
+                }
+            }
+
+            // Следующая волна: от ближайшей из отложенных ячеек
+            float nearest = HEX_PATH_BLOCKED;
+            size_t kept = 0;
+
+            for ( const WaveCell& cell : wave_far ) {
+                if ( IsWaveCurrent( cell ) ) {
+                    wave_far[ kept++ ] = cell;
+                    nearest = std::min( nearest, cell.distance );
+                }
+            }
+
+            wave_far.resize( kept );
+
+            if ( wave_far.empty() ) {
+                break;
+            }
+
+            threshold = nearest + width;
+            kept = 0;
+
+            for ( const WaveCell& cell : wave_far ) {
+                if ( cell.distance <= threshold ) {
+                    wave.push_back( cell );
+                } else {
+                    wave_far[ kept++ ] = cell;
+                }
+            }
+
+            wave_far.resize( kept );
+        }
+
+        pool.ParallelFor( ( shape.Size() + WAVE_CHUNK - 1 ) / WAVE_CHUNK, [&]( size_t chunk, unsigned ) {
+            const size_t end = std::min( ( chunk + 1 ) * WAVE_CHUNK, shape.Size() );
+
+            for ( size_t index = chunk * WAVE_CHUNK; index != end; ++index ) {
+                distances.Cell( index ) = WaveFloat( wave_distances[ index ].load( std::memory_order_relaxed ) );
+            }
+        } );
+    }
+
+    // Обновление соседей ячейки волны, улучшенные соседи добавляются в cells
+    void RelaxWave( const WaveCell& cell, vector<WaveCell>& cells ) {
+        if ( !IsWaveCurrent( cell ) ) {
+            return;
+        }
+
+        const HexMapShape& shape = Shape();
+        const float step = cell.distance + wave_costs[ cell.index ];
+        const uint32_t step_bits = WaveBits( step );
+
+        for ( const Hex& direction : HEX_DIRECTIONS ) {
+            const Hex neighbor = cell.hex + direction;
+
+            if ( !shape.Contains( neighbor ) ) {
+                continue;
+            }
+
+            const uint32_t neighbor_index = static_cast<uint32_t>( shape.Index( neighbor ) );
+
+            if ( !( wave_costs[ neighbor_index ] < HEX_PATH_BLOCKED ) ) {
+                continue;
+            }
+
+            std::atomic<uint32_t>& neighbor_distance = wave_distances[ neighbor_index ];
+            uint32_t current = neighbor_distance.load( std::memory_order_relaxed );
+
+            while ( step_bits < current ) {
+                if ( neighbor_distance.compare_exchange_weak( current, step_bits, std::memory_order_relaxed ) ) {
+                    cells.push_back( { neighbor_index, step, neighbor } );
+                    break;
+                }
+            }
+        }
+    }
+
+    // Расстояние ячейки волны не уменьшилось после её добавления
+    bool IsWaveCurrent( const WaveCell& cell ) const {
+        return wave_distances[ cell.index ].load( std::memory_order_relaxed ) == WaveBits( cell.distance );
+    }
+
+    static uint32_t WaveBits( float value ) {
+        uint32_t bits;
+        std::memcpy( &bits, &value, sizeof( bits ) );
+        return bits;
+    }
+
+    static float WaveFloat( uint32_t bits ) {
+        float value;
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return value;
+    }
+
+    // ================================================================
+    // Алгоритм Дейкстры от ячеек в куче (обратные рёбра: из ячейки в
+    // соседа за стоимость входа в ячейку); track_changes - извлечённые
+    // ячейки добавляются в список затронутых
+    // ================================================================
+    template<class CostFunc>
+    void Propagate( CostFunc& cost, bool track_changes ) {
+        const HexMapShape& shape = Shape();
+
+        while ( !heap.Empty() ) {
+            const float distance = heap.TopKey();
+            const Hex hex = heap.TopHex();
+            const uint32_t index = heap.Pop();
+
+            if ( track_changes ) {
+                Affect( index, hex );
+            }
+
+            const float step = distance + cost( hex, index );
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                const Hex neighbor = hex + direction;
+
+                if ( !shape.Contains( neighbor ) ) {
+                    continue;
+                }
+
+                const uint32_t neighbor_index = static_cast<uint32_t>( shape.Index( neighbor ) );
+                float& neighbor_distance = distances.Cell( neighbor_index );
+
+                if ( step < neighbor_distance && cost( neighbor, neighbor_index ) < HEX_PATH_BLOCKED ) {
+                    neighbor_distance = step;
+                    Push( neighbor_index, neighbor, step );
+                }
+            }
+        }
+    }
+
+    // Добавление ячейки в кучу или уменьшение её ключа
+    void Push( uint32_t index, const Hex& hex, float distance ) {
+        heap.PushOrDecrease( index, distance, hex );
+    }
+
+    // Наилучшее направление ячейки
+    template<class CostFunc>
+    int8_t BestDirection( const Hex& hex, size_t index, CostFunc& cost ) const {
+        const float distance = distances.Cell( index );
+
+        if ( distance == 0.0f || !( distance < HEX_PATH_BLOCKED ) ) {
+            return HEX_FLOW_NONE;
+        }
+
+        const HexMapShape& shape = Shape();
+        int8_t best = HEX_FLOW_NONE;
+        float best_distance = HEX_PATH_BLOCKED;
+
+        for ( int direction = 0; direction != static_cast<int>( HEX_DIRECTION_COUNT ); ++direction ) {
+            const Hex neighbor = hex + HexDirection( direction );
+
+            if ( shape.Contains( neighbor ) ) {
+                const size_t neighbor_index = shape.Index( neighbor );
+                const float neighbor_distance = distances.Cell( neighbor_index );
+
+                if ( neighbor_distance < HEX_PATH_BLOCKED ) {
+                    const float through = neighbor_distance + cost( neighbor, neighbor_index );
+
+                    if ( through < best_distance ) {
+                        best_distance = through;
+                        best = static_cast<int8_t>( direction );
+                    }
+                }
+            }
+        }
+
+        return best;
+    }
+
+    // Добавление ячейки в список затронутых (один раз за пересчёт)
+    void Affect( uint32_t index, const Hex& hex ) {
+        if ( marks[ index ] != mark ) {
+            marks[ index ] = mark;
+            affected.push_back( { index, hex } );
+        }
+    }
+
+    bool IsMarked( uint32_t index ) const { return marks[ index ] == mark; }
+
+    void NextMark() {
+        if ( ++mark == 0 ) {
+            std::fill( marks.begin(), marks.end(), 0 );
+            mark = 1;
+        }
+    }
+
+    // Поля расстояний и направлений
+    HexMap<float> distances;
+    HexMap<int8_t> directions;
+
+    // Цели
+    vector<Hex> goals;
+
+    // Рабочие данные вычисления
+    HexIndexedHeap heap;
+    vector<uint32_t> marks;
+    uint32_t mark;
+    vector<AffectedCell> affected;
+
+    // Рабочие данные параллельного вычисления (выделяются при первом вызове с пулом):
+    // расстояния (биты float), стоимости входа, текущая волна, отложенные ячейки,
+    // улучшенные ячейки каждого потока
+    vector<std::atomic<uint32_t>> wave_distances;
+    vector<float> wave_costs;
+    vector<WaveCell> wave;
+    vector<WaveCell> wave_far;
+    vector<vector<WaveCell>> wave_cells;
+};
+
+#endif // HEXFLOWFIELD_H
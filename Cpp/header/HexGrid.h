@@ -8,24 +8,54 @@
 #ifndef HEXGRID_H
 #define HEXGRID_H
 
+#include <array>
 #include <cmath>
-#include <map>
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
-using std::map;
+using std::array;
 using std::ostream;
 using std::vector;
 
 // ================================================================
-// Случайный выбор алгоритма округления (0 = отключить)
+// Случайный выбор алгоритма округления по умолчанию (0 = отключить)
 // ================================================================
-#define HEX_ROUND_ALGORITHM_RANDOM 1
+// Генератор свой у каждого потока, см. HexRoundSeed()
+// ================================================================
+#ifndef HEX_ROUND_ALGORITHM_RANDOM
+#define HEX_ROUND_ALGORITHM_RANDOM 0
+#endif
 
 // ================================================================
 // Установить конкретный алгоритм округления (значение 0..2)
 // ================================================================
+#ifndef HEX_ROUND_ALGORITHM
 #define HEX_ROUND_ALGORITHM 0
+#endif
+
+// ================================================================
+// Начальное значение генератора алгоритма округления
+// ================================================================
+#ifndef HEX_ROUND_SEED
+#define HEX_ROUND_SEED 1
+#endif
+
+// ================================================================
+// Алгоритм округления кубических координат
+// ================================================================
+// Определяет, какая координата пересчитывается при равных дельтах
+// HEX_ROUND_Q, HEX_ROUND_R, HEX_ROUND_S = Фиксированный алгоритм
+// HEX_ROUND_DEFAULT = Алгоритм по умолчанию (HEX_ROUND_ALGORITHM / HEX_ROUND_ALGORITHM_RANDOM)
+// HEX_ROUND_RANDOM = Случайный алгоритм (генератор потока)
+// ================================================================
+enum HexRoundAlgorithm_t {
+    HEX_ROUND_RANDOM = -2,
+    HEX_ROUND_DEFAULT = -1,
+    HEX_ROUND_Q = 0,
+    HEX_ROUND_R = 1,
+    HEX_ROUND_S = 2
+};
 
 // ================================================================
 // Тип офсетной системы
@@ -49,30 +79,72 @@ enum HexOrientation_t {
     HEX_ORIENTATION_POINTY = 1
 };
 
+// ================================================================
+// Корень из трёх
+// ================================================================
+constexpr long double HEX_SQRT3 = 1.732050807568877293527446341505872367L;
+
 // ================================================================
 // Матрица для преобразования координат гекса в координаты на плоскости
 // ================================================================
-const map<HexOrientation_t, vector<double>> HEX_ORIENTATION_MATRIX_1 = {
-    { HEX_ORIENTATION_FLAT, { 1.5L, 0.0L, 0.5L * sqrt( 3.0L ), sqrt( 3.0L ) } },
-    { HEX_ORIENTATION_POINTY, { sqrt( 3.0L ), 0.5L * sqrt( 3.0L ), 0.0L, 1.5L } }
+// Индекс строки - ориентация гекса (HexOrientation_t)
+// ================================================================
+constexpr double HEX_ORIENTATION_MATRIX_1[ 2 ][ 4 ] = {
+    { 1.5L, 0.0L, 0.5L * HEX_SQRT3, HEX_SQRT3 },        // HEX_ORIENTATION_FLAT
+    { HEX_SQRT3, 0.5L * HEX_SQRT3, 0.0L, 1.5L }         // HEX_ORIENTATION_POINTY
 };
 
 // ================================================================
 // Матрица для преобразования координат на плоскости в координаты гекса
 // ================================================================
-const map<HexOrientation_t, vector<double>> HEX_ORIENTATION_MATRIX_2 = {
-    { HEX_ORIENTATION_FLAT, { 2.0L / 3.0L, 0.0L, -1.0L / 3.0L, sqrt( 3.0L ) / 3.0L } },
-    { HEX_ORIENTATION_POINTY, { sqrt( 3.0L ) / 3.0L,  -1.0L / 3.0L, 0.0L, 2.0L / 3.0L } }
+// Индекс строки - ориентация гекса (HexOrientation_t)
+// ================================================================
+constexpr double HEX_ORIENTATION_MATRIX_2[ 2 ][ 4 ] = {
+    { 2.0L / 3.0L, 0.0L, -1.0L / 3.0L, HEX_SQRT3 / 3.0L }, // HEX_ORIENTATION_FLAT
+    { HEX_SQRT3 / 3.0L, -1.0L / 3.0L, 0.0L, 2.0L / 3.0L }  // HEX_ORIENTATION_POINTY
+};
+
+// ================================================================
+// Количество направлений
+// ================================================================
+const unsigned HEX_DIRECTION_COUNT = 6;
+
+// ================================================================
+// Количество углов гекса
+// ================================================================
+const unsigned HEX_CORNER_COUNT = 6;
+
+// ================================================================
+// Точка на плоскости
+// ================================================================
+class Point {
+public:
+    constexpr Point() : x( 0 ), y( 0 ) {}
+    constexpr Point( double x_, double y_ ) : x( x_ ), y( y_ ) {}
+    double x;
+    double y;
+};
+
+// ================================================================
+// Ребро многоугольника гекса: точки ( x, y ) относительно центра
+// с a * x + b * y <= c лежат по внутреннюю сторону ребра
+// ================================================================
+struct HexEdge {
+    double a;
+    double b;
+    double c;
 };
 
 // ================================================================
 // Расположение гексов на плоскости
 // ================================================================
+// Коэффициенты преобразований и многоугольник гекса (смещения углов,
+// границы, рёбра) вычисляются один раз при создании, поэтому углы
+// гекса - сложение центра со смещениями без cos / sin
+// ================================================================
 class HexLayout {
 public:
-    HexLayout( HexOrientation_t orientation_, OffsetType_t offset_type_, Point size_, Point origin_ ) :
-        orientation( orientation_ ), offset_type( offset_type_ ), size( size_ ), origin( origin_ ),
-        start_angle( ( orientation_ == HEX_ORIENTATION_POINTY ? 0.5L : 0.0L ) ) {}
+    HexLayout( HexOrientation_t orientation_, OffsetType_t offset_type_, Point size_, Point origin_ );
 
     // Ориентация гекса на плоскости
     const HexOrientation_t orientation;
@@ -89,27 +161,40 @@ public:
     // Начальный угол
     const double start_angle;
 
+    // Матрицы преобразования координат гекса в координаты на плоскости и обратно
+    const array<double, 4> forward;
+    const array<double, 4> inverse;
+
+    // ================================================================
+    // Шаблон многоугольника гекса на плоскости (относительно центра)
+    // ================================================================
+    // corners - смещения углов ( HexCorner( layout, i ) - центр ),
+    // bounds_min / bounds_max - ограничивающий прямоугольник,
+    // edges[ i ] - ребро от угла i к углу i + 1
+    // ================================================================
+    const array<Point, HEX_CORNER_COUNT> corners;
+    const Point bounds_min;
+    const Point bounds_max;
+    const array<HexEdge, HEX_CORNER_COUNT> edges;
+
     // Коэффициенты для преобразования координат гекса в координаты на плоскости
-    inline double QX() const { return HEX_ORIENTATION_MATRIX_1.at( orientation )[0]; }
-    inline double RX() const { return HEX_ORIENTATION_MATRIX_1.at( orientation )[1]; }
-    inline double QY() const { return HEX_ORIENTATION_MATRIX_1.at( orientation )[2]; }
-    inline double RY() const { return HEX_ORIENTATION_MATRIX_1.at( orientation )[3]; }
+    inline double QX() const { return forward[ 0 ]; }
+    inline double RX() const { return forward[ 1 ]; }
+    inline double QY() const { return forward[ 2 ]; }
+    inline double RY() const { return forward[ 3 ]; }
 
     // Коэффициенты для преобразования координат на плоскости в координаты гекса
-    inline double XQ() const { return HEX_ORIENTATION_MATRIX_2.at( orientation )[0]; }
-    inline double YQ() const { return HEX_ORIENTATION_MATRIX_2.at( orientation )[1]; }
-    inline double XR() const { return HEX_ORIENTATION_MATRIX_2.at( orientation )[2]; }
-    inline double YR() const { return HEX_ORIENTATION_MATRIX_2.at( orientation )[3]; }
-};
-
-// ================================================================
-// Точка на плоскости
-// ================================================================
-class Point {
-public:
-    Point( double x_, double y_ ) : x( x_ ), y( y_ ) {}
-    const double x;
-    const double y;
+    inline double XQ() const { return inverse[ 0 ]; }
+    inline double YQ() const { return inverse[ 1 ]; }
+    inline double XR() const { return inverse[ 2 ]; }
+    inline double YR() const { return inverse[ 3 ]; }
+
+    // ================================================================
+    // Отрезок строки развёртки: пересечение гекса с горизонталью dy
+    // (относительно центра) - [ x_min, x_max ] относительно центра,
+    // false - горизонталь не пересекает гекс
+    // ================================================================
+    bool RowSpan( double dy, double& x_min, double& x_max ) const;
 };
 
 // ================================================================
@@ -127,9 +212,9 @@ ostream& operator <<( ostream& os, const Point& right );
 // ================================================================
 class OffsetHex {
 public:
-    OffsetHex( int col_, int row_ ) : col( col_ ), row( row_ ) {}
-    const int col;
-    const int row;
+    constexpr OffsetHex( int col_, int row_ ) : col( col_ ), row( row_ ) {}
+    int col;
+    int row;
 };
 
 // ================================================================
@@ -142,25 +227,32 @@ ostream& operator <<( ostream& os, const OffsetHex& right );
 // ================================================================
 // Гекс (Кубические координаты)
 // ================================================================
+// Методы, возвращающие vector, выделяют память при каждом вызове;
+// для циклов - варианты с массивом результата ( out ) или array
+// ================================================================
 class Hex {
 public:
-    Hex( int q_, int r_ ) : coord( { q_, r_, -q_ - r_ } ) {}
-    inline int Q( void ) const { return coord[ 0 ]; }
-    inline int R( void ) const { return coord[ 1 ]; }
-    inline int S( void ) const { return coord[ 2 ]; }
-    const vector<int> coord;
+    constexpr Hex() : coord{ 0, 0, 0 } {}
+    constexpr Hex( int q_, int r_ ) : coord{ q_, r_, -q_ - r_ } {}
+    constexpr int Q( void ) const { return coord[ 0 ]; }
+    constexpr int R( void ) const { return coord[ 1 ]; }
+    constexpr int S( void ) const { return coord[ 2 ]; }
 
     // Соседний гекс
     Hex HexNeighbor( int direction ) const;
 
     // Соседние гексы
     vector<Hex> HexNeighbors() const;
+    void HexNeighbors( Hex* out ) const;
+    array<Hex, HEX_DIRECTION_COUNT> HexNeighborsArray() const;
 
     // Диагональный гекс
     Hex HexDiagonal( int direction ) const;
 
     // Диагональные гексы
     vector<Hex> HexDiagonals() const;
+    void HexDiagonals( Hex* out ) const;
+    array<Hex, HEX_DIRECTION_COUNT> HexDiagonalsArray() const;
 
     // Координаты гекса => Координаты на плоскости (координаты центра)
     Point HexToPixel( const HexLayout& layout ) const;
@@ -170,22 +262,43 @@ public:
 
     // Углы гекса на плоскости
     vector<Point> HexCorners( const HexLayout& layout ) const;
+    void HexCorners( const HexLayout& layout, Point* out ) const;
+    array<Point, HEX_CORNER_COUNT> HexCornersArray( const HexLayout& layout ) const;
 
     // Поворот гекса влево
     Hex HexRotateLeft() const;
 
     // Поворот гекса вправо
     Hex HexRotateRight() const;
+
+private:
+    // Координаты ( q + r + s = 0 ): изменяются только конструкторами и присваиванием
+    array<int, 3> coord;
 };
 
 // ================================================================
 // Операции над кубическими координатами
 // ================================================================
-bool operator ==( const Hex& left, const Hex& right );
-bool operator !=( const Hex& left, const Hex& right );
-Hex operator +( const Hex& left, const Hex& right );
-Hex operator -( const Hex& left, const Hex& right );
-Hex operator *( const Hex& left, int right );
+constexpr bool operator ==( const Hex& left, const Hex& right ) {
+    return ( left.Q() == right.Q() && left.R() == right.R() );
+}
+
+constexpr bool operator !=( const Hex& left, const Hex& right ) {
+    return ( left.Q() != right.Q() || left.R() != right.R() );
+}
+
+constexpr Hex operator +( const Hex& left, const Hex& right ) {
+    return Hex( left.Q() + right.Q(), left.R() + right.R() );
+}
+
+constexpr Hex operator -( const Hex& left, const Hex& right ) {
+    return Hex( left.Q() - right.Q(), left.R() - right.R() );
+}
+
+constexpr Hex operator *( const Hex& left, int right ) {
+    return Hex( left.Q() * right, left.R() * right );
+}
+
 ostream& operator <<( ostream& os, const Hex& right );
 
 // ================================================================
@@ -193,17 +306,155 @@ ostream& operator <<( ostream& os, const Hex& right );
 // ================================================================
 class FractionalHex {
 public:
-    FractionalHex( double q_, double r_ ) : coord( { q_, r_, -q_ - r_ } ) {}
+    constexpr FractionalHex( double q_, double r_ ) : coord{ q_, r_, -q_ - r_ } {}
     FractionalHex( double q_, double r_, double s_ );
-    inline double Q( void ) const { return coord[ 0 ]; }
-    inline double R( void ) const { return coord[ 1 ]; }
-    inline double S( void ) const { return coord[ 2 ]; }
-    const vector<double> coord;
+    constexpr double Q( void ) const { return coord[ 0 ]; }
+    constexpr double R( void ) const { return coord[ 1 ]; }
+    constexpr double S( void ) const { return coord[ 2 ]; }
 
-    // Округление дробных координат
+    // Округление дробных координат (см. HexRoundAlgorithm_t)
     Hex Round( int round_algorithm ) const;
+
+private:
+    array<double, 3> coord;
 };
 
+// ================================================================
+// Координаты хранятся по значению: копирование без выделения памяти
+// ================================================================
+static_assert( std::is_trivially_copyable<Point>::value, "Point must be trivially copyable" );
+static_assert( std::is_trivially_copyable<OffsetHex>::value, "OffsetHex must be trivially copyable" );
+static_assert( std::is_trivially_copyable<Hex>::value, "Hex must be trivially copyable" );
+static_assert( std::is_trivially_copyable<FractionalHex>::value, "FractionalHex must be trivially copyable" );
+
+// ================================================================
+// Офсетные координаты -> Кубические координаты
+// ================================================================
+// Ориентация гекса на плоскости "Плоский" (HEX_ORIENTATION_FLAT)
+// ================================================================
+constexpr Hex Q_Offset_to_Cube( OffsetType_t offset_type, const OffsetHex& offset ) {
+    return Hex( offset.col, offset.row - ( offset.col + static_cast<int>( offset_type ) * ( offset.col & 1 ) ) / 2 );
+}
+
+// ================================================================
+// Офсетные координаты -> Кубические координаты
+// ================================================================
+// Ориентация гекса на плоскости "Заострённый" (HEX_ORIENTATION_POINTY)
+// ================================================================
+constexpr Hex R_Offset_to_Cube( OffsetType_t offset_type, const OffsetHex& offset ) {
+    return Hex( offset.col - ( offset.row + static_cast<int>( offset_type ) * ( offset.row & 1 ) ) / 2, offset.row );
+}
+
+// ================================================================
+// Кубические координаты -> Офсетные координаты
+// ================================================================
+// Ориентация гекса на плоскости "Плоский" (HEX_ORIENTATION_FLAT)
+// ================================================================
+constexpr OffsetHex Cube_to_Offset_Q( OffsetType_t offset_type, const Hex& hex ) {
+    return OffsetHex( hex.Q(), hex.R() + ( hex.Q() + static_cast<int>( offset_type ) * ( hex.Q() & 1 ) ) / 2 );
+}
+
+// ================================================================
+// Кубические координаты -> Офсетные координаты
+// ================================================================
+// Ориентация гекса на плоскости "Заострённый" (HEX_ORIENTATION_POINTY)
+// ================================================================
+constexpr OffsetHex Cube_to_Offset_R( OffsetType_t offset_type, const Hex& hex ) {
+    return OffsetHex( hex.Q() + ( hex.R() + static_cast<int>( offset_type ) * ( hex.R() & 1 ) ) / 2, hex.R() );
+}
+
+// ================================================================
+// Расположение гексов на плоскости (известное на этапе компиляции)
+// ================================================================
+// Коэффициенты матриц - константы, поэтому преобразования
+// сводятся к нескольким умножениям и сложениям без обращений к таблицам
+// ================================================================
+template<HexOrientation_t orientation_, OffsetType_t offset_type_>
+class StaticHexLayout {
+public:
+    constexpr StaticHexLayout( Point size_, Point origin_ ) : size( size_ ), origin( origin_ ) {}
+
+    // Ориентация гекса на плоскости
+    static constexpr HexOrientation_t orientation = orientation_;
+
+    // Используемая офсетная система
+    static constexpr OffsetType_t offset_type = offset_type_;
+
+    // Начальный угол
+    static constexpr double start_angle = ( orientation_ == HEX_ORIENTATION_POINTY ? 0.5L : 0.0L );
+
+    // Размеры гекса
+    const Point size;
+
+    // Начало плоскости
+    const Point origin;
+
+    // Коэффициенты для преобразования координат гекса в координаты на плоскости
+    static constexpr double QX() { return HEX_ORIENTATION_MATRIX_1[ orientation_ ][ 0 ]; }
+    static constexpr double RX() { return HEX_ORIENTATION_MATRIX_1[ orientation_ ][ 1 ]; }
+    static constexpr double QY() { return HEX_ORIENTATION_MATRIX_1[ orientation_ ][ 2 ]; }
+    static constexpr double RY() { return HEX_ORIENTATION_MATRIX_1[ orientation_ ][ 3 ]; }
+
+    // Коэффициенты для преобразования координат на плоскости в координаты гекса
+    static constexpr double XQ() { return HEX_ORIENTATION_MATRIX_2[ orientation_ ][ 0 ]; }
+    static constexpr double YQ() { return HEX_ORIENTATION_MATRIX_2[ orientation_ ][ 1 ]; }
+    static constexpr double XR() { return HEX_ORIENTATION_MATRIX_2[ orientation_ ][ 2 ]; }
+    static constexpr double YR() { return HEX_ORIENTATION_MATRIX_2[ orientation_ ][ 3 ]; }
+
+    // Координаты гекса => Координаты на плоскости (координаты центра)
+    constexpr Point HexToPixel( const Hex& hex ) const {
+        return Point( ( QX() * hex.Q() + RX() * hex.R() ) * size.x + origin.x,
+                      ( QY() * hex.Q() + RY() * hex.R() ) * size.y + origin.y );
+    }
+
+    // Координаты на плоскости => Координаты гекса
+    constexpr FractionalHex PixelToHex( const Point& pixel ) const {
+        const double x = ( pixel.x - origin.x ) / size.x;
+        const double y = ( pixel.y - origin.y ) / size.y;
+        return FractionalHex( XQ() * x + YQ() * y, XR() * x + YR() * y );
+    }
+
+    // Офсетные координаты -> Кубические координаты
+    constexpr Hex Offset_to_Cube( const OffsetHex& offset ) const {
+        return ( orientation_ == HEX_ORIENTATION_FLAT ? Q_Offset_to_Cube( offset_type_, offset )
+                                                      : R_Offset_to_Cube( offset_type_, offset ) );
+    }
+
+    // Кубические координаты -> Офсетные координаты
+    constexpr OffsetHex Cube_to_Offset( const Hex& hex ) const {
+        return ( orientation_ == HEX_ORIENTATION_FLAT ? Cube_to_Offset_Q( offset_type_, hex )
+                                                      : Cube_to_Offset_R( offset_type_, hex ) );
+    }
+};
+
+using HexLayoutFlatOdd = StaticHexLayout<HEX_ORIENTATION_FLAT, OFFSET_TYPE_ODD>;
+using HexLayoutFlatEven = StaticHexLayout<HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN>;
+using HexLayoutPointyOdd = StaticHexLayout<HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD>;
+using HexLayoutPointyEven = StaticHexLayout<HEX_ORIENTATION_POINTY, OFFSET_TYPE_EVEN>;
+
+// ================================================================
+// Вызов func( static_layout ) с расположением, известным на этапе компиляции
+// ================================================================
+// Выбор специализации выполняется один раз, поэтому внутри func
+// (например, в цикле по массиву гексов) ветвлений по ориентации нет
+// ================================================================
+template<class Func>
+inline auto HexLayoutDispatch( const HexLayout& layout, Func&& func ) {
+    if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
+        if ( layout.offset_type == OFFSET_TYPE_ODD ) {
+            return func( HexLayoutFlatOdd( layout.size, layout.origin ) );
+        } else {
+            return func( HexLayoutFlatEven( layout.size, layout.origin ) );
+        }
+    } else {
+        if ( layout.offset_type == OFFSET_TYPE_ODD ) {
+            return func( HexLayoutPointyOdd( layout.size, layout.origin ) );
+        } else {
+            return func( HexLayoutPointyEven( layout.size, layout.origin ) );
+        }
+    }
+}
+
 // ================================================================
 // Расстояние в гексах
 // ================================================================
@@ -213,16 +464,48 @@ inline unsigned HexDistance( const Hex& hex_a, const Hex& hex_b ) {
              + abs( hex_a.S() - hex_b.S() ) ) / 2.0L;
 }
 
+// ================================================================
+// Список направлений
+// ================================================================
+constexpr Hex HEX_DIRECTIONS[ HEX_DIRECTION_COUNT ] = {
+    Hex( 1, 0 ),
+    Hex( 1, -1 ),
+    Hex( 0, -1 ),
+    Hex( -1, 0 ),
+    Hex( -1, 1 ),
+    Hex( 0, 1 )
+};
+
+// ================================================================
+// Направление по модулю
+// ================================================================
+constexpr unsigned AbsDirection( int direction ) {
+    direction %= static_cast<int>( HEX_DIRECTION_COUNT );
+    return ( direction < 0 ? direction + HEX_DIRECTION_COUNT : direction );
+}
+
 // ================================================================
 // Направление
 // ================================================================
-const Hex& HexDirection( int direction );
+constexpr const Hex& HexDirection( int direction ) {
+    return HEX_DIRECTIONS[ AbsDirection( direction ) ];
+}
+
+// ================================================================
+// Угол гекса на плоскости (смещение относительно центра гекса)
+// ================================================================
+Point HexCornerBase( const HexLayout& layout, int corner );
 
 // ================================================================
 // Координаты на плоскости => Координаты гекса
 // ================================================================
 FractionalHex PixelToHex( const HexLayout& layout, const Point& pixel );
 
+template<HexOrientation_t orientation_, OffsetType_t offset_type_>
+constexpr FractionalHex PixelToHex( const StaticHexLayout<orientation_, offset_type_>& layout, const Point& pixel ) {
+    return layout.PixelToHex( pixel );
+}
+
 // ================================================================
 // Линейная интерполяция (Кубические координаты)
 // ================================================================
@@ -233,10 +516,42 @@ FractionalHex HexLinearInterpolation( const Hex& hex_a, const Hex& hex_b, double
 // ================================================================
 FractionalHex HexLinearInterpolation( const FractionalHex& hex_a, const FractionalHex& hex_b, double t );
 
+// ================================================================
+// Выбор алгоритма округления кубических координат
+// ================================================================
+// Для отрицательных значений возвращает конкретный алгоритм (0..2)
+// ================================================================
+int HexRoundAlgorithm( int round_algorithm = HEX_ROUND_DEFAULT );
+
+// ================================================================
+// Инициализация генератора алгоритма округления текущего потока
+// ================================================================
+void HexRoundSeed( unsigned seed );
+
 // ================================================================
 // Линия гексов
 // ================================================================
-vector<Hex> HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range );
+// Алгоритм округления выбирается один раз на всю линию
+// ================================================================
+vector<Hex> HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range,
+                     int round_algorithm = HEX_ROUND_DEFAULT );
+
+// ================================================================
+// Количество гексов линии ( HexLine )
+// ================================================================
+unsigned HexLineSize( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range );
+
+// ================================================================
+// Линия гексов без выделения памяти
+// ================================================================
+// out - массив не меньше HexLineSize( hex_a, hex_b, use_range, range ),
+// возвращается количество гексов. line - буфер, который очищается
+// и заполняется; память выделяется, только если его ёмкости мало
+// ================================================================
+size_t HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, Hex* out,
+                int round_algorithm = HEX_ROUND_DEFAULT );
+void HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, vector<Hex>& line,
+              int round_algorithm = HEX_ROUND_DEFAULT );
 
 // ================================================================
 // Офсетные координаты -> Кубические координаты
@@ -0,0 +1,170 @@
+/*
+ * HexHierarchicalPathfinder.h
+ *
+ * Иерархический поиск пути по укрупнённому уровню HexHierarchy
+ */
+
+#pragma once
+#ifndef HEXHIERARCHICALPATHFINDER_H
+#define HEXHIERARCHICALPATHFINDER_H
+
+#include "HexGrid.h"
+#include "HexHierarchy.h"
+#include "HexMap.h"
+#include "HexPathfinder.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// ================================================================
+// Иерархический поиск пути
+// ================================================================
+// Сначала путь ищется на уровне level иерархии: стоимость входа в
+// укрупнённую ячейку - средняя стоимость её проходимых ячеек,
+// умноженная на sqrt( 7 )^level (расстояние между центрами соседних
+// укрупнённых ячеек); ячейка без проходимых ячеек непроходима.
+// Затем путь ищется на исходной карте внутри коридора из ячеек
+// укрупнённого пути и их соседей. Если в коридоре путь не найден,
+// выполняется поиск по всей карте, поэтому путь находится всегда,
+// когда он существует, но может быть дороже кратчайшего.
+// Агрегаты стоимостей обновляются пошагово ( Update )
+// ================================================================
+class HexHierarchicalPathfinder {
+public:
+    HexHierarchicalPathfinder( const HexHierarchy& hierarchy_, int level_, float min_cost_ = 1.0f ) :
+        hierarchy( hierarchy_ ), level( level_ ), scale( std::pow( std::sqrt( 7.0f ), static_cast<float>( level_ ) ) ),
+        fine( hierarchy_.Shape( 0 ), min_cost_ ), coarse( hierarchy_.Shape( level_ ), min_cost_ * scale ),
+        cost_sums( hierarchy_, HEX_AGGREGATE_SUM ), passable( hierarchy_, HEX_AGGREGATE_SUM ),
+        ancestors( hierarchy_.Shape( 0 ).Size() ), corridor( hierarchy_.Shape( level_ ).Size(), 0 ), stamp( 0 ) {
+        for ( size_t index = 0; index != ancestors.size(); ++index ) {
+            ancestors[ index ] = hierarchy.Ancestor( index, level );
+        }
+    }
+
+    // Уровень укрупнённого поиска
+    int Level() const { return level; }
+
+    // ================================================================
+    // Полное вычисление агрегатов по карте стоимостей
+    // ================================================================
+    void Build( const HexMap<float>& costs ) {
+        HexMap<float> sums( costs.Shape() );
+        HexMap<uint32_t> counts( costs.Shape() );
+
+        for ( size_t index = 0; index != costs.Size(); ++index ) {
+            const bool open = ( costs.Cell( index ) < HEX_PATH_BLOCKED );
+            sums.Cell( index ) = ( open ? costs.Cell( index ) : 0.0f );
+            counts.Cell( index ) = ( open ? 1 : 0 );
+        }
+
+        cost_sums.Build( sums );
+        passable.Build( counts );
+    }
+
+    // ================================================================
+    // Пересчёт агрегатов после изменения стоимости ячеек changed
+    // ================================================================
+    void Update( const vector<Hex>& changed, const HexMap<float>& costs ) {
+        for ( const Hex& hex : changed ) {
+            if ( costs.Contains( hex ) ) {
+                const size_t index = costs.Index( hex );
+                const bool open = ( costs.Cell( index ) < HEX_PATH_BLOCKED );
+                cost_sums.Set( index, ( open ? costs.Cell( index ) : 0.0f ) );
+                passable.Set( index, ( open ? 1U : 0U ) );
+            }
+        }
+    }
+
+    // Стоимость входа в укрупнённую ячейку
+    float CoarseCost( size_t index ) const {
+        const uint32_t count = passable.Value( level, index );
+        return ( count == 0 ? HEX_PATH_BLOCKED : cost_sums.Value( level, index ) / count * scale );
+    }
+
+    // ================================================================
+    // Поиск пути от start до goal (агрегаты должны соответствовать costs)
+    // ================================================================
+    // nodes_expanded - сумма раскрытых вершин всех этапов поиска
+    // ================================================================
+    HexPathStats FindPath( const Hex& start, const Hex& goal, const HexMap<float>& costs, vector<Hex>& path,
+                           HexPathAlgorithm_t algorithm = HEX_PATH_ASTAR ) {
+        const HexMapShape& shape = hierarchy.Shape( 0 );
+
+        if ( level == 0 || !shape.Contains( start ) || !shape.Contains( goal ) ) {
+            return fine.FindPath( start, goal, costs, path, algorithm );
+        }
+
+        // Поиск на укрупнённом уровне
+        const HexMapShape& coarse_shape = hierarchy.Shape( level );
+        const HexPathStats coarse_stats = coarse.FindPath(
+            coarse_shape.HexAt( ancestors[ shape.Index( start ) ] ), coarse_shape.HexAt( ancestors[ shape.Index( goal ) ] ),
+            [this]( const Hex&, size_t index ) { return CoarseCost( index ); }, coarse_path, algorithm );
+        size_t nodes_expanded = coarse_stats.nodes_expanded;
+
+        if ( coarse_stats.found ) {
+            // Коридор: ячейки укрупнённого пути и их соседи
+            NextStamp();
+
+            for ( const Hex& hex : coarse_path ) {
+                corridor[ coarse_shape.Index( hex ) ] = stamp;
+
+                for ( const Hex& direction : HEX_DIRECTIONS ) {
+                    if ( coarse_shape.Contains( hex + direction ) ) {
+                        corridor[ coarse_shape.Index( hex + direction ) ] = stamp;
+                    }
+                }
+            }
+
+            HexPathStats stats = fine.FindPath( start, goal, [this, &costs]( const Hex&, size_t index ) {
+                return ( corridor[ ancestors[ index ] ] == stamp ? costs.Cell( index ) : HEX_PATH_BLOCKED );
+            }, path, algorithm );
+
+            nodes_expanded += stats.nodes_expanded;
+
+            if ( stats.found ) {
+                stats.nodes_expanded = nodes_expanded;
+                return stats;
+            }
+        }
+
+        // Путь вне коридора (или укрупнённый путь не найден)
+        HexPathStats stats = fine.FindPath( start, goal, costs, path, algorithm );
+        stats.nodes_expanded += nodes_expanded;
+        return stats;
+    }
+
+private:
+    void NextStamp() {
+        if ( ++stamp == 0 ) {
+            std::fill( corridor.begin(), corridor.end(), 0 );
+            stamp = 1;
+        }
+    }
+
+    const HexHierarchy& hierarchy;
+    int level;
+
+    // Расстояние между центрами соседних укрупнённых ячеек
+    float scale;
+
+    // Поиск на исходной карте и на укрупнённом уровне
+    HexPathfinder fine;
+    HexPathfinder coarse;
+
+    // Суммы стоимостей и количество проходимых ячеек
+    HexHierarchyAggregate<float> cost_sums;
+    HexHierarchyAggregate<uint32_t> passable;
+
+    // Предки ячеек исходной карты на уровне level
+    vector<uint32_t> ancestors;
+
+    // Коридор (ячейки уровня level, помеченные номером запроса)
+    vector<uint32_t> corridor;
+    uint32_t stamp;
+
+    // Укрупнённый путь
+    vector<Hex> coarse_path;
+};
+
+#endif // HEXHIERARCHICALPATHFINDER_H
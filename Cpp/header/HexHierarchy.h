@@ -0,0 +1,349 @@
+/*
+ * HexHierarchy.h
+ *
+ * Иерархия гексов (апертура 7): укрупнённые уровни и агрегаты
+ */
+
+#pragma once
+#ifndef HEXHIERARCHY_H
+#define HEXHIERARCHY_H
+
+#include "HexGrid.h"
+#include "HexMap.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+// ================================================================
+// Количество дочерних гексов родителя
+// ================================================================
+const int HEX_HIERARCHY_APERTURE = 7;
+
+// ================================================================
+// Иерархия гексов с апертурой 7
+// ================================================================
+// Родитель - это центральный гекс и 6 его соседей. Центры родителей
+// образуют решётку ( q - 2r ) mod 7 == 0, центр родителя ( a, b )
+// - гекс ( 2a - b, a + 3b ), соседние родители - соседние гексы
+// укрупнённого уровня. Дочерние гексы нумеруются 0..6: 0 - центр,
+// 1 + d - центр + HexDirection( d ). Каждый гекс принадлежит ровно
+// одному родителю, уровни строятся рекурсивно
+// ================================================================
+
+// Номер дочернего гекса по вычету ( q - 2r ) mod 7
+constexpr int HEX_HIERARCHY_CHILD_BY_RESIDUE[ HEX_HIERARCHY_APERTURE ] = { 0, 1, 3, 2, 5, 6, 4 };
+
+// Вычет ( q - 2r ) mod 7
+constexpr int HexHierarchyResidue( const Hex& hex ) {
+    const int residue = ( hex.Q() - 2 * hex.R() ) % HEX_HIERARCHY_APERTURE;
+    return ( residue < 0 ? residue + HEX_HIERARCHY_APERTURE : residue );
+}
+
+// ================================================================
+// Номер гекса среди дочерних гексов родителя (0 - центр)
+// ================================================================
+constexpr int HexChildIndex( const Hex& hex ) {
+    return HEX_HIERARCHY_CHILD_BY_RESIDUE[ HexHierarchyResidue( hex ) ];
+}
+
+// ================================================================
+// Центр родителя (на уровне дочерних гексов)
+// ================================================================
+constexpr Hex HexCenterChild( const Hex& parent ) {
+    return Hex( 2 * parent.Q() - parent.R(), parent.Q() + 3 * parent.R() );
+}
+
+// ================================================================
+// Дочерний гекс родителя (child = 0..6)
+// ================================================================
+constexpr Hex HexChild( const Hex& parent, int child ) {
+    return ( child == 0 ? HexCenterChild( parent ) : HexCenterChild( parent ) + HexDirection( child - 1 ) );
+}
+
+// ================================================================
+// Родитель гекса на levels уровней выше
+// ================================================================
+constexpr Hex HexParent( const Hex& hex, int levels = 1 ) {
+    Hex result = hex;
+
+    for ( int level = 0; level != levels; ++level ) {
+        const int child = HexChildIndex( result );
+        const Hex center = ( child == 0 ? result : result - HexDirection( child - 1 ) );
+
+        // Обратное преобразование к HexCenterChild (деление точное)
+        result = Hex( ( 3 * center.Q() + center.R() ) / HEX_HIERARCHY_APERTURE,
+                      ( 2 * center.R() - center.Q() ) / HEX_HIERARCHY_APERTURE );
+    }
+
+    return result;
+}
+
+// ================================================================
+// Уровни иерархии карты гексов
+// ================================================================
+// Уровень 0 - исходная карта, уровень k - родители ячеек уровня k - 1.
+// Форма уровня k > 0 - охватывающий ромб родителей, поэтому у каждой
+// ячейки уровня есть компактный индекс Index( level, hex ). Ячейки
+// ромба без дочерних ячеек (за пределами карты) пусты
+// ================================================================
+class HexHierarchy {
+public:
+    HexHierarchy( const HexMapShape& shape, int levels ) {
+        if ( levels < 0 ) {
+            throw std::invalid_argument( "HexHierarchy levels must be non-negative." );
+        }
+
+        shapes.push_back( shape );
+
+        for ( int level = 1; level <= levels; ++level ) {
+            AddLevel();
+        }
+    }
+
+    // Количество укрупнённых уровней (уровни 0..Levels())
+    int Levels() const { return static_cast<int>( shapes.size() ) - 1; }
+
+    // Форма уровня
+    const HexMapShape& Shape( int level ) const { return shapes[ level ]; }
+
+    // Гекс принадлежит уровню и индекс его ячейки
+    bool Contains( int level, const Hex& hex ) const { return shapes[ level ].Contains( hex ); }
+    size_t Index( int level, const Hex& hex ) const { return shapes[ level ].Index( hex ); }
+
+    // Индекс родителя ячейки уровня level < Levels() на уровне level + 1
+    uint32_t Parent( int level, size_t index ) const { return parents[ level ][ index ]; }
+
+    // Индекс предка ячейки уровня 0 на уровне level
+    uint32_t Ancestor( size_t index, int level ) const {
+        uint32_t result = static_cast<uint32_t>( index );
+
+        for ( int i = 0; i != level; ++i ) {
+            result = parents[ i ][ result ];
+        }
+
+        return result;
+    }
+
+    // ================================================================
+    // Дочерние ячейки ячейки уровня level > 0 (индексы уровня level - 1)
+    // ================================================================
+    size_t ChildCount( int level, size_t index ) const {
+        return child_start[ level - 1 ][ index + 1 ] - child_start[ level - 1 ][ index ];
+    }
+
+    const uint32_t* ChildrenBegin( int level, size_t index ) const {
+        return children[ level - 1 ].data() + child_start[ level - 1 ][ index ];
+    }
+
+    const uint32_t* ChildrenEnd( int level, size_t index ) const {
+        return children[ level - 1 ].data() + child_start[ level - 1 ][ index + 1 ];
+    }
+
+    // Количество ячеек уровня 0 под ячейкой уровня level
+    uint32_t CellCount( int level, size_t index ) const { return cell_counts[ level ][ index ]; }
+
+private:
+    void AddLevel() {
+        const HexMapShape& fine = shapes.back();
+        vector<Hex> fine_parents( fine.Size() );
+        int q_min = std::numeric_limits<int>::max();
+        int q_max = std::numeric_limits<int>::min();
+        int r_min = std::numeric_limits<int>::max();
+        int r_max = std::numeric_limits<int>::min();
+
+        for ( size_t row = 0; row != fine.Rows(); ++row ) {
+            for ( int offset = 0; offset != static_cast<int>( fine.RowLength( row ) ); ++offset ) {
+                const Hex hex = fine.RowHex( row, offset );
+                const Hex parent = HexParent( hex );
+                fine_parents[ fine.Index( hex ) ] = parent;
+                q_min = std::min( q_min, parent.Q() );
+                q_max = std::max( q_max, parent.Q() );
+                r_min = std::min( r_min, parent.R() );
+                r_max = std::max( r_max, parent.R() );
+            }
+        }
+
+        const HexMapShape coarse = ( fine.Size() == 0 ? HexMapShape::Rhombus( Hex( 0, 0 ), 0, 0 )
+                                     : HexMapShape::Rhombus( Hex( q_min, r_min ), q_max - q_min + 1, r_max - r_min + 1 ) );
+
+        // Родители и дочерние ячейки (в порядке индексов уровня level - 1)
+        vector<uint32_t> level_parents( fine.Size() );
+        vector<uint32_t> level_start( coarse.Size() + 1, 0 );
+        vector<uint32_t> level_children( fine.Size() );
+
+        for ( size_t index = 0; index != fine.Size(); ++index ) {
+            level_parents[ index ] = static_cast<uint32_t>( coarse.Index( fine_parents[ index ] ) );
+            ++level_start[ level_parents[ index ] + 1 ];
+        }
+
+        for ( size_t index = 0; index != coarse.Size(); ++index ) {
+            level_start[ index + 1 ] += level_start[ index ];
+        }
+
+        vector<uint32_t> fill( level_start.begin(), level_start.end() - 1 );
+
+        for ( size_t index = 0; index != fine.Size(); ++index ) {
+            level_children[ fill[ level_parents[ index ] ]++ ] = static_cast<uint32_t>( index );
+        }
+
+        // Количество ячеек уровня 0
+        if ( cell_counts.empty() ) {
+            cell_counts.emplace_back( fine.Size(), 1 );
+        }
+
+        vector<uint32_t> counts( coarse.Size(), 0 );
+
+        for ( size_t index = 0; index != fine.Size(); ++index ) {
+            counts[ level_parents[ index ] ] += cell_counts.back()[ index ];
+        }
+
+        shapes.push_back( coarse );
+        parents.push_back( std::move( level_parents ) );
+        child_start.push_back( std::move( level_start ) );
+        children.push_back( std::move( level_children ) );
+        cell_counts.push_back( std::move( counts ) );
+    }
+
+    // Формы уровней 0..Levels()
+    vector<HexMapShape> shapes;
+
+    // Родители ячеек уровней 0..Levels()-1
+    vector<vector<uint32_t>> parents;
+
+    // Дочерние ячейки уровней 1..Levels() (начала списков и списки)
+    vector<vector<uint32_t>> child_start;
+    vector<vector<uint32_t>> children;
+
+    // Количество ячеек уровня 0 под ячейками уровней 0..Levels()
+    vector<vector<uint32_t>> cell_counts;
+};
+
+// ================================================================
+// Операция агрегирования
+// ================================================================
+// HEX_AGGREGATE_SUM = Сумма (для занятости - сумма значений 0/1)
+// HEX_AGGREGATE_MIN = Минимум
+// HEX_AGGREGATE_MAX = Максимум
+// ================================================================
+enum HexAggregate_t {
+    HEX_AGGREGATE_SUM = 0,
+    HEX_AGGREGATE_MIN = 1,
+    HEX_AGGREGATE_MAX = 2
+};
+
+// ================================================================
+// Агрегаты значений ячеек по уровням иерархии
+// ================================================================
+// Значение ячейки уровня k > 0 - агрегат значений её дочерних
+// ячеек, у пустых ячеек - нейтральный элемент операции. При
+// изменении ячейки уровня 0 пересчитываются только её предки
+// (не более 7 значений на уровень), пересчёт останавливается на
+// первом неизменившемся предке
+// ================================================================
+template<class T>
+class HexHierarchyAggregate {
+public:
+    HexHierarchyAggregate( const HexHierarchy& hierarchy_, HexAggregate_t operation_ ) :
+        hierarchy( hierarchy_ ), operation( operation_ ) {
+        for ( int level = 0; level <= hierarchy.Levels(); ++level ) {
+            levels.emplace_back( hierarchy.Shape( level ), Identity() );
+        }
+    }
+
+    // Операция агрегирования
+    HexAggregate_t Operation() const { return operation; }
+
+    // ================================================================
+    // Полное вычисление агрегатов по значениям уровня 0
+    // ================================================================
+    void Build( const HexMap<T>& values ) {
+        std::copy( values.Data(), values.Data() + values.Size(), levels[ 0 ].Data() );
+
+        for ( int level = 1; level <= hierarchy.Levels(); ++level ) {
+            for ( size_t index = 0; index != levels[ level ].Size(); ++index ) {
+                levels[ level ].Cell( index ) = Combine( level, index );
+            }
+        }
+    }
+
+    // ================================================================
+    // Изменение значения ячейки уровня 0
+    // ================================================================
+    void Set( size_t index, const T& value ) {
+        levels[ 0 ].Cell( index ) = value;
+
+        for ( int level = 1; level <= hierarchy.Levels(); ++level ) {
+            index = hierarchy.Parent( level - 1, index );
+            const T combined = Combine( level, index );
+
+            if ( combined == levels[ level ].Cell( index ) ) {
+                break;
+            }
+
+            levels[ level ].Cell( index ) = combined;
+        }
+    }
+
+    void Set( const Hex& hex, const T& value ) { Set( hierarchy.Index( 0, hex ), value ); }
+
+    // Значение ячейки уровня
+    const T& Value( int level, size_t index ) const { return levels[ level ].Cell( index ); }
+    const T& Value( int level, const Hex& hex ) const { return levels[ level ][ hex ]; }
+
+    // Значения всех ячеек уровня
+    const HexMap<T>& Level( int level ) const { return levels[ level ]; }
+
+private:
+    // Нейтральный элемент операции
+    T Identity() const {
+        switch ( operation ) {
+            case HEX_AGGREGATE_MIN:
+                return ( std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                              : std::numeric_limits<T>::max() );
+
+            case HEX_AGGREGATE_MAX:
+                return ( std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                                                              : std::numeric_limits<T>::lowest() );
+
+            default:
+                return T();
+        }
+    }
+
+    // Агрегат дочерних ячеек ячейки уровня level
+    T Combine( int level, size_t index ) const {
+        const HexMap<T>& fine = levels[ level - 1 ];
+        T result = Identity();
+
+        for ( const uint32_t* child = hierarchy.ChildrenBegin( level, index ); child != hierarchy.ChildrenEnd( level, index ); ++child ) {
+            const T& value = fine.Cell( *child );
+
+            switch ( operation ) {
+                case HEX_AGGREGATE_MIN:
+                    result = std::min( result, value );
+                    break;
+
+                case HEX_AGGREGATE_MAX:
+                    result = std::max( result, value );
+                    break;
+
+                default:
+                    result += value;
+                    break;
+            }
+        }
+
+        return result;
+    }
+
+    const HexHierarchy& hierarchy;
+    HexAggregate_t operation;
+
+    // Значения уровней 0..Levels()
+    vector<HexMap<T>> levels;
+};
+
+#endif // HEXHIERARCHY_H
@@ -0,0 +1,152 @@
+/*
+ * HexIndexedHeap.h
+ *
+ * Индексированная куча для поиска на карте гексов
+ */
+
+#pragma once
+#ifndef HEXINDEXEDHEAP_H
+#define HEXINDEXEDHEAP_H
+
+#include "HexGrid.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+// ================================================================
+// Индексированная 4-арная куча (минимум по ключу) с уменьшением ключа
+// ================================================================
+// Элементы - индексы ячеек 0..capacity-1 с гексами ячеек (гекс
+// извлекаемой вершины не восстанавливается по индексу). Позиция элемента в куче
+// хранится в массиве по индексу ячейки; принадлежность проверяется
+// обратной ссылкой, поэтому массив позиций не очищается между
+// запросами и Clear() выполняется за O(1)
+// ================================================================
+class HexIndexedHeap {
+public:
+    explicit HexIndexedHeap( size_t capacity ) : position( capacity, 0 ) {}
+
+    // Удаление всех элементов
+    void Clear() { heap.clear(); }
+
+    bool Empty() const { return heap.empty(); }
+    size_t Size() const { return heap.size(); }
+
+    // Наименьший ключ и гекс его элемента (куча не пуста)
+    float TopKey() const { return heap.front().key; }
+    const Hex& TopHex() const { return heap.front().hex; }
+
+    // Элемент находится в куче
+    bool Contains( uint32_t index ) const {
+        const uint32_t i = position[ index ];
+        return ( i < heap.size() && heap[ i ].index == index );
+    }
+
+    // Ключ элемента (элемент находится в куче)
+    float Key( uint32_t index ) const { return heap[ position[ index ] ].key; }
+
+    // Добавление элемента (элемента нет в куче)
+    void Push( uint32_t index, float key, const Hex& hex ) {
+        position[ index ] = static_cast<uint32_t>( heap.size() );
+        heap.push_back( { key, index, hex } );
+        SiftUp( position[ index ] );
+    }
+
+    // Уменьшение ключа (элемент находится в куче, key не больше текущего)
+    void Decrease( uint32_t index, float key ) {
+        heap[ position[ index ] ].key = key;
+        SiftUp( position[ index ] );
+    }
+
+    // Добавление элемента или уменьшение его ключа
+    void PushOrDecrease( uint32_t index, float key, const Hex& hex ) {
+        if ( !Contains( index ) ) {
+            Push( index, key, hex );
+        } else if ( key < Key( index ) ) {
+            Decrease( index, key );
+        }
+    }
+
+    // Извлечение элемента с наименьшим ключом
+    uint32_t Pop() {
+        const uint32_t index = heap.front().index;
+        heap.front() = heap.back();
+        heap.pop_back();
+
+        if ( !heap.empty() ) {
+            SiftDown( 0 );
+        }
+
+        return index;
+    }
+
+private:
+    // Количество потомков вершины кучи
+    static constexpr uint32_t ARITY = 4;
+
+    struct Entry {
+        float key;
+        uint32_t index;
+        Hex hex;
+    };
+
+    void SiftUp( uint32_t i ) {
+        const Entry entry = heap[ i ];
+
+        while ( i > 0 ) {
+            const uint32_t parent = ( i - 1 ) / ARITY;
+
+            if ( !( entry.key < heap[ parent ].key ) ) {
+                break;
+            }
+
+            heap[ i ] = heap[ parent ];
+            position[ heap[ i ].index ] = i;
+            i = parent;
+        }
+
+        heap[ i ] = entry;
+        position[ entry.index ] = i;
+    }
+
+    void SiftDown( uint32_t i ) {
+        const Entry entry = heap[ i ];
+        const uint32_t size = static_cast<uint32_t>( heap.size() );
+
+        for ( ;; ) {
+            const uint32_t first = ARITY * i + 1;
+
+            if ( first >= size ) {
+                break;
+            }
+
+            // Наименьший из потомков
+            const uint32_t last = std::min( first + ARITY, size );
+            uint32_t child = first;
+
+            for ( uint32_t j = first + 1; j < last; ++j ) {
+                child = ( heap[ j ].key < heap[ child ].key ? j : child );
+            }
+
+            if ( !( heap[ child ].key < entry.key ) ) {
+                break;
+            }
+
+            heap[ i ] = heap[ child ];
+            position[ heap[ i ].index ] = i;
+            i = child;
+        }
+
+        heap[ i ] = entry;
+        position[ entry.index ] = i;
+    }
+
+    vector<Entry> heap;
+    vector<uint32_t> position;
+};
+
+#endif // HEXINDEXEDHEAP_H
@@ -0,0 +1,99 @@
+/*
+ * HexKey.h
+ *
+ * Упакованный ключ гекса, хеширование и упорядочение
+ */
+
+#pragma once
+#ifndef HEXKEY_H
+#define HEXKEY_H
+
+#include "HexGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// ================================================================
+// Упаковка гекса в 64-битный ключ (без потерь)
+// ================================================================
+// Старшие 32 бита - Q, младшие - R, знаковые биты инвертированы,
+// поэтому порядок ключей совпадает с лексикографическим порядком ( Q, R )
+// ================================================================
+constexpr uint64_t HexPack( const Hex& hex ) {
+    return ( static_cast<uint64_t>( static_cast<uint32_t>( hex.Q() ) ^ 0x80000000U ) << 32 )
+           | ( static_cast<uint32_t>( hex.R() ) ^ 0x80000000U );
+}
+
+constexpr Hex HexUnpack( uint64_t key ) {
+    return Hex( static_cast<int32_t>( static_cast<uint32_t>( key >> 32 ) ^ 0x80000000U ),
+                static_cast<int32_t>( static_cast<uint32_t>( key ) ^ 0x80000000U ) );
+}
+
+// ================================================================
+// Упаковка гекса в 32-битный ключ (Q и R в диапазоне int16_t)
+// ================================================================
+constexpr bool HexFitsPack32( const Hex& hex ) {
+    return ( hex.Q() >= INT16_MIN && hex.Q() <= INT16_MAX && hex.R() >= INT16_MIN && hex.R() <= INT16_MAX );
+}
+
+constexpr uint32_t HexPack32( const Hex& hex ) {
+    return ( static_cast<uint32_t>( static_cast<uint16_t>( hex.Q() ) ^ 0x8000U ) << 16 )
+           | ( static_cast<uint16_t>( hex.R() ) ^ 0x8000U );
+}
+
+constexpr Hex HexUnpack32( uint32_t key ) {
+    return Hex( static_cast<int16_t>( static_cast<uint16_t>( key >> 16 ) ^ 0x8000U ),
+                static_cast<int16_t>( static_cast<uint16_t>( key ) ^ 0x8000U ) );
+}
+
+// ================================================================
+// Перемешивание битов ключа (финализатор splitmix64)
+// ================================================================
+// Каждый бит ключа влияет на все биты результата, поэтому младшие
+// биты пригодны для хеш-таблиц с размером - степенью двойки
+// ================================================================
+constexpr uint64_t HexHash64( uint64_t key ) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+// ================================================================
+// Хеш гекса и упакованного ключа для таблиц с размером - степенью двойки
+// ================================================================
+struct HexHash {
+    size_t operator ()( const Hex& hex ) const { return static_cast<size_t>( HexHash64( HexPack( hex ) ) ); }
+};
+
+struct HexKeyHash {
+    size_t operator ()( uint64_t key ) const { return static_cast<size_t>( HexHash64( key ) ); }
+};
+
+// ================================================================
+// Порядок гексов: лексикографический по ( Q, R ), совпадает с порядком HexPack
+// ================================================================
+constexpr bool operator <( const Hex& left, const Hex& right ) {
+    return ( left.Q() < right.Q() || ( left.Q() == right.Q() && left.R() < right.R() ) );
+}
+
+// ================================================================
+// Хеш гекса для стандартных контейнеров (как HexHash)
+// ================================================================
+// Ключ перемешивается: размер корзин зависит от реализации, а при
+// 32-битном size_t без перемешивания старшая половина ключа ( Q )
+// была бы отброшена
+// ================================================================
+namespace std {
+
+template<>
+struct hash<Hex> {
+    size_t operator ()( const Hex& hex ) const { return HexHash()( hex ); }
+};
+
+}
+
+#endif // HEXKEY_H
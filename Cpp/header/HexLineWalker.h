@@ -0,0 +1,179 @@
+/*
+ * HexLineWalker.h
+ *
+ * Целочисленный пошаговый обход линии гексов
+ */
+
+#pragma once
+#ifndef HEXLINEWALKER_H
+#define HEXLINEWALKER_H
+
+#include "HexGrid.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+
+// ================================================================
+// Пошаговый обход линии гексов (без выделения памяти)
+// ================================================================
+// Выдаёт те же гексы, что и HexLine( hex_a, hex_b, false, 0, round_algorithm ).
+// Гекс шага i - округление точки hex_a + ( hex_b - hex_a ) * i / N,
+// N = HexDistance( hex_a, hex_b ). Координаты точки хранятся в целых
+// числах, умноженных на 2N, и меняются на каждом шаге сложением
+// (как в алгоритме Брезенхэма). Если точка лежит точно посередине
+// между гексами и результат зависит от погрешностей вычислений
+// HexLine, гекс этого шага вычисляется так же, как в HexLine
+// ================================================================
+class HexLineWalker {
+public:
+    HexLineWalker( const Hex& hex_a_, const Hex& hex_b_, int round_algorithm_ = HEX_ROUND_DEFAULT ) :
+        hex_a( hex_a_ ), hex_b( hex_b_ ), hex( hex_a_ ),
+        n( static_cast<int>( HexDistance( hex_a_, hex_b_ ) ) ), index( 0 ),
+        round_algorithm( HexRoundAlgorithm( round_algorithm_ ) ),
+        step( 1.0L / std::max( n, 1 ) ) {
+        const int a[ 3 ] = { hex_a.Q(), hex_a.R(), hex_a.S() };
+        const int b[ 3 ] = { hex_b.Q(), hex_b.R(), hex_b.S() };
+
+        for ( int i = 0; i != 3; ++i ) {
+            cell[ i ] = a[ i ];
+            error[ i ] = 0;
+            delta[ i ] = 2 * ( b[ i ] - a[ i ] );
+        }
+    }
+
+    // Количество шагов N (гексов в линии N + 1)
+    int Count() const { return n; }
+
+    // Номер текущего шага (0..N)
+    int Index() const { return index; }
+
+    // Обход завершён (пройден последний гекс)
+    bool Done() const { return index > n; }
+
+    // Гекс текущего шага
+    const Hex& Current() const { return hex; }
+
+    // Переход к следующему шагу
+    void Next() {
+        if ( ++index > n ) {
+            return;
+        }
+
+        // error = 2N * ( точная координата - округлённая ), в пределах [ -N, N )
+        for ( int i = 0; i != 3; ++i ) {
+            error[ i ] += delta[ i ];
+
+            if ( error[ i ] >= n ) {
+                error[ i ] -= 2 * n;
+                ++cell[ i ];
+            } else if ( error[ i ] < -n ) {
+                error[ i ] += 2 * n;
+                --cell[ i ];
+            }
+        }
+
+        hex = RoundCell();
+    }
+
+    // ================================================================
+    // Обход до первого гекса, для которого stop( hex ) == true
+    // ================================================================
+    // Возвращает true, если обход остановлен (Current() - этот гекс),
+    // false - если линия пройдена до конца
+    // ================================================================
+    template<class Predicate>
+    bool Walk( Predicate stop ) {
+        for ( ; !Done(); Next() ) {
+            if ( stop( hex ) ) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Обход гексов линии (range-for)
+    class Iterator;
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    // Округление текущей точки
+    Hex RoundCell() const {
+        const int q_error = std::abs( error[ 0 ] );
+        const int r_error = std::abs( error[ 1 ] );
+        const int s_error = std::abs( error[ 2 ] );
+
+        // Округлённые координаты согласованы: отбрасывание любой даёт тот же гекс
+        if ( cell[ 0 ] + cell[ 1 ] + cell[ 2 ] == 0 ) {
+            return Hex( cell[ 0 ], cell[ 1 ] );
+        }
+
+        // Наибольших ошибок несколько (точка посередине между гексами):
+        // результат HexLine определяется погрешностями вычислений
+        const int max_error = std::max( q_error, std::max( r_error, s_error ) );
+
+        if ( ( q_error == max_error ) + ( r_error == max_error ) + ( s_error == max_error ) > 1 ) {
+            return HexLinearInterpolation( hex_a, hex_b, step * index ).Round( round_algorithm );
+        }
+
+        // Отбрасываем координату с наибольшей ошибкой округления
+        if ( q_error == max_error ) {
+            return Hex( -cell[ 1 ] - cell[ 2 ], cell[ 1 ] );
+        } else if ( r_error == max_error ) {
+            return Hex( cell[ 0 ], -cell[ 0 ] - cell[ 2 ] );
+        } else {
+            return Hex( cell[ 0 ], cell[ 1 ] );
+        }
+    }
+
+    Hex hex_a;
+    Hex hex_b;
+    Hex hex;
+    int n;
+    int index;
+    int round_algorithm;
+    double step;
+    int cell[ 3 ];
+    int error[ 3 ];
+    int delta[ 3 ];
+};
+
+// ================================================================
+// Обход гексов линии (range-for)
+// ================================================================
+class HexLineWalker::Iterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Hex;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Hex*;
+    using reference = const Hex&;
+
+    explicit Iterator( const HexLineWalker& walker_ ) : walker( walker_ ) {}
+
+    const Hex& operator *() const { return walker.Current(); }
+
+    Iterator& operator ++() {
+        walker.Next();
+        return *this;
+    }
+
+    bool operator ==( const Iterator& other ) const { return walker.Index() == other.walker.Index(); }
+    bool operator !=( const Iterator& other ) const { return walker.Index() != other.walker.Index(); }
+
+private:
+    HexLineWalker walker;
+};
+
+inline HexLineWalker::Iterator HexLineWalker::begin() const { return Iterator( *this ); }
+
+inline HexLineWalker::Iterator HexLineWalker::end() const {
+    HexLineWalker last( *this );
+    last.index = n + 1;
+    return Iterator( last );
+}
+
+#endif // HEXLINEWALKER_H
@@ -0,0 +1,516 @@
+/*
+ * HexMap.h
+ *
+ * Карта гексов: непрерывное хранение данных ячеек
+ */
+
+#pragma once
+#ifndef HEXMAP_H
+#define HEXMAP_H
+
+#include "HexGrid.h"
+#include "HexMorton.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// ================================================================
+// Порядок хранения ячеек карты
+// ================================================================
+// HEX_MAP_ORDER_ROWS = По строкам
+// HEX_MAP_ORDER_MORTON = По коду Мортона осевых координат (Z-порядок):
+//     соседи по R в среднем ближе в памяти, чем при хранении по строкам
+// ================================================================
+enum HexMapOrder_t {
+    HEX_MAP_ORDER_ROWS = 0,
+    HEX_MAP_ORDER_MORTON = 1
+};
+
+// ================================================================
+// Форма карты гексов
+// ================================================================
+// Любая поддерживаемая форма - это набор строк, в каждой строке
+// непрерывный отрезок гексов. Строки хранятся подряд, поэтому
+// индекс гекса вычисляется за O(1) по двум обращениям к таблицам.
+// Строка - это постоянная координата R (отрезок по Q) или,
+// для прямоугольных карт с ориентацией HEX_ORIENTATION_FLAT,
+// постоянная координата Q (отрезок по R).
+// Порядок хранения задаётся WithOrder(): при HEX_MAP_ORDER_MORTON
+// гексы разбиты на тайлы 8x8 по осевым координатам, тайлы и гексы
+// внутри тайла упорядочены по коду Мортона (порядок ячеек совпадает
+// с порядком HexMortonEncode), индекс гекса - база
+// тайла плюс количество гексов тайла с меньшим кодом (маска тайла)
+// ================================================================
+class HexMapShape {
+public:
+    // ================================================================
+    // Прямоугольная карта: офсетные координаты col = 0..width-1, row = 0..height-1
+    // ================================================================
+    // Порядок ячеек совпадает с row * width + col (row-major),
+    // для ориентации HEX_ORIENTATION_FLAT - с col * height + row
+    // ================================================================
+    static HexMapShape Rectangle( const HexLayout& layout, int width, int height ) {
+        HexMapShape shape( layout.orientation == HEX_ORIENTATION_FLAT );
+        const int rows = ( shape.by_column ? width : height );
+        const int length = ( shape.by_column ? height : width );
+
+        for ( int row = 0; row != rows; ++row ) {
+            const Hex first = ( shape.by_column ? Offset_to_Cube( layout, OffsetHex( row, 0 ) )
+                                                : Offset_to_Cube( layout, OffsetHex( 0, row ) ) );
+            shape.AddRow( ( shape.by_column ? first.R() : first.Q() ), length );
+        }
+
+        shape.major_min = 0;
+        return shape;
+    }
+
+    // ================================================================
+    // Шестиугольная карта: гексы на расстоянии не более radius от center
+    // ================================================================
+    static HexMapShape Hexagon( const Hex& center, int radius ) {
+        HexMapShape shape( false );
+
+        for ( int dr = -radius; dr <= radius; ++dr ) {
+            const int dq_min = std::max( -radius, -dr - radius );
+            const int dq_max = std::min( radius, -dr + radius );
+            shape.AddRow( center.Q() + dq_min, dq_max - dq_min + 1 );
+        }
+
+        shape.major_min = center.R() - radius;
+        return shape;
+    }
+
+    // ================================================================
+    // Ромбовидная карта: Q = origin.Q()..origin.Q()+width-1, R = origin.R()..origin.R()+height-1
+    // ================================================================
+    static HexMapShape Rhombus( const Hex& origin, int width, int height ) {
+        HexMapShape shape( false );
+
+        for ( int row = 0; row != height; ++row ) {
+            shape.AddRow( origin.Q(), width );
+        }
+
+        shape.major_min = origin.R();
+        return shape;
+    }
+
+    // ================================================================
+    // Произвольная форма по таблице строк (см. описание класса)
+    // ================================================================
+    // Строка row - координата major_min + row по Q ( by_column ) или R,
+    // гексы строки - отрезок длины lengths[ row ] от minor_min[ row ]
+    // ================================================================
+    static HexMapShape FromRows( bool by_column, int major_min, const int32_t* minor_min, const int32_t* lengths, size_t rows ) {
+        HexMapShape shape( by_column );
+
+        for ( size_t row = 0; row != rows; ++row ) {
+            if ( lengths[ row ] < 0 ) {
+                throw std::invalid_argument( "HexMapShape row length must be non-negative." );
+            }
+
+            shape.AddRow( minor_min[ row ], lengths[ row ] );
+        }
+
+        shape.major_min = major_min;
+        return shape;
+    }
+
+    // ================================================================
+    // Та же форма с порядком хранения order
+    // ================================================================
+    HexMapShape WithOrder( HexMapOrder_t order_ ) const {
+        HexMapShape shape( *this );
+        shape.order = order_;
+        shape.tiles.clear();
+        shape.tile_order.clear();
+        shape.tile_bases.clear();
+
+        if ( order_ == HEX_MAP_ORDER_MORTON ) {
+            shape.BuildTiles();
+        }
+
+        return shape;
+    }
+
+    // Порядок хранения
+    HexMapOrder_t Order() const { return order; }
+
+    // Количество ячеек
+    size_t Size() const { return row_start.back(); }
+
+    // Количество строк
+    size_t Rows() const { return minor_min.size(); }
+
+    // Гекс принадлежит карте
+    bool Contains( const Hex& hex ) const {
+        const size_t row = static_cast<size_t>( Major( hex ) - major_min );
+        return ( row < Rows() && static_cast<size_t>( Minor( hex ) - minor_min[ row ] ) < RowLength( row ) );
+    }
+
+    // Индекс ячейки (гекс должен принадлежать карте)
+    size_t Index( const Hex& hex ) const {
+        if ( order == HEX_MAP_ORDER_MORTON ) {
+            return MortonIndex( hex );
+        }
+
+        const size_t row = static_cast<size_t>( Major( hex ) - major_min );
+        return row_start[ row ] + static_cast<size_t>( Minor( hex ) - minor_min[ row ] );
+    }
+
+    // Гекс по индексу ячейки
+    Hex HexAt( size_t index ) const {
+        if ( order == HEX_MAP_ORDER_MORTON ) {
+            const size_t part = std::upper_bound( tile_bases.begin(), tile_bases.end(), index ) - tile_bases.begin() - 1;
+            return CursorHex( part, HexSelectBit( tiles[ tile_order[ part ] ].mask, static_cast<int>( index - tile_bases[ part ] ) ) );
+        }
+
+        const size_t row = std::upper_bound( row_start.begin(), row_start.end(), index ) - row_start.begin() - 1;
+        return RowHex( row, static_cast<int>( index - row_start[ row ] ) );
+    }
+
+    // ================================================================
+    // Обход ячеек в порядке хранения: курсор ( part, offset )
+    // ================================================================
+    // part - строка ( HEX_MAP_ORDER_ROWS ) или тайл в порядке кода Мортона,
+    // offset - смещение в строке или код гекса в тайле.
+    // Seek() переводит курсор на ближайшую ячейку не раньше него,
+    // part == Parts() - обход завершён
+    // ================================================================
+    size_t Parts() const { return ( order == HEX_MAP_ORDER_MORTON ? tile_order.size() : Rows() ); }
+
+    void Seek( size_t& part, int& offset ) const {
+        if ( order == HEX_MAP_ORDER_MORTON ) {
+            for ( ; part < tile_order.size(); ++part, offset = 0 ) {
+                const uint64_t mask = ( offset < TILE_CELLS ? tiles[ tile_order[ part ] ].mask >> offset << offset : 0 );
+
+                if ( mask != 0 ) {
+                    offset = HexLowestBit( mask );
+                    return;
+                }
+            }
+        } else {
+            for ( ; part < Rows() && static_cast<size_t>( offset ) >= RowLength( part ); ++part ) {
+                offset = 0;
+            }
+        }
+    }
+
+    Hex CursorHex( size_t part, int offset ) const {
+        if ( order == HEX_MAP_ORDER_MORTON ) {
+            const size_t tile = tile_order[ part ];
+            const int tile_q = static_cast<int>( tile % tiles_width );
+            const int tile_r = static_cast<int>( tile / tiles_width );
+            return Hex( tile_q_min + tile_q * TILE_SIDE + TileCoord( offset ),
+                        tile_r_min + tile_r * TILE_SIDE + TileCoord( offset >> 1 ) );
+        }
+
+        return RowHex( part, offset );
+    }
+
+    // Первый индекс строки (только для HEX_MAP_ORDER_ROWS)
+    size_t RowStart( size_t row ) const { return row_start[ row ]; }
+
+    // Длина строки
+    size_t RowLength( size_t row ) const { return row_start[ row + 1 ] - row_start[ row ]; }
+
+    // Таблица строк: строка - постоянная координата Q (иначе R),
+    // координата первой строки и первая координата строки row
+    bool ByColumn() const { return by_column; }
+    int MajorMin() const { return major_min; }
+    int RowMinor( size_t row ) const { return minor_min[ row ]; }
+
+    // Гекс строки row со смещением offset от начала строки
+    Hex RowHex( size_t row, int offset ) const {
+        const int major = major_min + static_cast<int>( row );
+        const int minor = minor_min[ row ] + offset;
+        return ( by_column ? Hex( major, minor ) : Hex( minor, major ) );
+    }
+
+    // Границы карты по координатам Q и R (у карты без строк минимум больше максимума)
+    int QMin() const { return ( by_column ? major_min : MinorMin() ); }
+    int QMax() const { return ( by_column ? major_min + static_cast<int>( Rows() ) - 1 : MinorMax() ); }
+    int RMin() const { return ( by_column ? MinorMin() : major_min ); }
+    int RMax() const { return ( by_column ? MinorMax() : major_min + static_cast<int>( Rows() ) - 1 ); }
+
+private:
+    // Сторона тайла и количество гексов тайла ( HEX_MAP_ORDER_MORTON )
+    static constexpr int TILE_SIDE = 8;
+    static constexpr int TILE_CELLS = TILE_SIDE * TILE_SIDE;
+
+    // Тайл: гексы карты (биты по коду гекса в тайле) и индекс первого гекса
+    struct Tile {
+        uint64_t mask;
+        size_t base;
+    };
+
+    explicit HexMapShape( bool by_column_ ) :
+        by_column( by_column_ ), major_min( 0 ), row_start( 1, 0 ), order( HEX_MAP_ORDER_ROWS ),
+        tile_q_min( 0 ), tile_r_min( 0 ), tiles_width( 0 ) {}
+
+    // Маска заполненного тайла
+    static constexpr uint64_t FULL_TILE = ~uint64_t( 0 );
+
+    // Код гекса в тайле (0..TILE_CELLS-1), q, r = 0..TILE_SIDE-1
+    static unsigned TileCode( uint32_t q, uint32_t r ) {
+        static constexpr uint8_t SPREAD[ TILE_SIDE ] = { 0, 1, 4, 5, 16, 17, 20, 21 };
+        return SPREAD[ q ] | ( SPREAD[ r ] << 1 );
+    }
+
+    // Индекс ячейки при хранении по коду Мортона (не встраивается: при
+    // хранении по строкам Index() не занимает лишних регистров)
+#if defined( __GNUC__ )
+    __attribute__(( noinline, pure ))
+#endif
+    size_t MortonIndex( const Hex& hex ) const {
+        const uint32_t q = static_cast<uint32_t>( hex.Q() - tile_q_min );
+        const uint32_t r = static_cast<uint32_t>( hex.R() - tile_r_min );
+        const Tile& tile = tiles[ ( r / TILE_SIDE ) * tiles_width + q / TILE_SIDE ];
+        const unsigned code = TileCode( q % TILE_SIDE, r % TILE_SIDE );
+
+        // Заполненный тайл (внутри карты): номер гекса в тайле равен коду
+        return tile.base + ( tile.mask == FULL_TILE ? code : HexPopCount( tile.mask & ( ( uint64_t( 1 ) << code ) - 1 ) ) );
+    }
+
+    // Координата гекса в тайле по чётным битам кода
+    static int TileCoord( int code ) {
+        code &= 0x15;
+        code = ( code | ( code >> 1 ) ) & 0x13;
+        return ( code | ( code >> 2 ) ) & 0x07;
+    }
+
+    // Округление вниз до границы тайла
+    static int TileFloor( int value ) {
+        return value - ( ( value % TILE_SIDE ) + TILE_SIDE ) % TILE_SIDE;
+    }
+
+    // Таблица тайлов охватывающего ромба и порядок непустых тайлов
+    void BuildTiles() {
+        if ( Size() == 0 ) {
+            return;
+        }
+
+        tile_q_min = TileFloor( QMin() );
+        tile_r_min = TileFloor( RMin() );
+        tiles_width = static_cast<size_t>( ( QMax() - tile_q_min ) / TILE_SIDE + 1 );
+        const size_t tiles_height = static_cast<size_t>( ( RMax() - tile_r_min ) / TILE_SIDE + 1 );
+        tiles.assign( tiles_width * tiles_height, { 0, 0 } );
+
+        for ( size_t row = 0; row != Rows(); ++row ) {
+            for ( int offset = 0; offset != static_cast<int>( RowLength( row ) ); ++offset ) {
+                const Hex hex = RowHex( row, offset );
+                const uint32_t q = static_cast<uint32_t>( hex.Q() - tile_q_min );
+                const uint32_t r = static_cast<uint32_t>( hex.R() - tile_r_min );
+                tiles[ ( r / TILE_SIDE ) * tiles_width + q / TILE_SIDE ].mask |= uint64_t( 1 ) << TileCode( q % TILE_SIDE, r % TILE_SIDE );
+            }
+        }
+
+        for ( size_t tile = 0; tile != tiles.size(); ++tile ) {
+            if ( tiles[ tile ].mask != 0 ) {
+                tile_order.push_back( static_cast<uint32_t>( tile ) );
+            }
+        }
+
+        std::sort( tile_order.begin(), tile_order.end(), [this]( uint32_t a, uint32_t b ) {
+            return TileMorton( a ) < TileMorton( b );
+        } );
+
+        size_t base = 0;
+
+        for ( uint32_t tile : tile_order ) {
+            tiles[ tile ].base = base;
+            tile_bases.push_back( base );
+            base += HexPopCount( tiles[ tile ].mask );
+        }
+    }
+
+    // Код Мортона первого гекса тайла (порядок тайлов совпадает с порядком HexMortonEncode)
+    uint64_t TileMorton( size_t tile ) const {
+        return HexMortonEncode( Hex( tile_q_min + static_cast<int>( tile % tiles_width ) * TILE_SIDE,
+                                     tile_r_min + static_cast<int>( tile / tiles_width ) * TILE_SIDE ) );
+    }
+
+    void AddRow( int minor_min_, int length ) {
+        minor_min.push_back( minor_min_ );
+        row_start.push_back( row_start.back() + length );
+    }
+
+    int Major( const Hex& hex ) const { return ( by_column ? hex.Q() : hex.R() ); }
+    int Minor( const Hex& hex ) const { return ( by_column ? hex.R() : hex.Q() ); }
+
+    int MinorMin() const {
+        return ( minor_min.empty() ? 0 : *std::min_element( minor_min.begin(), minor_min.end() ) );
+    }
+
+    int MinorMax() const {
+        if ( minor_min.empty() ) {
+            return -1;
+        }
+
+        int result = minor_min.front();
+
+        for ( size_t row = 0; row != Rows(); ++row ) {
+            result = std::max( result, minor_min[ row ] + static_cast<int>( RowLength( row ) ) - 1 );
+        }
+
+        return result;
+    }
+
+    // Строка - постоянная координата Q (иначе R)
+    bool by_column;
+
+    // Координата первой строки
+    int major_min;
+
+    // Первая координата каждой строки
+    vector<int> minor_min;
+
+    // Первый индекс каждой строки (плюс общее количество ячеек)
+    vector<size_t> row_start;
+
+    // Порядок хранения
+    HexMapOrder_t order;
+
+    // Тайлы охватывающего ромба ( HEX_MAP_ORDER_MORTON ): начало, ширина,
+    // таблица по строкам тайлов, непустые тайлы в порядке кода Мортона
+    // и их базы
+    int tile_q_min;
+    int tile_r_min;
+    size_t tiles_width;
+    vector<Tile> tiles;
+    vector<uint32_t> tile_order;
+    vector<size_t> tile_bases;
+};
+
+// ================================================================
+// Ячейка карты при обходе: гекс и ссылка на данные
+// ================================================================
+template<class T>
+struct HexMapCell {
+    const Hex hex;
+    T& value;
+};
+
+// ================================================================
+// Карта гексов с данными типа T
+// ================================================================
+// Данные хранятся непрерывно в порядке индексов формы карты
+// (см. HexMapShape::WithOrder), обход (range-for) выполняется
+// в порядке хранения
+// ================================================================
+template<class T>
+class HexMap {
+    // std::vector<bool> хранит биты и не выдаёт T& на ячейку
+    static_assert( !std::is_same<T, bool>::value, "HexMap<bool> is not supported, use HexMap<uint8_t> instead." );
+
+public:
+    explicit HexMap( const HexMapShape& shape_, const T& value = T() ) :
+        shape( shape_ ), cells( shape_.Size(), value ) {}
+
+    // Форма карты
+    const HexMapShape& Shape() const { return shape; }
+
+    // Количество ячеек
+    size_t Size() const { return cells.size(); }
+
+    // Гекс принадлежит карте
+    bool Contains( const Hex& hex ) const { return shape.Contains( hex ); }
+
+    // Индекс ячейки (гекс должен принадлежать карте)
+    size_t Index( const Hex& hex ) const { return shape.Index( hex ); }
+
+    // Данные ячейки (гекс должен принадлежать карте)
+    T& operator []( const Hex& hex ) { return cells[ shape.Index( hex ) ]; }
+    const T& operator []( const Hex& hex ) const { return cells[ shape.Index( hex ) ]; }
+
+    // Данные ячейки с проверкой границ
+    T& At( const Hex& hex ) {
+        if ( !shape.Contains( hex ) ) {
+            throw std::out_of_range( "Hex is out of HexMap." );
+        }
+
+        return cells[ shape.Index( hex ) ];
+    }
+
+    const T& At( const Hex& hex ) const {
+        return const_cast<HexMap*>( this )->At( hex );
+    }
+
+    // Данные ячейки или nullptr, если гекс вне карты
+    T* Find( const Hex& hex ) { return ( shape.Contains( hex ) ? &cells[ shape.Index( hex ) ] : nullptr ); }
+    const T* Find( const Hex& hex ) const { return const_cast<HexMap*>( this )->Find( hex ); }
+
+    // Данные соседней ячейки или nullptr, если сосед вне карты
+    T* Neighbor( const Hex& hex, int direction ) { return Find( hex + HexDirection( direction ) ); }
+    const T* Neighbor( const Hex& hex, int direction ) const { return Find( hex + HexDirection( direction ) ); }
+
+    // Вызов func( neighbor_hex, neighbor_value ) для соседей, принадлежащих карте
+    template<class Func>
+    void ForEachNeighbor( const Hex& hex, Func func ) {
+        for ( int direction = 0; direction != static_cast<int>( HEX_DIRECTION_COUNT ); ++direction ) {
+            const Hex neighbor = hex + HexDirection( direction );
+
+            if ( shape.Contains( neighbor ) ) {
+                func( neighbor, cells[ shape.Index( neighbor ) ] );
+            }
+        }
+    }
+
+    // Данные ячейки по индексу
+    T& Cell( size_t index ) { return cells[ index ]; }
+    const T& Cell( size_t index ) const { return cells[ index ]; }
+
+    // Непрерывный массив данных
+    T* Data() { return cells.data(); }
+    const T* Data() const { return cells.data(); }
+
+    // Заполнение всех ячеек
+    void Fill( const T& value ) { std::fill( cells.begin(), cells.end(), value ); }
+
+    // ================================================================
+    // Обход ячеек в порядке хранения
+    // ================================================================
+    template<class Value>
+    class Iterator {
+    public:
+        Iterator( const HexMapShape& shape_, Value* cells_, size_t part_ ) :
+            shape( &shape_ ), cells( cells_ ), part( part_ ), offset( 0 ),
+            index( part_ < shape_.Parts() ? 0 : shape_.Size() ) {
+            shape->Seek( part, offset );
+        }
+
+        HexMapCell<Value> operator *() const { return { shape->CursorHex( part, offset ), cells[ index ] }; }
+
+        Iterator& operator ++() {
+            ++index;
+            shape->Seek( part, ++offset );
+            return *this;
+        }
+
+        bool operator ==( const Iterator& other ) const { return index == other.index; }
+        bool operator !=( const Iterator& other ) const { return index != other.index; }
+
+    private:
+        const HexMapShape* shape;
+        Value* cells;
+        size_t part;
+        int offset;
+        size_t index;
+    };
+
+    Iterator<T> begin() { return Iterator<T>( shape, cells.data(), 0 ); }
+    Iterator<T> end() { return Iterator<T>( shape, cells.data(), shape.Parts() ); }
+    Iterator<const T> begin() const { return Iterator<const T>( shape, cells.data(), 0 ); }
+    Iterator<const T> end() const { return Iterator<const T>( shape, cells.data(), shape.Parts() ); }
+
+private:
+    // Форма карты
+    HexMapShape shape;
+
+    // Данные ячеек
+    vector<T> cells;
+};
+
+#endif // HEXMAP_H
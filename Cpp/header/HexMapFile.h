@@ -0,0 +1,309 @@
+/*
+ * HexMapFile.h
+ *
+ * Двоичный файл карты гексов: отображение в память без разбора и копирования
+ */
+
+#pragma once
+#ifndef HEXMAPFILE_H
+#define HEXMAPFILE_H
+
+#include "HexGrid.h"
+#include "HexMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+using std::string;
+
+// ================================================================
+// Формат файла карты (порядок байтов - порядок байтов машины)
+// ================================================================
+// HexMapFileHeader - заголовок: расположение гексов ( HexLayout ),
+//                    форма карты, тип ячеек, смещения частей файла
+// HexMapFileRow[]  - таблица строк формы (см. HexMapShape)
+// T[]              - данные ячеек в порядке индексов формы, начало
+//                    выровнено на HEX_MAP_FILE_ALIGN байт
+// Контрольная сумма покрывает таблицу строк и данные ячеек.
+// Сигнатура записывается последней, поэтому недописанный файл
+// не открывается
+// ================================================================
+constexpr char HEX_MAP_FILE_MAGIC[ 8 ] = { 'H', 'E', 'X', 'M', 'A', 'P', '\r', '\n' };
+constexpr uint32_t HEX_MAP_FILE_VERSION = 1;
+constexpr uint32_t HEX_MAP_FILE_ENDIAN = 0x01020304;
+constexpr size_t HEX_MAP_FILE_ALIGN = 64;
+
+struct HexMapFileHeader {
+    char magic[ 8 ];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t endian;
+
+    // Тип ячеек: размер, выравнивание и тег пользователя (0 - не задан)
+    uint32_t cell_size;
+    uint32_t cell_align;
+    uint32_t cell_tag;
+
+    // Расположение гексов
+    int32_t orientation;
+    int32_t offset_type;
+    double size_x;
+    double size_y;
+    double origin_x;
+    double origin_y;
+
+    // Форма карты и порядок хранения ячеек
+    uint32_t by_column;
+    uint32_t order;
+    int32_t major_min;
+    uint32_t reserved;
+    uint64_t rows;
+    uint64_t cell_count;
+
+    // Части файла
+    uint64_t rows_offset;
+    uint64_t cells_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+};
+
+static_assert( sizeof( HexMapFileHeader ) == 136, "HexMapFileHeader layout" );
+
+// Строка формы: первая координата и длина
+struct HexMapFileRow {
+    int32_t minor_min;
+    int32_t length;
+};
+
+// ================================================================
+// Результат проверки файла
+// ================================================================
+enum HexMapFileStatus_t {
+    HEX_MAP_FILE_OK = 0,
+    HEX_MAP_FILE_IO_ERROR,
+    HEX_MAP_FILE_TRUNCATED,
+    HEX_MAP_FILE_BAD_MAGIC,
+    HEX_MAP_FILE_BAD_ENDIAN,
+    HEX_MAP_FILE_BAD_VERSION,
+    HEX_MAP_FILE_BAD_HEADER,
+    HEX_MAP_FILE_BAD_ROWS,
+    HEX_MAP_FILE_BAD_CELL_TYPE,
+    HEX_MAP_FILE_BAD_CHECKSUM
+};
+
+const char* HexMapFileStatusText( HexMapFileStatus_t status );
+
+// ================================================================
+// Контрольная сумма потока байтов (результат не зависит от разбиения на части)
+// ================================================================
+class HexMapFileHasher {
+public:
+    void Update( const void* data, size_t size );
+    uint64_t Value() const;
+
+private:
+    void Mix( uint64_t word ) { state = ( ( ( state << 23 ) | ( state >> 41 ) ) ^ word ) * 0x9e3779b97f4a7c15ULL; }
+
+    uint64_t state = 0;
+    uint64_t length = 0;
+
+    // Неполное 8-байтовое слово
+    unsigned char pending[ 8 ] = {};
+};
+
+// ================================================================
+// Файл, отображённый в память (только чтение)
+// ================================================================
+class HexMappedFile {
+public:
+    HexMappedFile() : data( nullptr ), size( 0 ) {}
+    ~HexMappedFile() { Close(); }
+
+    HexMappedFile( HexMappedFile&& other ) noexcept : data( other.data ), size( other.size ) {
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    HexMappedFile& operator =( HexMappedFile&& other ) noexcept;
+
+    HexMappedFile( const HexMappedFile& ) = delete;
+    HexMappedFile& operator =( const HexMappedFile& ) = delete;
+
+    // Отображение файла path (false - ошибка ввода-вывода)
+    bool Open( const string& path );
+    void Close();
+
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char* data;
+    size_t size;
+};
+
+// ================================================================
+// Проверка файла карты в памяти
+// ================================================================
+// cell_size = 0: тип ячеек не проверяется; cell_tag = 0: тег не
+// проверяется; checksum = false: данные ячеек не читаются (проверка
+// заголовка и таблицы строк)
+// ================================================================
+HexMapFileStatus_t HexMapFileCheck( const unsigned char* data, size_t size, uint32_t cell_size = 0, uint32_t cell_align = 0,
+                                    uint32_t cell_tag = 0, bool checksum = false );
+
+// Полная проверка файла карты path (с контрольной суммой)
+HexMapFileStatus_t HexMapFileValidate( const string& path, uint32_t cell_size = 0, uint32_t cell_align = 0, uint32_t cell_tag = 0 );
+
+// ================================================================
+// Открытие файла карты с проверкой заголовка и таблицы строк
+// ================================================================
+// Ошибка - исключение std::runtime_error с описанием
+// ================================================================
+HexMappedFile HexMapFileOpen( const string& path, uint32_t cell_size, uint32_t cell_align, uint32_t cell_tag );
+
+// Расположение гексов и форма карты по проверенному файлу
+HexLayout HexMapFileLayout( const HexMapFileHeader& header );
+HexMapShape HexMapFileShape( const unsigned char* data );
+
+// ================================================================
+// Карта гексов из файла: данные ячеек используются на месте
+// ================================================================
+// Открытие выполняет O(количество строк) работы ( HEX_MAP_ORDER_MORTON -
+// дополнительно построение тайлов формы), данные ячеек не читаются
+// и не копируются до первого обращения. Интерфейс чтения совпадает
+// с HexMap<T>
+// ================================================================
+template<class T>
+class HexMapFileView {
+public:
+    static_assert( std::is_trivially_copyable<T>::value, "HexMapFileView cell type must be trivially copyable." );
+    static_assert( alignof( T ) <= HEX_MAP_FILE_ALIGN, "HexMapFileView cell type alignment is too large." );
+
+    explicit HexMapFileView( const string& path, uint32_t cell_tag = 0 ) :
+        file( HexMapFileOpen( path, sizeof( T ), alignof( T ), cell_tag ) ), layout( HexMapFileLayout( Header() ) ),
+        shape( HexMapFileShape( file.Data() ) ), cells( reinterpret_cast<const T*>( file.Data() + Header().cells_offset ) ) {}
+
+    // Заголовок файла
+    const HexMapFileHeader& Header() const { return *reinterpret_cast<const HexMapFileHeader*>( file.Data() ); }
+
+    // Расположение гексов
+    const HexLayout& Layout() const { return layout; }
+
+    // Форма карты
+    const HexMapShape& Shape() const { return shape; }
+
+    // Количество ячеек
+    size_t Size() const { return shape.Size(); }
+
+    // Гекс принадлежит карте
+    bool Contains( const Hex& hex ) const { return shape.Contains( hex ); }
+
+    // Индекс ячейки (гекс должен принадлежать карте)
+    size_t Index( const Hex& hex ) const { return shape.Index( hex ); }
+
+    // Данные ячейки (гекс должен принадлежать карте)
+    const T& operator []( const Hex& hex ) const { return cells[ shape.Index( hex ) ]; }
+
+    // Данные ячейки с проверкой границ
+    const T& At( const Hex& hex ) const {
+        if ( !shape.Contains( hex ) ) {
+            throw std::out_of_range( "Hex is out of HexMapFileView." );
+        }
+
+        return cells[ shape.Index( hex ) ];
+    }
+
+    // Данные ячейки или nullptr, если гекс вне карты
+    const T* Find( const Hex& hex ) const { return ( shape.Contains( hex ) ? &cells[ shape.Index( hex ) ] : nullptr ); }
+
+    // Данные ячейки по индексу
+    const T& Cell( size_t index ) const { return cells[ index ]; }
+
+    // Непрерывный массив данных
+    const T* Data() const { return cells; }
+
+    // Обход ячеек в порядке хранения
+    using Iterator = typename HexMap<T>::template Iterator<const T>;
+
+    Iterator begin() const { return Iterator( shape, cells, 0 ); }
+    Iterator end() const { return Iterator( shape, cells, shape.Parts() ); }
+
+private:
+    HexMappedFile file;
+    HexLayout layout;
+    HexMapShape shape;
+    const T* cells;
+};
+
+// ================================================================
+// Потоковая запись файла карты (общая часть)
+// ================================================================
+// Данные ячеек записываются по порядку индексов формы, Finish()
+// дописывает заголовок; файл без Finish() не открывается.
+// Ошибка - исключение std::runtime_error
+// ================================================================
+class HexMapFileOutput {
+public:
+    HexMapFileOutput( const string& path, const HexLayout& layout, const HexMapShape& shape,
+                      uint32_t cell_size, uint32_t cell_align, uint32_t cell_tag );
+    ~HexMapFileOutput();
+
+    HexMapFileOutput( const HexMapFileOutput& ) = delete;
+    HexMapFileOutput& operator =( const HexMapFileOutput& ) = delete;
+
+    // Количество записанных ячеек
+    size_t Written() const { return static_cast<size_t>( written / header.cell_size ); }
+
+    // Завершение записи (записаны все ячейки формы)
+    void Finish();
+
+protected:
+    void WriteBytes( const void* data, size_t size );
+
+private:
+    void CheckOpen() const;
+    void Flush();
+    void Fail( const char* what );
+
+    string path;
+    FILE* file;
+    HexMapFileHeader header;
+    HexMapFileHasher hasher;
+
+    // Записано байтов данных ячеек
+    uint64_t written;
+
+    // Буфер записи
+    vector<unsigned char> buffer;
+    size_t buffered;
+};
+
+// ================================================================
+// Потоковая запись файла карты с ячейками типа T
+// ================================================================
+template<class T>
+class HexMapFileWriter : public HexMapFileOutput {
+public:
+    static_assert( std::is_trivially_copyable<T>::value, "HexMapFileWriter cell type must be trivially copyable." );
+    static_assert( alignof( T ) <= HEX_MAP_FILE_ALIGN, "HexMapFileWriter cell type alignment is too large." );
+
+    HexMapFileWriter( const string& path, const HexLayout& layout, const HexMapShape& shape, uint32_t cell_tag = 0 ) :
+        HexMapFileOutput( path, layout, shape, sizeof( T ), alignof( T ), cell_tag ) {}
+
+    void Write( const T& value ) { WriteBytes( &value, sizeof( T ) ); }
+    void Write( const T* values, size_t count ) { WriteBytes( values, count * sizeof( T ) ); }
+};
+
+// Запись карты целиком
+template<class T>
+void HexMapFileSave( const string& path, const HexLayout& layout, const HexMap<T>& map, uint32_t cell_tag = 0 ) {
+    HexMapFileWriter<T> writer( path, layout, map.Shape(), cell_tag );
+    writer.Write( map.Data(), map.Size() );
+    writer.Finish();
+}
+
+#endif // HEXMAPFILE_H
@@ -0,0 +1,137 @@
+/*
+ * HexMorton.h
+ *
+ * Код Мортона (Z-порядок) для осевых координат гексов
+ */
+
+#pragma once
+#ifndef HEXMORTON_H
+#define HEXMORTON_H
+
+#include "HexGrid.h"
+
+#include <bitset>
+#include <cstdint>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#elif defined( __BMI2__ )
+#include <immintrin.h>
+#endif
+
+// ================================================================
+// Разрежение битов: бит i числа value => бит 2i результата
+// ================================================================
+constexpr uint64_t HexMortonSpread( uint32_t value ) {
+    uint64_t x = value;
+    x = ( x | ( x << 16 ) ) & 0x0000FFFF0000FFFFULL;
+    x = ( x | ( x << 8 ) ) & 0x00FF00FF00FF00FFULL;
+    x = ( x | ( x << 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+    x = ( x | ( x << 2 ) ) & 0x3333333333333333ULL;
+    x = ( x | ( x << 1 ) ) & 0x5555555555555555ULL;
+    return x;
+}
+
+// ================================================================
+// Сжатие битов: бит 2i числа code => бит i результата
+// ================================================================
+constexpr uint32_t HexMortonCompact( uint64_t code ) {
+    uint64_t x = code & 0x5555555555555555ULL;
+    x = ( x | ( x >> 1 ) ) & 0x3333333333333333ULL;
+    x = ( x | ( x >> 2 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+    x = ( x | ( x >> 4 ) ) & 0x00FF00FF00FF00FFULL;
+    x = ( x | ( x >> 8 ) ) & 0x0000FFFF0000FFFFULL;
+    x = ( x | ( x >> 16 ) ) & 0x00000000FFFFFFFFULL;
+    return static_cast<uint32_t>( x );
+}
+
+// ================================================================
+// Код Мортона гекса
+// ================================================================
+// Биты Q (со смещением 2^31) - чётные, биты R - нечётные, поэтому
+// порядок кодов сохраняет близость гексов в осевых координатах:
+// гексы квадрата 2^k x 2^k (по Q и R) идут подряд
+// ================================================================
+constexpr uint64_t HexMortonEncode( const Hex& hex ) {
+    return HexMortonSpread( static_cast<uint32_t>( hex.Q() ) ^ 0x80000000U )
+           | ( HexMortonSpread( static_cast<uint32_t>( hex.R() ) ^ 0x80000000U ) << 1 );
+}
+
+// ================================================================
+// Гекс по коду Мортона
+// ================================================================
+constexpr Hex HexMortonDecode( uint64_t code ) {
+    return Hex( static_cast<int>( HexMortonCompact( code ) ^ 0x80000000U ),
+                static_cast<int>( HexMortonCompact( code >> 1 ) ^ 0x80000000U ) );
+}
+
+// ================================================================
+// Количество единичных битов
+// ================================================================
+// __builtin_popcountll компилируется и без инструкции POPCNT
+// (сборка без -march), std::bitset - для остальных компиляторов
+// ================================================================
+inline int HexPopCount( uint64_t value ) {
+#if defined( __GNUC__ )
+    return __builtin_popcountll( value );
+#else
+    return static_cast<int>( std::bitset<64>( value ).count() );
+#endif
+}
+
+// ================================================================
+// Номер младшего единичного бита (value != 0)
+// ================================================================
+inline int HexLowestBit( uint64_t value ) {
+#if defined( __GNUC__ )
+    return __builtin_ctzll( value );
+#elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_ARM64 ) )
+    unsigned long bit = 0;
+    _BitScanForward64( &bit, value );
+    return static_cast<int>( bit );
+#else
+    int bit = 0;
+
+    for ( ; ( value & 1 ) == 0; value >>= 1 ) {
+        ++bit;
+    }
+
+    return bit;
+#endif
+}
+
+// ================================================================
+// Номер k-го (с нуля) единичного бита (k < HexPopCount( value ))
+// ================================================================
+// С BMI2 - pdep, иначе без циклов по всем битам: суммы единиц по
+// байтам (умножение на 0x0101...) определяют байт, затем k-й бит
+// ищется в одном байте (не более 7 шагов)
+// ================================================================
+inline int HexSelectBit( uint64_t value, int k ) {
+#if defined( __GNUC__ ) && defined( __BMI2__ )
+    return __builtin_ctzll( _pdep_u64( uint64_t( 1 ) << k, value ) );
+#else
+    const uint64_t ones = 0x0101010101010101ULL;
+    uint64_t bytes = value - ( ( value >> 1 ) & 0x5555555555555555ULL );
+    bytes = ( bytes & 0x3333333333333333ULL ) + ( ( bytes >> 2 ) & 0x3333333333333333ULL );
+    bytes = ( bytes + ( bytes >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+
+    // Байт i - количество единиц в байтах 0..i (не больше 64, поэтому
+    // вычитание k + 1 из байтов со старшим битом не даёт заёмов)
+    const uint64_t prefix = bytes * ones;
+    const uint64_t above = ( ( prefix | ( ones << 7 ) ) - ones * static_cast<uint64_t>( k + 1 ) ) & ( ones << 7 );
+    const int shift = HexLowestBit( above ) & ~7;
+
+    // Единицы в младших байтах
+    k -= static_cast<int>( ( ( prefix << 8 ) >> shift ) & 0xFF );
+    uint64_t byte = ( value >> shift ) & 0xFF;
+
+    for ( ; k != 0; --k ) {
+        byte &= byte - 1;
+    }
+
+    return shift + HexLowestBit( byte );
+#endif
+}
+
+#endif // HEXMORTON_H
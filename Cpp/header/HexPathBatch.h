@@ -0,0 +1,86 @@
+/*
+ * HexPathBatch.h
+ *
+ * Параллельное решение пакета запросов поиска пути
+ */
+
+#pragma once
+#ifndef HEXPATHBATCH_H
+#define HEXPATHBATCH_H
+
+#include "HexGrid.h"
+#include "HexMap.h"
+#include "HexPathfinder.h"
+#include "HexThreadPool.h"
+
+#include <cstddef>
+#include <memory>
+
+// ================================================================
+// Запрос поиска пути
+// ================================================================
+struct HexPathQuery {
+    Hex start;
+    Hex goal;
+};
+
+// ================================================================
+// Результат запроса поиска пути
+// ================================================================
+struct HexPathResult {
+    HexPathStats stats;
+    vector<Hex> path;
+};
+
+// ================================================================
+// Пакетный поиск пути на общей карте
+// ================================================================
+// Запросы распределяются между потоками пула, у каждого потока
+// собственное состояние поиска (HexPathfinder). Результаты
+// записываются в порядке запросов; при повторном использовании
+// вектора результатов память путей переиспользуется.
+// Функция стоимости вызывается из нескольких потоков одновременно
+// и не должна изменять общие данные
+// ================================================================
+class HexPathBatch {
+public:
+    HexPathBatch( const HexMapShape& shape, HexThreadPool& pool_, float min_cost = 1.0f ) : pool( pool_ ) {
+        for ( unsigned thread = 0; thread != pool.ThreadCount(); ++thread ) {
+            pathfinders.emplace_back( new HexPathfinder( shape, min_cost ) );
+        }
+    }
+
+    // Пул потоков
+    HexThreadPool& Pool() const { return pool; }
+
+    // ================================================================
+    // Решение пакета запросов
+    // ================================================================
+    template<class CostFunc>
+    void Solve( const vector<HexPathQuery>& queries, CostFunc cost, vector<HexPathResult>& results,
+                HexPathAlgorithm_t algorithm = HEX_PATH_ASTAR ) {
+        results.resize( queries.size() );
+
+        pool.ParallelFor( queries.size(), [&]( size_t index, unsigned thread ) {
+            HexPathResult& result = results[ index ];
+            result.stats = pathfinders[ thread ]->FindPath( queries[ index ].start, queries[ index ].goal,
+                                                            cost, result.path, algorithm );
+        } );
+    }
+
+    // ================================================================
+    // Решение пакета запросов по карте стоимостей
+    // ================================================================
+    void Solve( const vector<HexPathQuery>& queries, const HexMap<float>& costs, vector<HexPathResult>& results,
+                HexPathAlgorithm_t algorithm = HEX_PATH_ASTAR ) {
+        Solve( queries, [&costs]( const Hex&, size_t index ) { return costs.Cell( index ); }, results, algorithm );
+    }
+
+private:
+    HexThreadPool& pool;
+
+    // Состояние поиска каждого потока
+    vector<std::unique_ptr<HexPathfinder>> pathfinders;
+};
+
+#endif // HEXPATHBATCH_H
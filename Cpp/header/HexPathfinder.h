@@ -0,0 +1,350 @@
+/*
+ * HexPathfinder.h
+ *
+ * Поиск пути на карте гексов (A*, Дейкстра, двунаправленные варианты)
+ */
+
+#pragma once
+#ifndef HEXPATHFINDER_H
+#define HEXPATHFINDER_H
+
+#include "HexGrid.h"
+#include "HexIndexedHeap.h"
+#include "HexMap.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// ================================================================
+// Стоимость входа в непроходимую ячейку
+// ================================================================
+constexpr float HEX_PATH_BLOCKED = std::numeric_limits<float>::infinity();
+
+// ================================================================
+// Алгоритм поиска пути
+// ================================================================
+// HEX_PATH_ASTAR = A* (эвристика - HexDistance)
+// HEX_PATH_DIJKSTRA = Дейкстра
+// HEX_PATH_BIDIRECTIONAL_ASTAR = Двунаправленный A*
+// HEX_PATH_BIDIRECTIONAL_DIJKSTRA = Двунаправленный Дейкстра
+// ================================================================
+enum HexPathAlgorithm_t {
+    HEX_PATH_ASTAR = 0,
+    HEX_PATH_DIJKSTRA = 1,
+    HEX_PATH_BIDIRECTIONAL_ASTAR = 2,
+    HEX_PATH_BIDIRECTIONAL_DIJKSTRA = 3
+};
+
+// ================================================================
+// Результат поиска пути
+// ================================================================
+struct HexPathStats {
+    // Путь найден
+    bool found = false;
+
+    // Стоимость пути (сумма стоимостей входа в ячейки, кроме начальной)
+    float cost = HEX_PATH_BLOCKED;
+
+    // Количество раскрытых вершин
+    size_t nodes_expanded = 0;
+};
+
+// ================================================================
+// Поиск пути на карте гексов
+// ================================================================
+// Состояние поиска (массивы вершин, куча) хранится в объекте и
+// переиспользуется: повторные запросы не выделяют память.
+// Вершина - 12 байт на ячейку (гекс открытой вершины хранится в куче,
+// по индексу восстанавливаются только гексы найденного пути),
+// состояние обратного направления выделяется при первом
+// двунаправленном запросе.
+// Вершины помечаются номером запроса, поэтому очистка массивов
+// между запросами не требуется.
+// Стоимость входа в ячейку задаёт функция cost( hex, index ),
+// где index - индекс ячейки в форме карты; HEX_PATH_BLOCKED - непроходима.
+// Для A* стоимость входа в проходимую ячейку должна быть не меньше min_cost
+// ================================================================
+class HexPathfinder {
+public:
+    explicit HexPathfinder( const HexMapShape& shape_, float min_cost_ = 1.0f ) :
+        shape( shape_ ), min_cost( min_cost_ ), forward( shape_.Size() ), backward( 0 ) {}
+
+    // Форма карты
+    const HexMapShape& Shape() const { return shape; }
+
+    // ================================================================
+    // Поиск пути от start до goal, путь записывается в path (включая start и goal)
+    // ================================================================
+    template<class CostFunc>
+    HexPathStats FindPath( const Hex& start, const Hex& goal, CostFunc cost, vector<Hex>& path,
+                           HexPathAlgorithm_t algorithm = HEX_PATH_ASTAR ) {
+        path.clear();
+        HexPathStats stats;
+
+        if ( !shape.Contains( start ) || !shape.Contains( goal ) || !( cost( goal, shape.Index( goal ) ) < HEX_PATH_BLOCKED ) ) {
+            return stats;
+        }
+
+        if ( start == goal ) {
+            path.push_back( start );
+            stats.found = true;
+            stats.cost = 0.0f;
+            return stats;
+        }
+
+        const bool heuristic = ( algorithm == HEX_PATH_ASTAR || algorithm == HEX_PATH_BIDIRECTIONAL_ASTAR );
+
+        if ( algorithm == HEX_PATH_ASTAR || algorithm == HEX_PATH_DIJKSTRA ) {
+            return Search( start, goal, cost, path, heuristic );
+        } else {
+            return BidirectionalSearch( start, goal, cost, path, heuristic );
+        }
+    }
+
+    // ================================================================
+    // Поиск пути по карте стоимостей
+    // ================================================================
+    HexPathStats FindPath( const Hex& start, const Hex& goal, const HexMap<float>& costs, vector<Hex>& path,
+                           HexPathAlgorithm_t algorithm = HEX_PATH_ASTAR ) {
+        return FindPath( start, goal, [&costs]( const Hex&, size_t index ) { return costs.Cell( index ); },
+                         path, algorithm );
+    }
+
+private:
+    // Отсутствующая вершина
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    // Вершина поиска (гекс - в куче, для пути - shape.HexAt( index ))
+    struct Node {
+        float g;
+        uint32_t parent;
+        uint32_t generation;
+    };
+
+    // ================================================================
+    // Одно направление поиска: вершины и куча открытых вершин
+    // ================================================================
+    class Side {
+    public:
+        explicit Side( size_t size ) : nodes( size ), heap( size ), generation( 0 ) {
+            for ( Node& node : nodes ) {
+                node.generation = 0;
+            }
+        }
+
+        // Выделение вершин и кучи на size ячеек (если ещё не выделены)
+        void Allocate( size_t size ) {
+            if ( nodes.size() != size ) {
+                *this = Side( size );
+            }
+        }
+
+        // Новый запрос
+        void Reset( const Hex& target_, float scale_ ) {
+            heap.Clear();
+            target = target_;
+            scale = scale_;
+
+            if ( ++generation == 0 ) {
+                for ( Node& node : nodes ) {
+                    node.generation = 0;
+                }
+
+                generation = 1;
+            }
+        }
+
+        // Эвристика
+        float H( const Hex& hex ) const { return scale * HexDistance( hex, target ); }
+
+        bool Visited( uint32_t index ) const { return nodes[ index ].generation == generation; }
+        bool Empty() const { return heap.Empty(); }
+        size_t OpenCount() const { return heap.Size(); }
+        float TopF() const { return heap.TopKey(); }
+        Node& At( uint32_t index ) { return nodes[ index ]; }
+
+        // Улучшение вершины: возвращает true, если g уменьшилось
+        bool Relax( uint32_t index, const Hex& hex, float g, uint32_t parent ) {
+            Node& node = nodes[ index ];
+
+            if ( node.generation != generation ) {
+                node.generation = generation;
+                node.g = g;
+                node.parent = parent;
+                heap.Push( index, g + H( hex ), hex );
+                return true;
+            }
+
+            // Закрытые вершины (извлечённые из кучи) не пересматриваются
+            if ( !( g < node.g ) || !heap.Contains( index ) ) {
+                return false;
+            }
+
+            node.g = g;
+            node.parent = parent;
+            heap.Decrease( index, g + H( hex ) );
+            return true;
+        }
+
+        // Извлечение вершины с наименьшим f (вершина закрывается) и её гекс
+        uint32_t Pop( Hex& hex ) {
+            hex = heap.TopHex();
+            return heap.Pop();
+        }
+
+    private:
+        vector<Node> nodes;
+        HexIndexedHeap heap;
+        uint32_t generation;
+        Hex target;
+        float scale = 0.0f;
+    };
+
+    // ================================================================
+    // Однонаправленный поиск (A* или Дейкстра)
+    // ================================================================
+    template<class CostFunc>
+    HexPathStats Search( const Hex& start, const Hex& goal, CostFunc& cost, vector<Hex>& path, bool heuristic ) {
+        HexPathStats stats;
+        const uint32_t goal_index = static_cast<uint32_t>( shape.Index( goal ) );
+        forward.Reset( goal, heuristic ? min_cost : 0.0f );
+        forward.Relax( static_cast<uint32_t>( shape.Index( start ) ), start, 0.0f, NONE );
+
+        while ( !forward.Empty() ) {
+            Hex hex;
+            const uint32_t index = forward.Pop( hex );
+            ++stats.nodes_expanded;
+
+            if ( index == goal_index ) {
+                stats.found = true;
+                stats.cost = forward.At( index ).g;
+                AppendPath( forward, index, path );
+                std::reverse( path.begin(), path.end() );
+                return stats;
+            }
+
+            const float g = forward.At( index ).g;
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                const Hex neighbor = hex + direction;
+
+                if ( !shape.Contains( neighbor ) ) {
+                    continue;
+                }
+
+                const size_t neighbor_index = shape.Index( neighbor );
+                const float step = cost( neighbor, neighbor_index );
+
+                if ( step < HEX_PATH_BLOCKED ) {
+                    forward.Relax( static_cast<uint32_t>( neighbor_index ), neighbor, g + step, index );
+                }
+            }
+        }
+
+        return stats;
+    }
+
+    // ================================================================
+    // Двунаправленный поиск
+    // ================================================================
+    // Прямой поиск от start, обратный от goal; расширяется направление
+    // с меньшим числом открытых вершин. Поиск завершается, когда
+    // наименьшее f любого направления не меньше стоимости лучшего
+    // найденного пути (эвристика согласованная)
+    // ================================================================
+    template<class CostFunc>
+    HexPathStats BidirectionalSearch( const Hex& start, const Hex& goal, CostFunc& cost, vector<Hex>& path, bool heuristic ) {
+        HexPathStats stats;
+        const uint32_t start_index = static_cast<uint32_t>( shape.Index( start ) );
+        const uint32_t goal_index = static_cast<uint32_t>( shape.Index( goal ) );
+        backward.Allocate( shape.Size() );
+        forward.Reset( goal, heuristic ? min_cost : 0.0f );
+        backward.Reset( start, heuristic ? min_cost : 0.0f );
+        forward.Relax( start_index, start, 0.0f, NONE );
+        backward.Relax( goal_index, goal, 0.0f, NONE );
+
+        float best = HEX_PATH_BLOCKED;
+        uint32_t meet = NONE;
+
+        while ( !forward.Empty() && !backward.Empty() ) {
+            if ( forward.TopF() >= best || backward.TopF() >= best
+                    || ( !heuristic && forward.TopF() + backward.TopF() >= best ) ) {
+                break;
+            }
+
+            const bool is_forward = ( forward.OpenCount() <= backward.OpenCount() );
+            Side& side = ( is_forward ? forward : backward );
+            Side& other = ( is_forward ? backward : forward );
+
+            Hex hex;
+            const uint32_t index = side.Pop( hex );
+            ++stats.nodes_expanded;
+
+            const float g = side.At( index ).g;
+
+            // Обратный поиск: ребро neighbor -> hex стоит cost( hex )
+            const float backward_step = ( is_forward ? 0.0f : cost( hex, index ) );
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                const Hex neighbor = hex + direction;
+
+                if ( !shape.Contains( neighbor ) ) {
+                    continue;
+                }
+
+                const uint32_t neighbor_index = static_cast<uint32_t>( shape.Index( neighbor ) );
+                float step;
+
+                if ( is_forward ) {
+                    step = cost( neighbor, neighbor_index );
+                } else {
+                    // В начальную ячейку не входят, её стоимость не учитывается
+                    step = ( neighbor_index == start_index || cost( neighbor, neighbor_index ) < HEX_PATH_BLOCKED
+                             ? backward_step : HEX_PATH_BLOCKED );
+                }
+
+                if ( !( step < HEX_PATH_BLOCKED ) || !side.Relax( neighbor_index, neighbor, g + step, index ) ) {
+                    continue;
+                }
+
+                if ( other.Visited( neighbor_index ) && g + step + other.At( neighbor_index ).g < best ) {
+                    best = g + step + other.At( neighbor_index ).g;
+                    meet = neighbor_index;
+                }
+            }
+        }
+
+        if ( meet == NONE ) {
+            return stats;
+        }
+
+        stats.found = true;
+        stats.cost = best;
+        AppendPath( forward, meet, path );
+        std::reverse( path.begin(), path.end() );
+        path.pop_back();
+        AppendPath( backward, meet, path );
+        return stats;
+    }
+
+    // Добавление в path вершин от index по цепочке родителей
+    void AppendPath( Side& side, uint32_t index, vector<Hex>& path ) const {
+        for ( ; index != NONE; index = side.At( index ).parent ) {
+            path.push_back( shape.HexAt( index ) );
+        }
+    }
+
+    // Форма карты
+    const HexMapShape shape;
+
+    // Минимальная стоимость входа в ячейку (масштаб эвристики)
+    const float min_cost;
+
+    // Прямое и обратное (пустое до первого двунаправленного запроса) направления поиска
+    Side forward;
+    Side backward;
+};
+
+#endif // HEXPATHFINDER_H
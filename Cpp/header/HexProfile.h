@@ -0,0 +1,123 @@
+/*
+ * HexProfile.h
+ *
+ * Счётчики вызовов, выделений памяти и времени функций библиотеки
+ */
+
+#pragma once
+#ifndef HEXPROFILE_H
+#define HEXPROFILE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+using std::string;
+
+// ================================================================
+// Включение счётчиков (по умолчанию выключены)
+// ================================================================
+// Определяется при сборке библиотеки ( CMake: -DHEXGRID_PROFILE=ON ).
+// Без HEX_PROFILE точки замера не компилируются, функции ниже
+// доступны и возвращают нули
+// ================================================================
+#ifndef HEX_PROFILE
+#define HEX_PROFILE 0
+#endif
+
+// ================================================================
+// Точки замера (открытые функции библиотеки)
+// ================================================================
+enum HexProfilePoint_t {
+    HEX_PROFILE_HEX_NEIGHBORS = 0,
+    HEX_PROFILE_HEX_DIAGONALS,
+    HEX_PROFILE_HEX_TO_PIXEL,
+    HEX_PROFILE_PIXEL_TO_HEX,
+    HEX_PROFILE_HEX_CORNERS,
+    HEX_PROFILE_ROUND,
+    HEX_PROFILE_HEX_LINE,
+    HEX_PROFILE_OFFSET_TO_CUBE,
+    HEX_PROFILE_CUBE_TO_OFFSET,
+    HEX_PROFILE_PIXEL_TO_HEX_BATCH,
+    HEX_PROFILE_HEX_TO_PIXEL_BATCH,
+    HEX_PROFILE_HEX_CORNERS_BATCH,
+    HEX_PROFILE_OFFSET_TO_CUBE_BATCH,
+    HEX_PROFILE_CUBE_TO_OFFSET_BATCH,
+    HEX_PROFILE_POINT_COUNT
+};
+
+// ================================================================
+// Результат точки замера
+// ================================================================
+// Время и выделения памяти включают вложенные вызовы
+// (например, HexLine включает FractionalHex::Round)
+// ================================================================
+struct HexProfileStats {
+    uint64_t calls = 0;
+    uint64_t allocations = 0;
+    uint64_t nanoseconds = 0;
+};
+
+// Счётчики скомпилированы в библиотеку
+bool HexProfileEnabled();
+
+// Название точки замера (имя функции)
+const char* HexProfilePointName( HexProfilePoint_t point );
+
+// ================================================================
+// Сумма счётчиков всех потоков с момента HexProfileReset()
+// ================================================================
+// Каждый поток увеличивает только свои счётчики (без блокировок
+// и атомарных операций чтения-изменения-записи), запрос складывает
+// счётчики потоков, счётчики завершившихся потоков сохраняются
+// ================================================================
+HexProfileStats HexProfileGet( HexProfilePoint_t point );
+
+// Обнуление результатов (запоминаются текущие значения счётчиков)
+void HexProfileReset();
+
+// ================================================================
+// Результаты в формате JSON:
+// { "enabled": true, "points": [ { "name": "HexLine", "calls": 1,
+//   "allocations": 1, "nanoseconds": 250 }, ... ] }
+// ================================================================
+void HexProfileDump( std::ostream& os );
+string HexProfileJSON();
+
+// ================================================================
+// Выделение памяти в текущем потоке
+// ================================================================
+// Библиотека не заменяет operator new: приложение, которому нужны
+// выделения памяти по точкам замера, вызывает HexProfileAllocation()
+// из своего operator new. Без HEX_PROFILE - пустая функция
+// ================================================================
+void HexProfileAllocation();
+
+#if HEX_PROFILE
+
+// ================================================================
+// Замер вызова: от создания до разрушения объекта
+// ================================================================
+class HexProfileScope {
+public:
+    explicit HexProfileScope( HexProfilePoint_t point_ );
+    ~HexProfileScope();
+
+    HexProfileScope( const HexProfileScope& ) = delete;
+    HexProfileScope& operator =( const HexProfileScope& ) = delete;
+
+private:
+    const HexProfilePoint_t point;
+    const uint64_t allocations;
+    const int64_t start;
+};
+
+#define HEX_PROFILE_SCOPE( point ) const HexProfileScope hex_profile_scope( point )
+
+#else
+
+#define HEX_PROFILE_SCOPE( point ) ( (void) 0 )
+
+#endif // HEX_PROFILE
+
+#endif // HEXPROFILE_H
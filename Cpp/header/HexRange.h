@@ -0,0 +1,290 @@
+/*
+ * HexRange.h
+ *
+ * Области гексов: диапазон, кольцо и спираль (без выделения памяти)
+ */
+
+#pragma once
+#ifndef HEXRANGE_H
+#define HEXRANGE_H
+
+#include "HexGrid.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+// Итераторы HexRange, HexRing и HexSpiral вычисляют гекс на лету и возвращают
+// его по значению (как std::ranges::iota_view), поэтому объявлены как input:
+// forward-итератор обязан возвращать ссылку на объект, живущий дольше итератора
+
+// ================================================================
+// Количество гексов на расстоянии не более radius
+// ================================================================
+constexpr size_t HexRangeSize( int radius ) {
+    return ( radius < 0 ? 0 : 3 * static_cast<size_t>( radius ) * ( radius + 1 ) + 1 );
+}
+
+// ================================================================
+// Количество гексов на расстоянии ровно radius
+// ================================================================
+constexpr size_t HexRingSize( int radius ) {
+    return ( radius < 0 ? 0 : ( radius == 0 ? 1 : 6 * static_cast<size_t>( radius ) ) );
+}
+
+// ================================================================
+// Диапазон: все гексы на расстоянии не более radius от center
+// ================================================================
+// Порядок: по возрастанию Q, внутри - по возрастанию R
+// ================================================================
+class HexRange {
+public:
+    constexpr HexRange( const Hex& center_, int radius_ ) : center( center_ ), radius( radius_ ) {}
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Hex;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Hex;
+
+        constexpr Iterator( const Hex& center_, int radius_, size_t index_ ) :
+            center( center_ ), radius( radius_ ), dq( -radius_ ), dr( 0 ), dr_max( 0 ), index( index_ ) {
+            StartColumn();
+        }
+
+        constexpr Hex operator *() const { return Hex( center.Q() + dq, center.R() + dr ); }
+
+        constexpr Iterator& operator ++() {
+            ++index;
+
+            if ( ++dr > dr_max ) {
+                ++dq;
+                StartColumn();
+            }
+
+            return *this;
+        }
+
+        constexpr Iterator operator ++( int ) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        constexpr bool operator ==( const Iterator& other ) const { return index == other.index; }
+        constexpr bool operator !=( const Iterator& other ) const { return index != other.index; }
+
+    private:
+        constexpr void StartColumn() {
+            dr = std::max( -radius, -dq - radius );
+            dr_max = std::min( radius, -dq + radius );
+        }
+
+        Hex center;
+        int radius;
+        int dq;
+        int dr;
+        int dr_max;
+        size_t index;
+    };
+
+    constexpr Iterator begin() const { return Iterator( center, radius, 0 ); }
+    constexpr Iterator end() const { return Iterator( center, radius, Size() ); }
+
+    // Количество гексов
+    constexpr size_t Size() const { return HexRangeSize( radius ); }
+
+    // Запись гексов в буфер (не менее Size() элементов), возвращает количество
+    size_t CopyTo( Hex* out ) const {
+        Hex* const first = out;
+
+        for ( int dq = -radius; dq <= radius; ++dq ) {
+            const int dr_min = std::max( -radius, -dq - radius );
+            const int dr_max = std::min( radius, -dq + radius );
+
+            for ( int dr = dr_min; dr <= dr_max; ++dr ) {
+                *out++ = Hex( center.Q() + dq, center.R() + dr );
+            }
+        }
+
+        return out - first;
+    }
+
+private:
+    Hex center;
+    int radius;
+};
+
+// ================================================================
+// Кольцо: все гексы на расстоянии ровно radius от center
+// ================================================================
+// Порядок: от гекса center + HexDirection( 4 ) * radius
+// по сторонам кольца в направлениях 0..5
+// ================================================================
+class HexRing {
+public:
+    constexpr HexRing( const Hex& center_, int radius_ ) : center( center_ ), radius( radius_ ) {}
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Hex;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Hex;
+
+        constexpr Iterator( const Hex& center, int radius_, size_t index_ ) :
+            hex( center + HexDirection( 4 ) * radius_ ), radius( radius_ ), side( 0 ), step( 0 ), index( index_ ) {}
+
+        constexpr Hex operator *() const { return hex; }
+
+        constexpr Iterator& operator ++() {
+            ++index;
+            hex = hex + HEX_DIRECTIONS[ side ];
+
+            if ( ++step == radius ) {
+                step = 0;
+                ++side;
+            }
+
+            return *this;
+        }
+
+        constexpr Iterator operator ++( int ) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        constexpr bool operator ==( const Iterator& other ) const { return index == other.index; }
+        constexpr bool operator !=( const Iterator& other ) const { return index != other.index; }
+
+    private:
+        Hex hex;
+        int radius;
+        int side;
+        int step;
+        size_t index;
+    };
+
+    constexpr Iterator begin() const { return Iterator( center, radius, 0 ); }
+    constexpr Iterator end() const { return Iterator( center, radius, Size() ); }
+
+    // Количество гексов
+    constexpr size_t Size() const { return HexRingSize( radius ); }
+
+    // Запись гексов в буфер (не менее Size() элементов), возвращает количество
+    size_t CopyTo( Hex* out ) const {
+        if ( radius <= 0 ) {
+            if ( radius == 0 ) {
+                *out = center;
+            }
+
+            return Size();
+        }
+
+        Hex hex = center + HexDirection( 4 ) * radius;
+
+        for ( const Hex& direction : HEX_DIRECTIONS ) {
+            for ( int step = 0; step != radius; ++step ) {
+                *out++ = hex;
+                hex = hex + direction;
+            }
+        }
+
+        return Size();
+    }
+
+private:
+    Hex center;
+    int radius;
+};
+
+// ================================================================
+// Спираль: center, затем кольца радиусом 1..radius
+// ================================================================
+class HexSpiral {
+public:
+    constexpr HexSpiral( const Hex& center_, int radius_ ) : center( center_ ), radius( radius_ ) {}
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Hex;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Hex;
+
+        constexpr Iterator( const Hex& center_, size_t index_ ) :
+            center( center_ ), hex( center_ ), ring( 0 ), side( 0 ), step( 0 ), index( index_ ) {}
+
+        constexpr Hex operator *() const { return hex; }
+
+        constexpr Iterator& operator ++() {
+            ++index;
+
+            if ( ring == 0 ) {
+                ring = 1;
+                hex = center + HexDirection( 4 );
+                return *this;
+            }
+
+            hex = hex + HEX_DIRECTIONS[ side ];
+
+            if ( ++step == ring ) {
+                step = 0;
+
+                // Кольцо пройдено: гекс вернулся в начало кольца, переходим к следующему
+                if ( ++side == static_cast<int>( HEX_DIRECTION_COUNT ) ) {
+                    ++ring;
+                    side = 0;
+                    hex = hex + HexDirection( 4 );
+                }
+            }
+
+            return *this;
+        }
+
+        constexpr Iterator operator ++( int ) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        constexpr bool operator ==( const Iterator& other ) const { return index == other.index; }
+        constexpr bool operator !=( const Iterator& other ) const { return index != other.index; }
+
+    private:
+        Hex center;
+        Hex hex;
+        int ring;
+        int side;
+        int step;
+        size_t index;
+    };
+
+    constexpr Iterator begin() const { return Iterator( center, 0 ); }
+    constexpr Iterator end() const { return Iterator( center, Size() ); }
+
+    // Количество гексов
+    constexpr size_t Size() const { return HexRangeSize( radius ); }
+
+    // Запись гексов в буфер (не менее Size() элементов), возвращает количество
+    size_t CopyTo( Hex* out ) const {
+        Hex* const first = out;
+
+        for ( int ring = 0; ring <= radius; ++ring ) {
+            out += HexRing( center, ring ).CopyTo( out );
+        }
+
+        return out - first;
+    }
+
+private:
+    Hex center;
+    int radius;
+};
+
+#endif // HEXRANGE_H
@@ -0,0 +1,281 @@
+/*
+ * HexSpatialIndex.h
+ *
+ * Пространственный индекс движущихся объектов на сетке гексов
+ */
+
+#pragma once
+#ifndef HEXSPATIALINDEX_H
+#define HEXSPATIALINDEX_H
+
+#include "HexGrid.h"
+#include "HexBatch.h"
+#include "HexChunkMap.h"
+#include "HexRange.h"
+#include "HexThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// ================================================================
+// Пространственный индекс объектов по гексам
+// ================================================================
+// Объекты задаются номерами 0..capacity-1. Объекты одного гекса
+// образуют двусвязный список (ссылки хранятся в массиве объектов),
+// начала списков хранятся в разреженной карте HexChunkMap, поэтому
+// добавление, перемещение и удаление выполняются за O(1).
+// Запросы не изменяют индекс и могут выполняться параллельно
+// ================================================================
+class HexSpatialIndex {
+public:
+    // Отсутствующий объект
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    explicit HexSpatialIndex( size_t capacity = 0 ) : heads( NONE ), count( 0 ) { Reserve( capacity ); }
+
+    // Увеличение количества номеров объектов
+    void Reserve( size_t capacity ) {
+        if ( capacity > entities.size() ) {
+            entities.resize( capacity );
+        }
+    }
+
+    // Количество номеров объектов
+    size_t Capacity() const { return entities.size(); }
+
+    // Количество объектов в индексе
+    size_t Size() const { return count; }
+
+    // Объект находится в индексе
+    bool Contains( uint32_t id ) const { return id < entities.size() && entities[ id ].present; }
+
+    // Гекс объекта (объект находится в индексе)
+    const Hex& HexOf( uint32_t id ) const { return entities[ id ].hex; }
+
+    // Первый объект гекса (NONE - гекс пуст) и следующий объект того же гекса
+    uint32_t First( const Hex& hex ) const { return heads.Get( hex ); }
+    uint32_t NextInHex( uint32_t id ) const { return entities[ id ].next; }
+
+    // ================================================================
+    // Добавление, перемещение и удаление объекта
+    // ================================================================
+    // Повторное добавление объекта перемещает его,
+    // перемещается только объект, находящийся в индексе
+    // ================================================================
+    void Insert( uint32_t id, const Hex& hex ) {
+        Reserve( static_cast<size_t>( id ) + 1 );
+
+        if ( entities[ id ].present ) {
+            Move( id, hex );
+            return;
+        }
+
+        entities[ id ].present = true;
+        ++count;
+        Link( id, hex );
+    }
+
+    void Insert( uint32_t id, const HexLayout& layout, const Point& point ) {
+        Insert( id, PixelToHex( layout, point ).Round( HEX_ROUND_DEFAULT ) );
+    }
+
+    void Move( uint32_t id, const Hex& hex ) {
+        if ( Contains( id ) && entities[ id ].hex != hex ) {
+            Unlink( id );
+            Link( id, hex );
+        }
+    }
+
+    void Remove( uint32_t id ) {
+        if ( Contains( id ) ) {
+            Unlink( id );
+            entities[ id ].present = false;
+            --count;
+        }
+    }
+
+    // Удаление всех объектов (память карты гексов сохраняется)
+    void Clear() {
+        for ( Entity& entity : entities ) {
+            entity.present = false;
+        }
+
+        ResetHeads();
+        count = 0;
+    }
+
+    // Освобождение чанков без объектов
+    size_t Compact() {
+        return heads.EvictChunks( []( const Hex&, uint32_t* cells ) {
+            return std::all_of( cells, cells + HexChunkMap<uint32_t>::CHUNK_SIZE, []( uint32_t id ) { return id == NONE; } );
+        } );
+    }
+
+    // ================================================================
+    // Вызов func( id, hex ) для объектов на расстоянии не более radius от center
+    // ================================================================
+    template<class Func>
+    void ForEachInRadius( const Hex& center, int radius, Func func ) const {
+        for ( const Hex& hex : HexRange( center, radius ) ) {
+            for ( uint32_t id = heads.Get( hex ); id != NONE; id = entities[ id ].next ) {
+                func( id, hex );
+            }
+        }
+    }
+
+    // Объекты на расстоянии не более radius от center
+    void QueryRadius( const Hex& center, int radius, vector<uint32_t>& result ) const {
+        result.clear();
+        ForEachInRadius( center, radius, [&result]( uint32_t id, const Hex& ) { result.push_back( id ); } );
+    }
+
+    // ================================================================
+    // k ближайших объектов к center (по HexDistance, не дальше max_radius)
+    // ================================================================
+    // Гексы просматриваются кольцами, объекты записываются в порядке
+    // неубывания расстояния (при равенстве - в порядке HexSpiral)
+    // ================================================================
+    void QueryNearest( const Hex& center, size_t k, vector<uint32_t>& result,
+                       int max_radius = std::numeric_limits<int>::max() ) const {
+        result.clear();
+
+        for ( int radius = 0; radius <= max_radius && result.size() < k && result.size() < count; ++radius ) {
+            for ( const Hex& hex : HexRing( center, radius ) ) {
+                for ( uint32_t id = heads.Get( hex ); id != NONE && result.size() < k; id = entities[ id ].next ) {
+                    result.push_back( id );
+                }
+            }
+        }
+    }
+
+    // ================================================================
+    // Пакетное обновление положений объектов 0..size-1
+    // ================================================================
+    // Гексы вычисляются по координатам x, y параллельно (пакетами
+    // PixelToHexBatch), затем перемещаются только объекты, гекс
+    // которых изменился. Отсутствующие в индексе объекты добавляются
+    // ================================================================
+    void Update( const HexLayout& layout, const double* x, const double* y, size_t size, HexThreadPool* pool = nullptr ) {
+        ComputeHexes( layout, x, y, size, pool );
+
+        for ( uint32_t id = 0; id != size; ++id ) {
+            const Hex hex( hex_q[ id ], hex_r[ id ] );
+
+            if ( !entities[ id ].present ) {
+                Insert( id, hex );
+            } else if ( entities[ id ].hex != hex ) {
+                Unlink( id );
+                Link( id, hex );
+            }
+        }
+    }
+
+    // ================================================================
+    // Перестроение индекса по положениям объектов 0..size-1
+    // ================================================================
+    // Гексы вычисляются параллельно, как в Update(), затем списки
+    // гексов строятся заново; все прочие объекты удаляются
+    // ================================================================
+    void Rebuild( const HexLayout& layout, const double* x, const double* y, size_t size, HexThreadPool* pool = nullptr ) {
+        ComputeHexes( layout, x, y, size, pool );
+        Clear();
+
+        for ( uint32_t id = 0; id != size; ++id ) {
+            entities[ id ].present = true;
+            Link( id, Hex( hex_q[ id ], hex_r[ id ] ) );
+        }
+
+        count = size;
+    }
+
+private:
+    // Размер пакета вычисления гексов
+    static constexpr size_t BATCH_SIZE = 4096;
+
+    struct Entity {
+        Hex hex;
+        uint32_t prev = NONE;
+        uint32_t next = NONE;
+        bool present = false;
+    };
+
+    // Добавление объекта в начало списка гекса
+    void Link( uint32_t id, const Hex& hex ) {
+        Entity& entity = entities[ id ];
+        uint32_t& head = heads[ hex ];
+        entity.hex = hex;
+        entity.prev = NONE;
+        entity.next = head;
+
+        if ( head != NONE ) {
+            entities[ head ].prev = id;
+        }
+
+        head = id;
+    }
+
+    // Удаление объекта из списка гекса (объект находится в индексе)
+    void Unlink( uint32_t id ) {
+        Entity& entity = entities[ id ];
+
+        if ( entity.prev != NONE ) {
+            entities[ entity.prev ].next = entity.next;
+        } else {
+            *heads.Find( entity.hex ) = entity.next;
+        }
+
+        if ( entity.next != NONE ) {
+            entities[ entity.next ].prev = entity.prev;
+        }
+
+        entity.prev = NONE;
+        entity.next = NONE;
+    }
+
+    void ResetHeads() {
+        heads.ForEachChunk( []( const Hex&, uint32_t* cells ) {
+            std::fill( cells, cells + HexChunkMap<uint32_t>::CHUNK_SIZE, NONE );
+        } );
+    }
+
+    // Гексы объектов 0..size-1 (параллельно, пакетами)
+    void ComputeHexes( const HexLayout& layout, const double* x, const double* y, size_t size, HexThreadPool* pool ) {
+        Reserve( size );
+        hex_q.resize( size );
+        hex_r.resize( size );
+        const int round_algorithm = HexRoundAlgorithm();
+
+        const auto batch = [&]( size_t index, unsigned ) {
+            const size_t begin = index * BATCH_SIZE;
+            const size_t length = std::min( BATCH_SIZE, size - begin );
+            PixelToHexBatch( layout, x + begin, y + begin, length, &hex_q[ begin ], &hex_r[ begin ], round_algorithm );
+        };
+
+        const size_t batches = ( size + BATCH_SIZE - 1 ) / BATCH_SIZE;
+
+        if ( pool != nullptr ) {
+            pool->ParallelFor( batches, batch );
+        } else {
+            for ( size_t index = 0; index != batches; ++index ) {
+                batch( index, 0 );
+            }
+        }
+    }
+
+    // Объекты
+    vector<Entity> entities;
+
+    // Первый объект каждого гекса
+    HexChunkMap<uint32_t> heads;
+
+    // Количество объектов в индексе
+    size_t count;
+
+    // Гексы пакетного обновления
+    vector<int> hex_q;
+    vector<int> hex_r;
+};
+
+#endif // HEXSPATIALINDEX_H
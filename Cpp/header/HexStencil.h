@@ -0,0 +1,282 @@
+/*
+ * HexStencil.h
+ *
+ * Шаблонные вычисления (клеточные автоматы) на плотной карте гексов
+ */
+
+#pragma once
+#ifndef HEXSTENCIL_H
+#define HEXSTENCIL_H
+
+#include "HexGrid.h"
+#include "HexMap.h"
+#include "HexThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// ================================================================
+// Ячейка при шаге HexStencil: текущие значения ячейки и соседей,
+// следующие значения ячейки
+// ================================================================
+// Соседи адресуются смещениями индекса (направления HEX_DIRECTIONS),
+// гексы не создаются
+// ================================================================
+template<class T, size_t fields>
+class HexStencilCell {
+public:
+    HexStencilCell( const T* const* in_, T* const* out_, const ptrdiff_t* offsets_ ) :
+        in( in_ ), out( out_ ), offsets( offsets_ ), index( 0 ) {}
+
+    // Текущее значение поля ячейки
+    T operator ()( size_t field = 0 ) const { return in[ field ][ index ]; }
+
+    // Текущее значение поля соседа по направлению direction (0..5)
+    T Neighbor( int direction, size_t field = 0 ) const { return in[ field ][ index + offsets[ direction ] ]; }
+
+    // Сумма текущих значений поля шести соседей
+    T NeighborSum( size_t field = 0 ) const {
+        const T* value = in[ field ] + index;
+        return ( value[ offsets[ 0 ] ] + value[ offsets[ 1 ] ] ) + ( value[ offsets[ 2 ] ] + value[ offsets[ 3 ] ] )
+               + ( value[ offsets[ 4 ] ] + value[ offsets[ 5 ] ] );
+    }
+
+    // Следующее значение поля ячейки
+    T& Next( size_t field = 0 ) const { return out[ field ][ index ]; }
+
+    // Индекс ячейки в хранилище HexStencil
+    size_t Index() const { return index; }
+
+private:
+    template<class, size_t>
+    friend class HexStencil;
+
+    const T* const* in;
+    T* const* out;
+    const ptrdiff_t* offsets;
+    size_t index;
+};
+
+// ================================================================
+// Шаблонные вычисления на карте гексов с двойной буферизацией
+// ================================================================
+// Каждое из fields полей хранится отдельным непрерывным массивом
+// (структура массивов) в двух буферах: текущем и следующем.
+// Строки формы дополнены ячейками-границами со значением outside
+// так, что у каждой ячейки формы есть все шесть соседей в памяти,
+// поэтому смещения индексов соседей постоянны в пределах строки и
+// ядро не проверяет границы. Step() вызывает kernel( cell ) для
+// каждой ячейки формы ( HexStencilCell ), ядро записывает следующие
+// значения, после чего буферы меняются местами. Ячейки обходятся
+// плитками ( TILE_ROWS строк x TILE_LENGTH ячеек ) параллельно,
+// ядро должно записывать только следующие значения своей ячейки
+// ================================================================
+template<class T, size_t fields = 1>
+class HexStencil {
+public:
+    static_assert( fields != 0, "HexStencil needs at least one field." );
+
+    // Размер плитки параллельного шага
+    static constexpr size_t TILE_ROWS = 16;
+    static constexpr size_t TILE_LENGTH = 4096;
+
+    explicit HexStencil( const HexMapShape& shape_, const T& outside = T() ) : shape( shape_ ), current( 0 ) {
+        const size_t rows = shape.Rows();
+        const int major_step = ( rows != 0 ? 1 : 0 );
+        padded_min.resize( rows + 2 );
+        padded_start.assign( rows + 3, 0 );
+        row_offsets.resize( rows );
+
+        // Дополненная строка охватывает свою строку и строки-соседи с запасом в одну ячейку
+        for ( size_t padded = 0; padded != rows + 2 * major_step; ++padded ) {
+            int low = 0;
+            int high = -1;
+
+            for ( size_t row = ( padded < 2 ? 0 : padded - 2 ); row != std::min( padded + 1, rows ); ++row ) {
+                if ( shape.RowLength( row ) != 0 ) {
+                    const int row_low = shape.RowMinor( row ) - 1;
+                    const int row_high = shape.RowMinor( row ) + static_cast<int>( shape.RowLength( row ) );
+                    low = ( high < low ? row_low : std::min( low, row_low ) );
+                    high = std::max( high, row_high );
+                }
+            }
+
+            padded_min[ padded ] = low;
+            padded_start[ padded + 1 ] = padded_start[ padded ] + static_cast<size_t>( high - low + 1 );
+        }
+
+        for ( size_t padded = rows + 2 * major_step; padded != rows + 2; ++padded ) {
+            padded_start[ padded + 1 ] = padded_start[ padded ];
+        }
+
+        // Смещения индексов соседей для каждой строки
+        for ( size_t row = 0; row != rows; ++row ) {
+            for ( size_t direction = 0; direction != HEX_DIRECTION_COUNT; ++direction ) {
+                const Hex& step = HEX_DIRECTIONS[ direction ];
+                const int major = ( shape.ByColumn() ? step.Q() : step.R() );
+                const int minor = ( shape.ByColumn() ? step.R() : step.Q() );
+                row_offsets[ row ][ direction ] = RowBase( row + 1 + major ) - RowBase( row + 1 ) + minor;
+            }
+        }
+
+        for ( auto& buffer : buffers ) {
+            for ( vector<T>& field : buffer ) {
+                field.assign( padded_start.back(), outside );
+            }
+        }
+    }
+
+    // Форма карты
+    const HexMapShape& Shape() const { return shape; }
+
+    // Количество ячеек формы
+    size_t Size() const { return shape.Size(); }
+
+    // Гекс принадлежит форме
+    bool Contains( const Hex& hex ) const { return shape.Contains( hex ); }
+
+    // ================================================================
+    // Индекс ячейки в хранилище (гекс принадлежит форме)
+    // ================================================================
+    size_t Index( const Hex& hex ) const {
+        const size_t row = static_cast<size_t>( Major( hex ) - shape.MajorMin() );
+        return static_cast<size_t>( RowBase( row + 1 ) + Minor( hex ) );
+    }
+
+    // Текущие данные поля (хранилище, включая ячейки-границы)
+    T* Data( size_t field = 0 ) { return buffers[ current ][ field ].data(); }
+    const T* Data( size_t field = 0 ) const { return buffers[ current ][ field ].data(); }
+
+    // Размер хранилища поля
+    size_t StorageSize() const { return padded_start.back(); }
+
+    // Текущее значение поля ячейки
+    T& operator []( const Hex& hex ) { return buffers[ current ][ 0 ][ Index( hex ) ]; }
+    const T& operator []( const Hex& hex ) const { return buffers[ current ][ 0 ][ Index( hex ) ]; }
+    T& At( size_t field, const Hex& hex ) { return buffers[ current ][ field ][ Index( hex ) ]; }
+    const T& At( size_t field, const Hex& hex ) const { return buffers[ current ][ field ][ Index( hex ) ]; }
+
+    // Заполнение поля во всех ячейках формы
+    void Fill( const T& value, size_t field = 0 ) {
+        ForEachRow( [this, &value, field]( size_t begin, size_t end ) {
+            std::fill( Data( field ) + begin, Data( field ) + end, value );
+        } );
+    }
+
+    // ================================================================
+    // Загрузка поля из карты и выгрузка в карту той же формы
+    // ================================================================
+    void Load( const HexMap<T>& map, size_t field = 0 ) {
+        CopyRows( map.Shape(), [&map, this, field]( size_t map_index, size_t index ) { Data( field )[ index ] = map.Cell( map_index ); } );
+    }
+
+    void Store( HexMap<T>& map, size_t field = 0 ) const {
+        CopyRows( map.Shape(), [&map, this, field]( size_t map_index, size_t index ) { map.Cell( map_index ) = Data( field )[ index ]; } );
+    }
+
+    // ================================================================
+    // Шаг: kernel( const HexStencilCell<T, fields>& cell ) для каждой ячейки формы
+    // ================================================================
+    template<class Kernel>
+    void Step( Kernel kernel, HexThreadPool* pool = nullptr ) {
+        const size_t rows = shape.Rows();
+        size_t max_length = 0;
+
+        for ( size_t row = 0; row != rows; ++row ) {
+            max_length = std::max( max_length, shape.RowLength( row ) );
+        }
+
+        const size_t tile_rows = ( rows + TILE_ROWS - 1 ) / TILE_ROWS;
+        const size_t tile_columns = std::max<size_t>( ( max_length + TILE_LENGTH - 1 ) / TILE_LENGTH, 1 );
+
+        const auto tile = [&]( size_t index, unsigned ) {
+            const size_t row_begin = ( index / tile_columns ) * TILE_ROWS;
+            const size_t column = ( index % tile_columns ) * TILE_LENGTH;
+            const T* in[ fields ];
+            T* out[ fields ];
+
+            for ( size_t field = 0; field != fields; ++field ) {
+                in[ field ] = buffers[ current ][ field ].data();
+                out[ field ] = buffers[ 1 - current ][ field ].data();
+            }
+
+            for ( size_t row = row_begin; row != std::min( row_begin + TILE_ROWS, rows ); ++row ) {
+                const size_t length = shape.RowLength( row );
+
+                if ( column >= length ) {
+                    continue;
+                }
+
+                // Локальная копия смещений: запись следующих значений не может их изменить
+                ptrdiff_t offsets[ HEX_DIRECTION_COUNT ];
+                std::copy( row_offsets[ row ].begin(), row_offsets[ row ].end(), offsets );
+
+                const size_t first = static_cast<size_t>( RowBase( row + 1 ) + shape.RowMinor( row ) );
+                HexStencilCell<T, fields> cell( in, out, offsets );
+                const size_t end = first + std::min( column + TILE_LENGTH, length );
+
+                for ( cell.index = first + column; cell.index != end; ++cell.index ) {
+                    kernel( static_cast<const HexStencilCell<T, fields>&>( cell ) );
+                }
+            }
+        };
+
+        if ( pool != nullptr ) {
+            pool->ParallelFor( tile_rows * tile_columns, tile );
+        } else {
+            for ( size_t index = 0; index != tile_rows * tile_columns; ++index ) {
+                tile( index, 0 );
+            }
+        }
+
+        current = 1 - current;
+    }
+
+private:
+    // Индекс ячейки дополненной строки padded с координатой minor = 0
+    ptrdiff_t RowBase( size_t padded ) const {
+        return static_cast<ptrdiff_t>( padded_start[ padded ] ) - padded_min[ padded ];
+    }
+
+    int Major( const Hex& hex ) const { return ( shape.ByColumn() ? hex.Q() : hex.R() ); }
+    int Minor( const Hex& hex ) const { return ( shape.ByColumn() ? hex.R() : hex.Q() ); }
+
+    // Вызов func( begin, end ) для отрезков хранилища, занятых строками формы
+    template<class Func>
+    void ForEachRow( Func func ) const {
+        for ( size_t row = 0; row != shape.Rows(); ++row ) {
+            const size_t begin = static_cast<size_t>( RowBase( row + 1 ) + shape.RowMinor( row ) );
+            func( begin, begin + shape.RowLength( row ) );
+        }
+    }
+
+    // Вызов func( map_index, index ) для ячеек формы (индекс карты map_shape и хранилища)
+    template<class Func>
+    void CopyRows( const HexMapShape& map_shape, Func func ) const {
+        for ( size_t row = 0; row != shape.Rows(); ++row ) {
+            const size_t begin = static_cast<size_t>( RowBase( row + 1 ) + shape.RowMinor( row ) );
+
+            for ( size_t offset = 0; offset != shape.RowLength( row ); ++offset ) {
+                func( map_shape.Index( shape.RowHex( row, static_cast<int>( offset ) ) ), begin + offset );
+            }
+        }
+    }
+
+    // Форма карты
+    HexMapShape shape;
+
+    // Дополненные строки (строка формы row - дополненная строка row + 1):
+    // первая координата и первый индекс (плюс размер хранилища)
+    vector<int> padded_min;
+    vector<size_t> padded_start;
+
+    // Смещения индексов соседей ячеек строки формы
+    vector<array<ptrdiff_t, HEX_DIRECTION_COUNT>> row_offsets;
+
+    // Буферы полей: текущий ( current ) и следующий
+    vector<T> buffers[ 2 ][ fields ];
+    int current;
+};
+
+#endif // HEXSTENCIL_H
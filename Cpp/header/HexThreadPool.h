@@ -0,0 +1,89 @@
+/*
+ * HexThreadPool.h
+ *
+ * Пул потоков с перераспределением работы (work stealing)
+ */
+
+#pragma once
+#ifndef HEXTHREADPOOL_H
+#define HEXTHREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+// ================================================================
+// Пул потоков для параллельной обработки индексов 0..count-1
+// ================================================================
+// Диапазон индексов делится поровну между потоками; поток берёт
+// индексы из начала своего диапазона порциями по grain, а закончив
+// свой диапазон, забирает вторую половину оставшейся работы другого
+// потока. Вызывающий поток участвует в работе как поток 0,
+// номер потока передаётся в func и может использоваться для
+// выбора рабочих данных потока (0..ThreadCount()-1)
+// ================================================================
+class HexThreadPool {
+public:
+    // thread_count = 0: по количеству аппаратных потоков
+    explicit HexThreadPool( unsigned thread_count = 0 );
+    ~HexThreadPool();
+
+    HexThreadPool( const HexThreadPool& ) = delete;
+    HexThreadPool& operator =( const HexThreadPool& ) = delete;
+
+    // Количество потоков (включая вызывающий)
+    unsigned ThreadCount() const { return thread_count; }
+
+    // ================================================================
+    // Вызов func( index, thread ) для index = 0..count-1
+    // ================================================================
+    // Возвращает управление после обработки всех индексов,
+    // func не должна выбрасывать исключения
+    // ================================================================
+    template<class Func>
+    void ParallelFor( size_t count, Func func, size_t grain = 1 ) {
+        Run( count, grain, []( void* context, size_t index, unsigned thread ) {
+            ( *static_cast<Func*>( context ) )( index, thread );
+        }, &func );
+    }
+
+private:
+    using Call = void ( * )( void* context, size_t index, unsigned thread );
+
+    // Оставшаяся работа потока (отдельная строка кэша)
+    struct alignas( 64 ) Range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void Run( size_t count, size_t grain, Call call, void* context );
+    void WorkerMain( unsigned thread );
+    void Work( unsigned thread );
+    bool Take( unsigned thread, size_t& begin, size_t& end );
+    bool Steal( unsigned thread );
+
+    const unsigned thread_count;
+    std::unique_ptr<Range[]> ranges;
+    vector<std::thread> threads;
+
+    // Текущее задание
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable start_condition;
+    std::condition_variable done_condition;
+    uint64_t generation = 0;
+    unsigned active = 0;
+    bool stop = false;
+    Call call = nullptr;
+    void* context = nullptr;
+    size_t grain = 1;
+};
+
+#endif // HEXTHREADPOOL_H
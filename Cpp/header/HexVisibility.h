@@ -0,0 +1,213 @@
+/*
+ * HexVisibility.h
+ *
+ * Область видимости и прямая видимость на карте гексов
+ */
+
+#pragma once
+#ifndef HEXVISIBILITY_H
+#define HEXVISIBILITY_H
+
+#include "HexGrid.h"
+#include "HexLineWalker.h"
+#include "HexMap.h"
+#include "HexThreadPool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// ================================================================
+// Прямая видимость между гексами
+// ================================================================
+// true, если ни один гекс линии между hex_a и hex_b (не считая
+// концов) не перекрывает обзор: blocks( hex ) == false
+// ================================================================
+template<class Blocks>
+bool HexLineOfSight( const Hex& hex_a, const Hex& hex_b, Blocks blocks, int round_algorithm = HEX_ROUND_DEFAULT ) {
+    HexLineWalker walker( hex_a, hex_b, round_algorithm );
+    walker.Next();
+
+    return !walker.Walk( [&]( const Hex& hex ) { return hex != hex_b && blocks( hex ); } );
+}
+
+// ================================================================
+// Область видимости (теневое отбрасывание по кольцам)
+// ================================================================
+// Кольцо радиуса k делится на 6k равных угловых секторов, гекс j
+// кольца (в порядке HexRing) занимает угловой интервал
+// [ ( j - 1/2 ) / 6k, ( j + 1/2 ) / 6k ] полного оборота. Гекс виден,
+// если центр его интервала не лежит строго внутри тени гексов
+// меньших колец; перекрывающий обзор гекс виден сам и добавляет
+// свой интервал в тень. Углы сравниваются как точные дроби.
+// Рабочие данные хранятся в объекте и переиспользуются
+// ================================================================
+class HexVisibility {
+public:
+    // ================================================================
+    // Видимые гексы на расстоянии не более radius от viewer
+    // ================================================================
+    // blocks( hex ) - гекс перекрывает обзор. Результат записывается
+    // в visible в порядке HexSpiral (viewer виден всегда)
+    // ================================================================
+    template<class Blocks>
+    void FieldOfView( const Hex& viewer, int radius, Blocks blocks, vector<Hex>& visible ) {
+        visible.clear();
+        shadows.clear();
+
+        if ( radius < 0 ) {
+            return;
+        }
+
+        visible.push_back( viewer );
+
+        for ( int ring = 1; ring <= radius && !FullShadow(); ++ring ) {
+            // Угол в единицах 1 / 12k: центр гекса j = 2j, интервал [ 2j - 1, 2j + 1 ]
+            const int64_t denominator = 12 * static_cast<int64_t>( ring );
+            size_t shadow = 0;
+            new_shadows.clear();
+            Hex hex = viewer + HexDirection( 4 ) * ring;
+            int64_t j = 0;
+            bool wrap_shadow = false;
+
+            for ( const Hex& direction : HEX_DIRECTIONS ) {
+                for ( int step = 0; step != ring; ++step, ++j, hex = hex + direction ) {
+                    const Angle center = { 2 * j, denominator };
+
+                    // Тени упорядочены по углу, центры гексов кольца - тоже
+                    while ( shadow < shadows.size() && !Less( center, shadows[ shadow ].end ) ) {
+                        ++shadow;
+                    }
+
+                    // Центр первого гекса (угол 0) скрыт тенью, пересекающей угол 0
+                    if ( j == 0 ? ( !shadows.empty() && shadows.front().begin.numerator == 0 )
+                                : ( shadow < shadows.size() && Less( shadows[ shadow ].begin, center ) ) ) {
+                        continue;
+                    }
+
+                    visible.push_back( hex );
+
+                    if ( blocks( hex ) ) {
+                        if ( j == 0 ) {
+                            // Интервал первого гекса пересекает угол 0: две части
+                            new_shadows.push_back( { { 0, 1 }, { 1, denominator } } );
+                            wrap_shadow = true;
+                        } else {
+                            AddShadow( new_shadows, { { 2 * j - 1, denominator }, { 2 * j + 1, denominator } } );
+                        }
+                    }
+                }
+            }
+
+            if ( wrap_shadow ) {
+                AddShadow( new_shadows, { { denominator - 1, denominator }, { 1, 1 } } );
+            }
+
+            MergeShadows();
+        }
+    }
+
+    // ================================================================
+    // Область видимости по карте препятствий (гексы вне карты перекрывают обзор)
+    // ================================================================
+    void FieldOfView( const Hex& viewer, int radius, const HexMap<uint8_t>& blockers, vector<Hex>& visible ) {
+        FieldOfView( viewer, radius, [&blockers]( const Hex& hex ) {
+            const uint8_t* blocker = blockers.Find( hex );
+            return ( blocker == nullptr || *blocker != 0 );
+        }, visible );
+    }
+
+private:
+    // Угол: доля полного оборота numerator / denominator
+    struct Angle {
+        int64_t numerator;
+        int64_t denominator;
+    };
+
+    struct Shadow {
+        Angle begin;
+        Angle end;
+    };
+
+    static bool Less( const Angle& a, const Angle& b ) {
+        return a.numerator * b.denominator < b.numerator * a.denominator;
+    }
+
+    // Добавление тени в конец упорядоченного списка (со слиянием соприкасающихся)
+    static void AddShadow( vector<Shadow>& list, const Shadow& shadow ) {
+        if ( !list.empty() && !Less( list.back().end, shadow.begin ) ) {
+            if ( Less( list.back().end, shadow.end ) ) {
+                list.back().end = shadow.end;
+            }
+        } else {
+            list.push_back( shadow );
+        }
+    }
+
+    // Слияние теней кольца с тенями предыдущих колец
+    void MergeShadows() {
+        merged.clear();
+        size_t i = 0;
+        size_t j = 0;
+
+        while ( i < shadows.size() || j < new_shadows.size() ) {
+            if ( j == new_shadows.size() || ( i < shadows.size() && Less( shadows[ i ].begin, new_shadows[ j ].begin ) ) ) {
+                AddShadow( merged, shadows[ i++ ] );
+            } else {
+                AddShadow( merged, new_shadows[ j++ ] );
+            }
+        }
+
+        shadows.swap( merged );
+    }
+
+    // Тень покрывает весь оборот
+    bool FullShadow() const {
+        return ( shadows.size() == 1 && shadows.front().begin.numerator == 0 && !Less( shadows.front().end, { 1, 1 } ) );
+    }
+
+    vector<Shadow> shadows;
+    vector<Shadow> new_shadows;
+    vector<Shadow> merged;
+};
+
+// ================================================================
+// Области видимости для множества наблюдателей
+// ================================================================
+// Наблюдатели распределяются между потоками пула, у каждого потока
+// собственные рабочие данные. Результаты записываются в порядке
+// наблюдателей; blocks вызывается из нескольких потоков одновременно
+// ================================================================
+class HexVisibilityBatch {
+public:
+    explicit HexVisibilityBatch( HexThreadPool& pool_ ) : pool( pool_ ) {
+        for ( unsigned thread = 0; thread != pool.ThreadCount(); ++thread ) {
+            engines.emplace_back( new HexVisibility() );
+        }
+    }
+
+    template<class Blocks>
+    void FieldOfView( const vector<Hex>& viewers, int radius, Blocks blocks, vector<vector<Hex>>& visible ) {
+        visible.resize( viewers.size() );
+
+        pool.ParallelFor( viewers.size(), [&]( size_t index, unsigned thread ) {
+            engines[ thread ]->FieldOfView( viewers[ index ], radius, blocks, visible[ index ] );
+        } );
+    }
+
+    void FieldOfView( const vector<Hex>& viewers, int radius, const HexMap<uint8_t>& blockers, vector<vector<Hex>>& visible ) {
+        visible.resize( viewers.size() );
+
+        pool.ParallelFor( viewers.size(), [&]( size_t index, unsigned thread ) {
+            engines[ thread ]->FieldOfView( viewers[ index ], radius, blockers, visible[ index ] );
+        } );
+    }
+
+private:
+    HexThreadPool& pool;
+
+    // Рабочие данные каждого потока
+    vector<std::unique_ptr<HexVisibility>> engines;
+};
+
+#endif // HEXVISIBILITY_H
@@ -0,0 +1,167 @@
+/*
+ * bench_runner.h
+ *
+ * Простейший раннер микро-бенчмарков (в стиле test_runner.h)
+ */
+
+#pragma once
+#ifndef BENCH_RUNNER_H___VLADBOYR
+#define BENCH_RUNNER_H___VLADBOYR
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+using std::string;
+
+// ================================================================
+// Формат вывода результатов
+// ================================================================
+// BENCH_FORMAT_TEXT = Таблица для чтения человеком
+// BENCH_FORMAT_JSON = Одна строка JSON на результат (JSON Lines),
+//                     для сравнения результатов между версиями
+// ================================================================
+enum BenchFormat_t {
+    BENCH_FORMAT_TEXT = 0,
+    BENCH_FORMAT_JSON = 1
+};
+
+// ================================================================
+// Счётчик выделений памяти
+// ================================================================
+// Увеличивается заменённым operator new (см. benchmark.cpp),
+// без замены остаётся нулевым
+// ================================================================
+inline std::atomic<unsigned long long>& BenchAllocations() {
+    static std::atomic<unsigned long long> allocations( 0 );
+    return allocations;
+}
+
+// ================================================================
+// Запрет оптимизации значения (результат не выбрасывается компилятором)
+// ================================================================
+template<class T>
+inline void DoNotOptimize( const T& value ) {
+#if defined( __GNUC__ )
+    asm volatile( "" : : "r,m"( value ) : "memory" );
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner( const string& filter_ = "", BenchFormat_t format_ = BENCH_FORMAT_TEXT ) :
+        filter( filter_ ), format( format_ ) {}
+
+    // ================================================================
+    // Описание условий запуска (компилятор, реализация SIMD и т.п.)
+    // ================================================================
+    void Context( const string& key, const string& value ) const {
+        if ( format == BENCH_FORMAT_JSON ) {
+            printf( "{\"context\": \"%s\", \"value\": \"%s\"}\n", Escape( key ).c_str(), Escape( value ).c_str() );
+        } else {
+            printf( "# %s: %s\n", key.c_str(), value.c_str() );
+        }
+    }
+
+    // ================================================================
+    // Запуск бенчмарка
+    // ================================================================
+    // func() выполняет ops_per_call операций, вызывается до тех пор,
+    // пока суммарное время не превысит min_seconds. Результат - время
+    // и количество выделений памяти на операцию, операций в секунду
+    // ================================================================
+    template<class BenchFunc>
+    void RunBench( BenchFunc func, const string& bench_name, double ops_per_call, double min_seconds = 0.2L ) {
+        if ( !Enabled( bench_name ) ) {
+            return;
+        }
+
+        using clock = std::chrono::steady_clock;
+
+        // Прогрев
+        func();
+
+        size_t calls = 0;
+        double elapsed = 0.0L;
+        const unsigned long long allocations = BenchAllocations().load( std::memory_order_relaxed );
+        const auto start = clock::now();
+
+        do {
+            func();
+            ++calls;
+            elapsed = std::chrono::duration<double>( clock::now() - start ).count();
+        } while ( elapsed < min_seconds );
+
+        const double ops = ops_per_call * calls;
+        const double ns_per_op = elapsed * 1e9 / ops;
+        const double mops = ops / elapsed / 1e6;
+        const double allocs_per_op = ( BenchAllocations().load( std::memory_order_relaxed ) - allocations ) / ops;
+
+        if ( format == BENCH_FORMAT_JSON ) {
+            printf( "{\"name\": \"%s\", \"ns_per_op\": %.4g, \"mops_per_s\": %.4g, \"allocs_per_op\": %.4g, \"ops\": %.0f}\n",
+                    Escape( bench_name ).c_str(), ns_per_op, mops, allocs_per_op, ops );
+        } else {
+            printf( "%-48s %12.2f ns/op %12.2f Mops/s %10.2f allocs/op\n", bench_name.c_str(), ns_per_op, mops, allocs_per_op );
+        }
+    }
+
+    // ================================================================
+    // Дополнительный результат: значения с единицами измерения
+    // ================================================================
+    void Report( const string& bench_name, std::initializer_list<std::pair<double, string>> values ) const {
+        if ( format == BENCH_FORMAT_JSON ) {
+            printf( "{\"name\": \"%s\"", Escape( bench_name ).c_str() );
+
+            for ( const auto& value : values ) {
+                printf( ", \"%s\": %.6g", Escape( value.second ).c_str(), value.first );
+            }
+
+            printf( "}\n" );
+        } else {
+            printf( "%-48s", bench_name.c_str() );
+
+            for ( const auto& value : values ) {
+                printf( " %12.6g %s", value.first, value.second.c_str() );
+            }
+
+            printf( "\n" );
+        }
+    }
+
+    // Бенчмарк проходит фильтр
+    bool Enabled( const string& bench_name ) const {
+        return ( filter.empty() || bench_name.find( filter ) != string::npos );
+    }
+
+private:
+    // Строка JSON: экранирование кавычек, '\\' и управляющих символов
+    static string Escape( const string& text ) {
+        string result;
+
+        for ( const char c : text ) {
+            if ( c == '"' || c == '\\' ) {
+                result += '\\';
+                result += c;
+            } else if ( static_cast<unsigned char>( c ) < 0x20 ) {
+                char code[ 8 ];
+                snprintf( code, sizeof( code ), "\\u%04x", static_cast<unsigned>( c ) );
+                result += code;
+            } else {
+                result += c;
+            }
+        }
+
+        return result;
+    }
+
+    const string filter;
+    const BenchFormat_t format;
+};
+
+#endif /* BENCH_RUNNER_H___VLADBOYR */
@@ -0,0 +1,707 @@
+/*
+ * HexBatch.cpp
+ *
+ * Пакетные (SIMD) преобразования координат
+ */
+
+#include "HexBatch.h"
+#include "HexProfile.h"
+
+// ================================================================
+// SIMD-реализации доступны для x86 / x86-64 (GCC, Clang)
+// ================================================================
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define HEX_BATCH_X86 1
+#include <immintrin.h>
+#define HEX_BATCH_TARGET_SSE2 __attribute__( ( target( "sse2" ) ) )
+#define HEX_BATCH_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#else
+#define HEX_BATCH_X86 0
+#endif
+
+// ================================================================
+// Коэффициенты преобразования координат на плоскости в координаты гекса
+// ================================================================
+struct PixelToHexCoefficients {
+    explicit PixelToHexCoefficients( const HexLayout& layout ) :
+        origin_x( layout.origin.x ), origin_y( layout.origin.y ),
+        size_x( layout.size.x ), size_y( layout.size.y ),
+        xq( layout.XQ() ), yq( layout.YQ() ), xr( layout.XR() ), yr( layout.YR() ) {}
+
+    const double origin_x;
+    const double origin_y;
+    const double size_x;
+    const double size_y;
+    const double xq;
+    const double yq;
+    const double xr;
+    const double yr;
+};
+
+// ================================================================
+// Коэффициенты преобразования координат гекса в координаты на плоскости
+// ================================================================
+struct HexToPixelCoefficients {
+    explicit HexToPixelCoefficients( const HexLayout& layout ) :
+        origin_x( layout.origin.x ), origin_y( layout.origin.y ),
+        size_x( layout.size.x ), size_y( layout.size.y ),
+        qx( layout.QX() ), rx( layout.RX() ), qy( layout.QY() ), ry( layout.RY() ) {}
+
+    const double origin_x;
+    const double origin_y;
+    const double size_x;
+    const double size_y;
+    const double qx;
+    const double rx;
+    const double qy;
+    const double ry;
+};
+
+// ================================================================
+// Смещения углов гекса относительно центра ( x0, y0, ..., x5, y5 )
+// ================================================================
+struct HexCornerOffsets {
+    explicit HexCornerOffsets( const HexLayout& layout ) {
+        for ( unsigned corner = 0; corner != HEX_CORNER_COUNT; ++corner ) {
+            value[ 2 * corner ] = layout.corners[ corner ].x;
+            value[ 2 * corner + 1 ] = layout.corners[ corner ].y;
+        }
+    }
+
+    double value[ HEX_CORNER_VERTEX_STRIDE ];
+};
+
+// ================================================================
+// Определение реализации, поддерживаемой процессором
+// ================================================================
+static HexBatchKernel_t DetectHexBatchKernel() {
+#if HEX_BATCH_X86
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "avx2" ) ) {
+        return HEX_BATCH_AVX2;
+    }
+
+    if ( __builtin_cpu_supports( "sse2" ) ) {
+        return HEX_BATCH_SSE2;
+    }
+#endif
+    return HEX_BATCH_SCALAR;
+}
+
+// ================================================================
+// Реализация, которая будет использована для запрошенной
+// ================================================================
+HexBatchKernel_t HexBatchKernel( HexBatchKernel_t kernel ) {
+    static const HexBatchKernel_t supported = DetectHexBatchKernel();
+
+    if ( kernel == HEX_BATCH_AUTO || kernel > supported ) {
+        return supported;
+    }
+
+    return kernel;
+}
+
+// ================================================================
+// Название реализации
+// ================================================================
+const char* HexBatchKernelName( HexBatchKernel_t kernel ) {
+    switch ( kernel ) {
+        case HEX_BATCH_SCALAR:
+            return "scalar";
+
+        case HEX_BATCH_SSE2:
+            return "sse2";
+
+        case HEX_BATCH_AVX2:
+            return "avx2";
+
+        default:
+            return "auto";
+    }
+}
+
+// ================================================================
+// Координаты на плоскости => Координаты гекса (Скалярная реализация)
+// ================================================================
+static void PixelToHexScalar( const HexLayout& layout, const double* x, const double* y, size_t count,
+                              int* q, int* r, int round_algorithm ) {
+    for ( size_t i = 0; i != count; ++i ) {
+        const Hex hex = PixelToHex( layout, Point( x[ i ], y[ i ] ) ).Round( round_algorithm );
+        q[ i ] = hex.Q();
+        r[ i ] = hex.R();
+    }
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров (Скалярная реализация)
+// ================================================================
+static void HexToPixelScalar( const HexLayout& layout, const int* q, const int* r, size_t count, double* x, double* y ) {
+    for ( size_t i = 0; i != count; ++i ) {
+        const Point center = Hex( q[ i ], r[ i ] ).HexToPixel( layout );
+        x[ i ] = center.x;
+        y[ i ] = center.y;
+    }
+}
+
+// ================================================================
+// Углы гексов => Буфер вершин (Скалярная реализация)
+// ================================================================
+static void HexCornersScalar( const HexLayout& layout, const HexCornerOffsets& offsets, const int* q, const int* r,
+                              size_t count, double* vertices ) {
+    for ( size_t i = 0; i != count; ++i, vertices += HEX_CORNER_VERTEX_STRIDE ) {
+        const Point center = Hex( q[ i ], r[ i ] ).HexToPixel( layout );
+
+        for ( size_t j = 0; j != HEX_CORNER_VERTEX_STRIDE; j += 2 ) {
+            vertices[ j ] = center.x + offsets.value[ j ];
+            vertices[ j + 1 ] = center.y + offsets.value[ j + 1 ];
+        }
+    }
+}
+
+// ================================================================
+// Офсетные <=> Кубические координаты (общий вид четырёх вариантов)
+// ================================================================
+// Все четыре варианта ( Q_Offset_to_Cube, R_Offset_to_Cube,
+// Cube_to_Offset_Q, Cube_to_Offset_R ) сводятся к одному:
+// координата major переносится без изменений, к координате minor
+// прибавляется (subtract - вычитается) половина major, округлённая
+// вниз ( OFFSET_TYPE_ODD ) или вверх ( OFFSET_TYPE_EVEN ):
+// ( major + offset_type * ( major & 1 ) ) / 2 = ( major >> 1 ) + ( major & even )
+// ================================================================
+struct OffsetShift {
+    OffsetShift( OffsetType_t offset_type, bool subtract_ ) :
+        even( offset_type == OFFSET_TYPE_EVEN ? 1 : 0 ), subtract( subtract_ ) {}
+
+    const int even;
+    const bool subtract;
+};
+
+// ================================================================
+// Офсетные <=> Кубические координаты (Скалярная реализация)
+// ================================================================
+static void OffsetShiftScalar( const OffsetShift& shift, const int* major, const int* minor, size_t count,
+                               int* out_major, int* out_minor ) {
+    for ( size_t i = 0; i != count; ++i ) {
+        const int value = major[ i ];
+        const int half = ( value >> 1 ) + ( value & shift.even );
+        out_minor[ i ] = ( shift.subtract ? minor[ i ] - half : minor[ i ] + half );
+        out_major[ i ] = value;
+    }
+}
+
+#if HEX_BATCH_X86
+
+// ================================================================
+// Округление до ближайшего целого, половина - от нуля (как round())
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static inline __m128d RoundSSE2( __m128d value ) {
+    const __m128d truncated = _mm_cvtepi32_pd( _mm_cvttpd_epi32( value ) );
+    const __m128d fraction = _mm_sub_pd( value, truncated );
+    const __m128d up = _mm_and_pd( _mm_cmpge_pd( fraction, _mm_set1_pd( 0.5L ) ), _mm_set1_pd( 1.0L ) );
+    const __m128d down = _mm_and_pd( _mm_cmple_pd( fraction, _mm_set1_pd( -0.5L ) ), _mm_set1_pd( 1.0L ) );
+    return _mm_sub_pd( _mm_add_pd( truncated, up ), down );
+}
+
+// ================================================================
+// Выбор по маске: mask ? a : b
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static inline __m128d SelectSSE2( __m128d mask, __m128d a, __m128d b ) {
+    return _mm_or_pd( _mm_and_pd( mask, a ), _mm_andnot_pd( mask, b ) );
+}
+
+// ================================================================
+// Координаты на плоскости => Координаты гекса (SSE2)
+// ================================================================
+// Округление без ветвлений: маски mq / mr отмечают координату,
+// которая пересчитывается через две другие (как в FractionalHex::Round)
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static size_t PixelToHexSSE2( const PixelToHexCoefficients& k, const double* x, const double* y, size_t count,
+                              int* q, int* r, int round_algorithm ) {
+    const __m128d origin_x = _mm_set1_pd( k.origin_x ), origin_y = _mm_set1_pd( k.origin_y );
+    const __m128d size_x = _mm_set1_pd( k.size_x ), size_y = _mm_set1_pd( k.size_y );
+    const __m128d xq = _mm_set1_pd( k.xq ), yq = _mm_set1_pd( k.yq );
+    const __m128d xr = _mm_set1_pd( k.xr ), yr = _mm_set1_pd( k.yr );
+    const __m128d sign = _mm_set1_pd( -0.0L );
+    const __m128d ones = _mm_castsi128_pd( _mm_set1_epi32( -1 ) );
+
+    size_t i = 0;
+
+    for ( ; i + 2 <= count; i += 2 ) {
+        // Дробные координаты
+        const __m128d px = _mm_div_pd( _mm_sub_pd( _mm_loadu_pd( x + i ), origin_x ), size_x );
+        const __m128d py = _mm_div_pd( _mm_sub_pd( _mm_loadu_pd( y + i ), origin_y ), size_y );
+        const __m128d fq = _mm_add_pd( _mm_mul_pd( xq, px ), _mm_mul_pd( yq, py ) );
+        const __m128d fr = _mm_add_pd( _mm_mul_pd( xr, px ), _mm_mul_pd( yr, py ) );
+        const __m128d fs = _mm_sub_pd( _mm_xor_pd( fq, sign ), fr );
+
+        // Округляем координаты
+        const __m128d rq = RoundSSE2( fq );
+        const __m128d rr = RoundSSE2( fr );
+        const __m128d rs = RoundSSE2( fs );
+
+        // Вычислим дельту округления
+        const __m128d q_diff = _mm_andnot_pd( sign, _mm_sub_pd( rq, fq ) );
+        const __m128d r_diff = _mm_andnot_pd( sign, _mm_sub_pd( rr, fr ) );
+        const __m128d s_diff = _mm_andnot_pd( sign, _mm_sub_pd( rs, fs ) );
+
+        // Отбрасываем координату с наибольшей дельтой
+        __m128d mq, mr;
+
+        switch ( round_algorithm ) {
+            case 0:
+                mq = _mm_and_pd( _mm_cmpgt_pd( q_diff, r_diff ), _mm_cmpgt_pd( q_diff, s_diff ) );
+                mr = _mm_andnot_pd( mq, _mm_cmpgt_pd( r_diff, s_diff ) );
+                break;
+
+            case 1:
+                mr = _mm_and_pd( _mm_cmpgt_pd( r_diff, q_diff ), _mm_cmpgt_pd( r_diff, s_diff ) );
+                mq = _mm_andnot_pd( _mm_or_pd( mr, _mm_cmpgt_pd( s_diff, q_diff ) ), ones );
+                break;
+
+            default: {
+                const __m128d ms = _mm_and_pd( _mm_cmpgt_pd( s_diff, q_diff ), _mm_cmpgt_pd( s_diff, r_diff ) );
+                const __m128d q_gt_r = _mm_cmpgt_pd( q_diff, r_diff );
+                mq = _mm_andnot_pd( ms, q_gt_r );
+                mr = _mm_andnot_pd( _mm_or_pd( ms, q_gt_r ), ones );
+                break;
+            }
+        }
+
+        const __m128d hq = SelectSSE2( mq, _mm_sub_pd( _mm_xor_pd( rr, sign ), rs ), rq );
+        const __m128d hr = SelectSSE2( mr, _mm_sub_pd( _mm_xor_pd( rq, sign ), rs ), rr );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( q + i ), _mm_cvttpd_epi32( hq ) );
+        _mm_storel_epi64( reinterpret_cast<__m128i*>( r + i ), _mm_cvttpd_epi32( hr ) );
+    }
+
+    return i;
+}
+
+// ================================================================
+// Округление до ближайшего целого, половина - от нуля (как round())
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static inline __m256d RoundAVX2( __m256d value ) {
+    const __m256d truncated = _mm256_round_pd( value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC );
+    const __m256d fraction = _mm256_sub_pd( value, truncated );
+    const __m256d up = _mm256_and_pd( _mm256_cmp_pd( fraction, _mm256_set1_pd( 0.5L ), _CMP_GE_OQ ), _mm256_set1_pd( 1.0L ) );
+    const __m256d down = _mm256_and_pd( _mm256_cmp_pd( fraction, _mm256_set1_pd( -0.5L ), _CMP_LE_OQ ), _mm256_set1_pd( 1.0L ) );
+    return _mm256_sub_pd( _mm256_add_pd( truncated, up ), down );
+}
+
+// ================================================================
+// Координаты на плоскости => Координаты гекса (AVX2)
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static size_t PixelToHexAVX2( const PixelToHexCoefficients& k, const double* x, const double* y, size_t count,
+                              int* q, int* r, int round_algorithm ) {
+    const __m256d origin_x = _mm256_set1_pd( k.origin_x ), origin_y = _mm256_set1_pd( k.origin_y );
+    const __m256d size_x = _mm256_set1_pd( k.size_x ), size_y = _mm256_set1_pd( k.size_y );
+    const __m256d xq = _mm256_set1_pd( k.xq ), yq = _mm256_set1_pd( k.yq );
+    const __m256d xr = _mm256_set1_pd( k.xr ), yr = _mm256_set1_pd( k.yr );
+    const __m256d sign = _mm256_set1_pd( -0.0L );
+    const __m256d ones = _mm256_castsi256_pd( _mm256_set1_epi32( -1 ) );
+
+    size_t i = 0;
+
+    for ( ; i + 4 <= count; i += 4 ) {
+        // Дробные координаты
+        const __m256d px = _mm256_div_pd( _mm256_sub_pd( _mm256_loadu_pd( x + i ), origin_x ), size_x );
+        const __m256d py = _mm256_div_pd( _mm256_sub_pd( _mm256_loadu_pd( y + i ), origin_y ), size_y );
+        const __m256d fq = _mm256_add_pd( _mm256_mul_pd( xq, px ), _mm256_mul_pd( yq, py ) );
+        const __m256d fr = _mm256_add_pd( _mm256_mul_pd( xr, px ), _mm256_mul_pd( yr, py ) );
+        const __m256d fs = _mm256_sub_pd( _mm256_xor_pd( fq, sign ), fr );
+
+        // Округляем координаты
+        const __m256d rq = RoundAVX2( fq );
+        const __m256d rr = RoundAVX2( fr );
+        const __m256d rs = RoundAVX2( fs );
+
+        // Вычислим дельту округления
+        const __m256d q_diff = _mm256_andnot_pd( sign, _mm256_sub_pd( rq, fq ) );
+        const __m256d r_diff = _mm256_andnot_pd( sign, _mm256_sub_pd( rr, fr ) );
+        const __m256d s_diff = _mm256_andnot_pd( sign, _mm256_sub_pd( rs, fs ) );
+
+        // Отбрасываем координату с наибольшей дельтой
+        __m256d mq, mr;
+
+        switch ( round_algorithm ) {
+            case 0:
+                mq = _mm256_and_pd( _mm256_cmp_pd( q_diff, r_diff, _CMP_GT_OQ ), _mm256_cmp_pd( q_diff, s_diff, _CMP_GT_OQ ) );
+                mr = _mm256_andnot_pd( mq, _mm256_cmp_pd( r_diff, s_diff, _CMP_GT_OQ ) );
+                break;
+
+            case 1:
+                mr = _mm256_and_pd( _mm256_cmp_pd( r_diff, q_diff, _CMP_GT_OQ ), _mm256_cmp_pd( r_diff, s_diff, _CMP_GT_OQ ) );
+                mq = _mm256_andnot_pd( _mm256_or_pd( mr, _mm256_cmp_pd( s_diff, q_diff, _CMP_GT_OQ ) ), ones );
+                break;
+
+            default: {
+                const __m256d ms = _mm256_and_pd( _mm256_cmp_pd( s_diff, q_diff, _CMP_GT_OQ ), _mm256_cmp_pd( s_diff, r_diff, _CMP_GT_OQ ) );
+                const __m256d q_gt_r = _mm256_cmp_pd( q_diff, r_diff, _CMP_GT_OQ );
+                mq = _mm256_andnot_pd( ms, q_gt_r );
+                mr = _mm256_andnot_pd( _mm256_or_pd( ms, q_gt_r ), ones );
+                break;
+            }
+        }
+
+        const __m256d hq = _mm256_blendv_pd( rq, _mm256_sub_pd( _mm256_xor_pd( rr, sign ), rs ), mq );
+        const __m256d hr = _mm256_blendv_pd( rr, _mm256_sub_pd( _mm256_xor_pd( rq, sign ), rs ), mr );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( q + i ), _mm256_cvttpd_epi32( hq ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( r + i ), _mm256_cvttpd_epi32( hr ) );
+    }
+
+    return i;
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров (SSE2, 2 гекса)
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static inline void HexCentersSSE2( const HexToPixelCoefficients& k, const int* q, const int* r,
+                                   __m128d& x, __m128d& y ) {
+    const __m128d hq = _mm_cvtepi32_pd( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( q ) ) );
+    const __m128d hr = _mm_cvtepi32_pd( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( r ) ) );
+    x = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_set1_pd( k.qx ), hq ), _mm_mul_pd( _mm_set1_pd( k.rx ), hr ) ),
+                                _mm_set1_pd( k.size_x ) ), _mm_set1_pd( k.origin_x ) );
+    y = _mm_add_pd( _mm_mul_pd( _mm_add_pd( _mm_mul_pd( _mm_set1_pd( k.qy ), hq ), _mm_mul_pd( _mm_set1_pd( k.ry ), hr ) ),
+                                _mm_set1_pd( k.size_y ) ), _mm_set1_pd( k.origin_y ) );
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров (SSE2)
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static size_t HexToPixelSSE2( const HexToPixelCoefficients& k, const int* q, const int* r, size_t count,
+                              double* x, double* y ) {
+    size_t i = 0;
+
+    for ( ; i + 2 <= count; i += 2 ) {
+        __m128d cx, cy;
+        HexCentersSSE2( k, q + i, r + i, cx, cy );
+        _mm_storeu_pd( x + i, cx );
+        _mm_storeu_pd( y + i, cy );
+    }
+
+    return i;
+}
+
+// ================================================================
+// Углы гексов => Буфер вершин (SSE2)
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static size_t HexCornersSSE2( const HexToPixelCoefficients& k, const HexCornerOffsets& offsets,
+                              const int* q, const int* r, size_t count, double* vertices ) {
+    __m128d corner[ 6 ];
+
+    for ( int j = 0; j != 6; ++j ) {
+        corner[ j ] = _mm_loadu_pd( offsets.value + 2 * j );
+    }
+
+    size_t i = 0;
+
+    for ( ; i + 2 <= count; i += 2, vertices += 2 * HEX_CORNER_VERTEX_STRIDE ) {
+        __m128d cx, cy;
+        HexCentersSSE2( k, q + i, r + i, cx, cy );
+
+        // Пары ( x, y ) центров первого и второго гекса
+        const __m128d center[ 2 ] = { _mm_unpacklo_pd( cx, cy ), _mm_unpackhi_pd( cx, cy ) };
+
+        for ( int h = 0; h != 2; ++h ) {
+            for ( int j = 0; j != 6; ++j ) {
+                _mm_storeu_pd( vertices + h * HEX_CORNER_VERTEX_STRIDE + 2 * j, _mm_add_pd( center[ h ], corner[ j ] ) );
+            }
+        }
+    }
+
+    return i;
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров (AVX2, 4 гекса)
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static inline void HexCentersAVX2( const HexToPixelCoefficients& k, const int* q, const int* r,
+                                   __m256d& x, __m256d& y ) {
+    const __m256d hq = _mm256_cvtepi32_pd( _mm_loadu_si128( reinterpret_cast<const __m128i*>( q ) ) );
+    const __m256d hr = _mm256_cvtepi32_pd( _mm_loadu_si128( reinterpret_cast<const __m128i*>( r ) ) );
+    x = _mm256_add_pd( _mm256_mul_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( k.qx ), hq ),
+                                                     _mm256_mul_pd( _mm256_set1_pd( k.rx ), hr ) ),
+                                      _mm256_set1_pd( k.size_x ) ), _mm256_set1_pd( k.origin_x ) );
+    y = _mm256_add_pd( _mm256_mul_pd( _mm256_add_pd( _mm256_mul_pd( _mm256_set1_pd( k.qy ), hq ),
+                                                     _mm256_mul_pd( _mm256_set1_pd( k.ry ), hr ) ),
+                                      _mm256_set1_pd( k.size_y ) ), _mm256_set1_pd( k.origin_y ) );
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров (AVX2)
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static size_t HexToPixelAVX2( const HexToPixelCoefficients& k, const int* q, const int* r, size_t count,
+                              double* x, double* y ) {
+    size_t i = 0;
+
+    for ( ; i + 4 <= count; i += 4 ) {
+        __m256d cx, cy;
+        HexCentersAVX2( k, q + i, r + i, cx, cy );
+        _mm256_storeu_pd( x + i, cx );
+        _mm256_storeu_pd( y + i, cy );
+    }
+
+    return i;
+}
+
+// ================================================================
+// Углы гексов => Буфер вершин (AVX2)
+// ================================================================
+// Центр гекса ( x, y, x, y ) складывается с тремя векторами смещений углов
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static size_t HexCornersAVX2( const HexToPixelCoefficients& k, const HexCornerOffsets& offsets,
+                              const int* q, const int* r, size_t count, double* vertices ) {
+    const __m256d corner[ 3 ] = {
+        _mm256_loadu_pd( offsets.value ),
+        _mm256_loadu_pd( offsets.value + 4 ),
+        _mm256_loadu_pd( offsets.value + 8 )
+    };
+
+    size_t i = 0;
+
+    for ( ; i + 4 <= count; i += 4, vertices += 4 * HEX_CORNER_VERTEX_STRIDE ) {
+        __m256d cx, cy;
+        HexCentersAVX2( k, q + i, r + i, cx, cy );
+
+        // ( x0, y0, x2, y2 ) и ( x1, y1, x3, y3 )
+        const __m256d even = _mm256_unpacklo_pd( cx, cy );
+        const __m256d odd = _mm256_unpackhi_pd( cx, cy );
+        const __m256d center[ 4 ] = {
+            _mm256_permute2f128_pd( even, even, 0x00 ),
+            _mm256_permute2f128_pd( odd, odd, 0x00 ),
+            _mm256_permute2f128_pd( even, even, 0x11 ),
+            _mm256_permute2f128_pd( odd, odd, 0x11 )
+        };
+
+        for ( int h = 0; h != 4; ++h ) {
+            for ( int j = 0; j != 3; ++j ) {
+                _mm256_storeu_pd( vertices + h * HEX_CORNER_VERTEX_STRIDE + 4 * j, _mm256_add_pd( center[ h ], corner[ j ] ) );
+            }
+        }
+    }
+
+    return i;
+}
+
+// ================================================================
+// Офсетные <=> Кубические координаты (SSE2, 4 значения int за операцию)
+// ================================================================
+// Вычитание половины - прибавление ( half ^ negate ) - negate, negate = -1
+// ================================================================
+HEX_BATCH_TARGET_SSE2
+static size_t OffsetShiftSSE2( const OffsetShift& shift, const int* major, const int* minor, size_t count,
+                               int* out_major, int* out_minor ) {
+    const __m128i even = _mm_set1_epi32( shift.even );
+    const __m128i negate = _mm_set1_epi32( shift.subtract ? -1 : 0 );
+    size_t i = 0;
+
+    for ( ; i + 4 <= count; i += 4 ) {
+        const __m128i value = _mm_loadu_si128( reinterpret_cast<const __m128i*>( major + i ) );
+        const __m128i other = _mm_loadu_si128( reinterpret_cast<const __m128i*>( minor + i ) );
+        const __m128i half = _mm_add_epi32( _mm_srai_epi32( value, 1 ), _mm_and_si128( value, even ) );
+        const __m128i result = _mm_add_epi32( other, _mm_sub_epi32( _mm_xor_si128( half, negate ), negate ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( out_minor + i ), result );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( out_major + i ), value );
+    }
+
+    return i;
+}
+
+// ================================================================
+// Офсетные <=> Кубические координаты (AVX2, 8 значений int за операцию)
+// ================================================================
+HEX_BATCH_TARGET_AVX2
+static size_t OffsetShiftAVX2( const OffsetShift& shift, const int* major, const int* minor, size_t count,
+                               int* out_major, int* out_minor ) {
+    const __m256i even = _mm256_set1_epi32( shift.even );
+    const __m256i negate = _mm256_set1_epi32( shift.subtract ? -1 : 0 );
+    size_t i = 0;
+
+    for ( ; i + 8 <= count; i += 8 ) {
+        const __m256i value = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( major + i ) );
+        const __m256i other = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( minor + i ) );
+        const __m256i half = _mm256_add_epi32( _mm256_srai_epi32( value, 1 ), _mm256_and_si256( value, even ) );
+        const __m256i result = _mm256_add_epi32( other, _mm256_sub_epi32( _mm256_xor_si256( half, negate ), negate ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( out_minor + i ), result );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( out_major + i ), value );
+    }
+
+    return i;
+}
+
+#endif // HEX_BATCH_X86
+
+// ================================================================
+// Координаты на плоскости => Координаты гекса (с округлением)
+// ================================================================
+void PixelToHexBatch( const HexLayout& layout, const double* x, const double* y, size_t count,
+                      int* q, int* r, int round_algorithm, HexBatchKernel_t kernel ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_PIXEL_TO_HEX_BATCH );
+
+    // Выбор алгоритма округления (один раз на весь пакет)
+    round_algorithm = HexRoundAlgorithm( round_algorithm );
+
+    size_t done = 0;
+
+#if HEX_BATCH_X86
+    const PixelToHexCoefficients coefficients( layout );
+
+    switch ( HexBatchKernel( kernel ) ) {
+        case HEX_BATCH_AVX2:
+            done = PixelToHexAVX2( coefficients, x, y, count, q, r, round_algorithm );
+            break;
+
+        case HEX_BATCH_SSE2:
+            done = PixelToHexSSE2( coefficients, x, y, count, q, r, round_algorithm );
+            break;
+
+        default:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+
+    // Остаток пакета (или весь пакет без SIMD)
+    PixelToHexScalar( layout, x + done, y + done, count - done, q + done, r + done, round_algorithm );
+}
+
+// ================================================================
+// Координаты гексов => Координаты центров на плоскости
+// ================================================================
+void HexToPixelBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                      double* x, double* y, HexBatchKernel_t kernel ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_TO_PIXEL_BATCH );
+
+    size_t done = 0;
+
+#if HEX_BATCH_X86
+    const HexToPixelCoefficients coefficients( layout );
+
+    switch ( HexBatchKernel( kernel ) ) {
+        case HEX_BATCH_AVX2:
+            done = HexToPixelAVX2( coefficients, q, r, count, x, y );
+            break;
+
+        case HEX_BATCH_SSE2:
+            done = HexToPixelSSE2( coefficients, q, r, count, x, y );
+            break;
+
+        default:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+
+    // Остаток пакета (или весь пакет без SIMD)
+    HexToPixelScalar( layout, q + done, r + done, count - done, x + done, y + done );
+}
+
+// ================================================================
+// Углы гексов на плоскости => Буфер вершин
+// ================================================================
+void HexCornersBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                      double* vertices, HexBatchKernel_t kernel ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_CORNERS_BATCH );
+
+    const HexCornerOffsets offsets( layout );
+    size_t done = 0;
+
+#if HEX_BATCH_X86
+    const HexToPixelCoefficients coefficients( layout );
+
+    switch ( HexBatchKernel( kernel ) ) {
+        case HEX_BATCH_AVX2:
+            done = HexCornersAVX2( coefficients, offsets, q, r, count, vertices );
+            break;
+
+        case HEX_BATCH_SSE2:
+            done = HexCornersSSE2( coefficients, offsets, q, r, count, vertices );
+            break;
+
+        default:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+
+    // Остаток пакета (или весь пакет без SIMD)
+    HexCornersScalar( layout, offsets, q + done, r + done, count - done, vertices + done * HEX_CORNER_VERTEX_STRIDE );
+}
+
+// ================================================================
+// Офсетные <=> Кубические координаты (выбор реализации один раз на пакет)
+// ================================================================
+static void OffsetShiftBatch( const OffsetShift& shift, const int* major, const int* minor, size_t count,
+                              int* out_major, int* out_minor, HexBatchKernel_t kernel ) {
+    size_t done = 0;
+
+#if HEX_BATCH_X86
+    switch ( HexBatchKernel( kernel ) ) {
+        case HEX_BATCH_AVX2:
+            done = OffsetShiftAVX2( shift, major, minor, count, out_major, out_minor );
+            break;
+
+        case HEX_BATCH_SSE2:
+            done = OffsetShiftSSE2( shift, major, minor, count, out_major, out_minor );
+            break;
+
+        default:
+            break;
+    }
+#else
+    (void) kernel;
+#endif
+
+    // Остаток пакета (или весь пакет без SIMD)
+    OffsetShiftScalar( shift, major + done, minor + done, count - done, out_major + done, out_minor + done );
+}
+
+// ================================================================
+// Офсетные координаты => Кубические координаты
+// ================================================================
+void OffsetToCubeBatch( const HexLayout& layout, const int* col, const int* row, size_t count,
+                        int* q, int* r, HexBatchKernel_t kernel ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_OFFSET_TO_CUBE_BATCH );
+
+    const OffsetShift shift( layout.offset_type, true );
+
+    if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
+        // Q_Offset_to_Cube: q = col, r = row - ( col + offset_type * ( col & 1 ) ) / 2
+        OffsetShiftBatch( shift, col, row, count, q, r, kernel );
+    } else {
+        // R_Offset_to_Cube: r = row, q = col - ( row + offset_type * ( row & 1 ) ) / 2
+        OffsetShiftBatch( shift, row, col, count, r, q, kernel );
+    }
+}
+
+// ================================================================
+// Кубические координаты => Офсетные координаты
+// ================================================================
+void CubeToOffsetBatch( const HexLayout& layout, const int* q, const int* r, size_t count,
+                        int* col, int* row, HexBatchKernel_t kernel ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_CUBE_TO_OFFSET_BATCH );
+
+    const OffsetShift shift( layout.offset_type, false );
+
+    if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
+        // Cube_to_Offset_Q: col = q, row = r + ( q + offset_type * ( q & 1 ) ) / 2
+        OffsetShiftBatch( shift, q, r, count, col, row, kernel );
+    } else {
+        // Cube_to_Offset_R: row = r, col = q + ( r + offset_type * ( r & 1 ) ) / 2
+        OffsetShiftBatch( shift, r, q, count, row, col, kernel );
+    }
+}
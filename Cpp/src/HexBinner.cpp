@@ -0,0 +1,283 @@
+/*
+ * HexBinner.cpp
+ *
+ * Потоковый подсчёт точек по гексам (гистограмма)
+ */
+
+#include "HexBinner.h"
+#include "HexBatch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#if defined( __has_include )
+#if __has_include( <charconv> )
+#include <charconv>
+#endif
+#endif
+
+// Средняя длина строки текста для размера блока чтения
+static const size_t HEX_BINNER_TEXT_LINE = 32;
+
+// Размер части блока текста для одного задания
+static const size_t HEX_BINNER_TEXT_PIECE = 1 << 16;
+
+// ================================================================
+// Разбор текста
+// ================================================================
+static const char* SkipSeparators( const char* p, const char* end ) {
+    while ( p != end && ( *p == ' ' || *p == '\t' || *p == ',' || *p == ';' || *p == '\r' ) ) {
+        ++p;
+    }
+
+    return p;
+}
+
+// Число с начала p (nullptr - ошибка)
+static const char* ParseNumber( const char* p, const char* end, double& value ) {
+#if defined( __cpp_lib_to_chars ) && __cpp_lib_to_chars >= 201611L
+    // from_chars не принимает знак '+'
+    if ( p != end && *p == '+' ) {
+        ++p;
+    }
+
+    const std::from_chars_result result = std::from_chars( p, end, value );
+    return ( result.ec == std::errc() ? result.ptr : nullptr );
+#else
+    // strtod пропускает начальные пробелы (включая '\n' - конец строки),
+    // поэтому число должно начинаться с p и заканчиваться не дальше end
+    if ( p == end || isspace( static_cast<unsigned char>( *p ) ) ) {
+        return nullptr;
+    }
+
+    char* next = nullptr;
+    value = strtod( p, &next );
+    return ( next != p && next <= end ? next : nullptr );
+#endif
+}
+
+HexBinner::HexBinner( const HexLayout& layout_, HexThreadPool* pool_, size_t chunk_points_ ) :
+    layout( layout_ ), pool( pool_ ), chunk_points( std::max( chunk_points_, BATCH_SIZE ) ) {
+    const unsigned threads = ( pool != nullptr ? pool->ThreadCount() : 1 );
+
+    for ( unsigned thread = 0; thread != threads; ++thread ) {
+        std::unique_ptr<Worker> worker( new Worker() );
+        worker->x.resize( BATCH_SIZE );
+        worker->y.resize( BATCH_SIZE );
+        worker->q.resize( BATCH_SIZE );
+        worker->r.resize( BATCH_SIZE );
+        workers.push_back( std::move( worker ) );
+    }
+}
+
+// ================================================================
+// Точки из массивов
+// ================================================================
+void HexBinner::Add( const double* x, const double* y, size_t count ) {
+    Run( ( count + BATCH_SIZE - 1 ) / BATCH_SIZE, [this, x, y, count]( size_t index, Worker& worker ) {
+        const size_t begin = index * BATCH_SIZE;
+        Bin( worker, x + begin, y + begin, std::min( BATCH_SIZE, count - begin ) );
+    } );
+}
+
+// ================================================================
+// Точки из текстового потока
+// ================================================================
+uint64_t HexBinner::ReadText( std::istream& input ) {
+    const uint64_t points_before = Points();
+    vector<char> buffer( chunk_points * HEX_BINNER_TEXT_LINE + 1 );
+    vector<const char*> pieces;
+    size_t carry = 0;
+
+    while ( true ) {
+        input.read( buffer.data() + carry, static_cast<std::streamsize>( buffer.size() - 1 - carry ) );
+        size_t size = carry + static_cast<size_t>( input.gcount() );
+        const bool done = !input;
+
+        // Последняя строка без '\n'
+        if ( done && size != 0 && buffer[ size - 1 ] != '\n' ) {
+            buffer[ size++ ] = '\n';
+        }
+
+        // Блок заканчивается последним полным символом '\n'
+        size_t lines_end = size;
+
+        while ( lines_end != 0 && buffer[ lines_end - 1 ] != '\n' ) {
+            --lines_end;
+        }
+
+        if ( lines_end == 0 && !done ) {
+            // Строка длиннее блока
+            buffer.resize( buffer.size() * 2 );
+            carry = size;
+            continue;
+        }
+
+        // Части блока по границам строк
+        const char* const data = buffer.data();
+        pieces.assign( 1, data );
+
+        while ( pieces.back() != data + lines_end ) {
+            const char* end = std::min( pieces.back() + HEX_BINNER_TEXT_PIECE, data + lines_end );
+            end = static_cast<const char*>( memchr( end - 1, '\n', static_cast<size_t>( data + lines_end - ( end - 1 ) ) ) ) + 1;
+            pieces.push_back( end );
+        }
+
+        Run( pieces.size() - 1, [this, &pieces]( size_t index, Worker& worker ) {
+            ParseText( worker, pieces[ index ], pieces[ index + 1 ] );
+        } );
+
+        carry = size - lines_end;
+        memmove( buffer.data(), buffer.data() + lines_end, carry );
+
+        if ( done ) {
+            break;
+        }
+    }
+
+    return Points() - points_before;
+}
+
+void HexBinner::ParseText( Worker& worker, const char* begin, const char* end ) const {
+    size_t count = 0;
+
+    for ( const char* line = begin; line != end; ) {
+        const char* line_end = static_cast<const char*>( memchr( line, '\n', static_cast<size_t>( end - line ) ) );
+        const char* p = SkipSeparators( line, line_end );
+
+        if ( p != line_end ) {
+            p = ParseNumber( p, line_end, worker.x[ count ] );
+
+            if ( p != nullptr ) {
+                p = ParseNumber( SkipSeparators( p, line_end ), line_end, worker.y[ count ] );
+            }
+
+            if ( p != nullptr && SkipSeparators( p, line_end ) == line_end ) {
+                if ( ++count == BATCH_SIZE ) {
+                    Bin( worker, worker.x.data(), worker.y.data(), count );
+                    count = 0;
+                }
+            } else {
+                ++worker.rejected;
+            }
+        }
+
+        line = line_end + 1;
+    }
+
+    Bin( worker, worker.x.data(), worker.y.data(), count );
+}
+
+// ================================================================
+// Точки из двоичного потока
+// ================================================================
+uint64_t HexBinner::ReadBinary( std::istream& input ) {
+    const uint64_t points_before = Points();
+    vector<double> buffer( chunk_points * 2 );
+
+    while ( input ) {
+        input.read( reinterpret_cast<char*>( buffer.data() ), static_cast<std::streamsize>( buffer.size() * sizeof( double ) ) );
+        const size_t count = static_cast<size_t>( input.gcount() ) / ( 2 * sizeof( double ) );
+
+        Run( ( count + BATCH_SIZE - 1 ) / BATCH_SIZE, [this, &buffer, count]( size_t index, Worker& worker ) {
+            const size_t begin = index * BATCH_SIZE;
+            const size_t length = std::min( BATCH_SIZE, count - begin );
+            const double* point = &buffer[ 2 * begin ];
+
+            for ( size_t i = 0; i != length; ++i ) {
+                worker.x[ i ] = point[ 2 * i ];
+                worker.y[ i ] = point[ 2 * i + 1 ];
+            }
+
+            Bin( worker, worker.x.data(), worker.y.data(), length );
+        } );
+    }
+
+    return Points() - points_before;
+}
+
+// ================================================================
+// Подсчёт пакета точек
+// ================================================================
+void HexBinner::Bin( Worker& worker, const double* x, const double* y, size_t count ) const {
+    PixelToHexBatch( layout, x, y, count, worker.q.data(), worker.r.data() );
+
+    // Соседние точки обычно попадают в один чанк: чанк ищется только при смене
+    Hex origin( 0, 0 );
+    uint64_t* cells = nullptr;
+
+    for ( size_t i = 0; i != count; ++i ) {
+        const Hex hex( worker.q[ i ], worker.r[ i ] );
+        const Hex hex_origin = HexChunkMap<uint64_t>::ChunkOrigin( hex );
+
+        if ( cells == nullptr || hex_origin != origin ) {
+            cells = worker.counts.ChunkCells( hex );
+            origin = hex_origin;
+        }
+
+        ++cells[ HexChunkMap<uint64_t>::ChunkCellIndex( hex ) ];
+    }
+
+    worker.points += count;
+}
+
+void HexBinner::Run( size_t tasks, const std::function<void( size_t, Worker& )>& task ) {
+    if ( pool != nullptr ) {
+        pool->ParallelFor( tasks, [this, &task]( size_t index, unsigned thread ) { task( index, *workers[ thread ] ); } );
+    } else {
+        for ( size_t index = 0; index != tasks; ++index ) {
+            task( index, *workers[ 0 ] );
+        }
+    }
+}
+
+// ================================================================
+// Результаты
+// ================================================================
+uint64_t HexBinner::Points() const {
+    uint64_t result = 0;
+
+    for ( const std::unique_ptr<Worker>& worker : workers ) {
+        result += worker->points;
+    }
+
+    return result;
+}
+
+uint64_t HexBinner::Rejected() const {
+    uint64_t result = 0;
+
+    for ( const std::unique_ptr<Worker>& worker : workers ) {
+        result += worker->rejected;
+    }
+
+    return result;
+}
+
+HexChunkMap<uint64_t>& HexBinner::Histogram() {
+    for ( const std::unique_ptr<Worker>& worker : workers ) {
+        worker->counts.ForEachChunk( [this]( const Hex& origin, uint64_t* cells ) {
+            uint64_t* target = histogram.ChunkCells( origin );
+
+            for ( size_t i = 0; i != HexChunkMap<uint64_t>::CHUNK_SIZE; ++i ) {
+                target[ i ] += cells[ i ];
+            }
+        } );
+
+        worker->counts.Clear();
+    }
+
+    return histogram;
+}
+
+void HexBinner::Clear() {
+    histogram.Clear();
+
+    for ( const std::unique_ptr<Worker>& worker : workers ) {
+        worker->counts.Clear();
+        worker->points = 0;
+        worker->rejected = 0;
+    }
+}
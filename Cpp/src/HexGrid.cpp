@@ -5,8 +5,9 @@
  */
 
 #include "HexGrid.h"
+#include "HexProfile.h"
 
-#include <ctime>
+#include <random>
 
 // Значение числа Пи
 #ifndef M_PI
@@ -15,34 +16,13 @@
 
 using std::abs;
 using std::max;
+using std::min;
 using std::logic_error;
 
-// ================================================================
-// Количество направлений
-// ================================================================
-const unsigned HEX_DIRECTION_COUNT = 6;
-
-// ================================================================
-// Количество углов гекса
-// ================================================================
-const unsigned HEX_CORNERS_COUNT = 6;
-
-// ================================================================
-// Список направлений
-// ================================================================
-const vector<Hex> HEX_DIRECTIONS = {
-    Hex( 1, 0 ),
-    Hex( 1, -1 ),
-    Hex( 0, -1 ),
-    Hex( -1, 0 ),
-    Hex( -1, 1 ),
-    Hex( 0, 1 )
-};
-
 // ================================================================
 // Список диагоналей
 // ================================================================
-const vector<Hex> HEX_DIAGONALS = {
+constexpr Hex HEX_DIAGONALS[ HEX_DIRECTION_COUNT ] = {
     Hex( 2, -1 ),
     Hex( 1, -2 ),
     Hex( -1, -1 ),
@@ -80,67 +60,124 @@ ostream& operator <<( ostream& os, const Point& right ) {
 }
 
 // ================================================================
-// Операции над офсетными координатами
+// Строка матрицы ориентации
 // ================================================================
-bool operator ==( const OffsetHex& left, const OffsetHex& right ) {
-    return ( left.col == right.col && left.row == right.row );
+static array<double, 4> HexLayoutMatrix( const double ( &matrix )[ 2 ][ 4 ], HexOrientation_t orientation ) {
+    return { { matrix[ orientation ][ 0 ], matrix[ orientation ][ 1 ], matrix[ orientation ][ 2 ], matrix[ orientation ][ 3 ] } };
 }
 
-bool operator !=( const OffsetHex& left, const OffsetHex& right ) {
-    return ( left.col != right.col || left.row != right.row );
-}
+// ================================================================
+// Смещения углов гекса относительно центра
+// ================================================================
+static array<Point, HEX_CORNER_COUNT> HexLayoutCorners( double start_angle, const Point& size ) {
+    array<Point, HEX_CORNER_COUNT> corners;
 
-ostream& operator <<( ostream& os, const OffsetHex& right ) {
-    os << "OffsetHex(" << right.col << "," << right.row << ")";
-    return os;
+    for ( unsigned corner = 0; corner != HEX_CORNER_COUNT; ++corner ) {
+        double angle = M_PI * ( start_angle + corner ) / 3.0L;
+        corners[ corner ] = Point( size.x * cos( angle ), size.y * sin( angle ) );
+    }
+
+    return corners;
 }
 
 // ================================================================
-// Операции над кубическими координатами
+// Угол ограничивающего прямоугольника (sign < 0 - минимум, иначе максимум)
 // ================================================================
-bool operator ==( const Hex& left, const Hex& right ) {
-    return ( left.coord == right.coord );
-}
+static Point HexLayoutBound( const array<Point, HEX_CORNER_COUNT>& corners, int sign ) {
+    Point bound = corners[ 0 ];
 
-bool operator !=( const Hex& left, const Hex& right ) {
-    return ( left.coord != right.coord );
-}
+    for ( const Point& corner : corners ) {
+        bound.x = ( sign < 0 ? min( bound.x, corner.x ) : max( bound.x, corner.x ) );
+        bound.y = ( sign < 0 ? min( bound.y, corner.y ) : max( bound.y, corner.y ) );
+    }
 
-Hex operator +( const Hex& left, const Hex& right ) {
-    return Hex( left.Q() + right.Q(), left.R() + right.R() );
+    return bound;
 }
 
-Hex operator -( const Hex& left, const Hex& right ) {
-    return Hex( left.Q() - right.Q(), left.R() - right.R() );
-}
+// ================================================================
+// Рёбра многоугольника гекса (внутренняя сторона - сторона центра)
+// ================================================================
+static array<HexEdge, HEX_CORNER_COUNT> HexLayoutEdges( const array<Point, HEX_CORNER_COUNT>& corners ) {
+    array<HexEdge, HEX_CORNER_COUNT> edges;
 
-Hex operator *( const Hex& left, int right ) {
-    return Hex( left.Q() * right, left.R() * right );
-}
+    for ( unsigned i = 0; i != HEX_CORNER_COUNT; ++i ) {
+        const Point& from = corners[ i ];
+        const Point& to = corners[ ( i + 1 ) % HEX_CORNER_COUNT ];
+        double a = to.y - from.y;
+        double b = from.x - to.x;
 
-ostream& operator <<( ostream& os, const Hex& right ) {
-    os << "Hex(" << right.Q() << "," << right.R() << "," << right.S() << ")";
-    return os;
+        // Остаток cos / sin у горизонтальных и вертикальных рёбер
+        const double scale = abs( a ) + abs( b );
+        a = ( abs( a ) < 1e-12 * scale ? 0.0 : a );
+        b = ( abs( b ) < 1e-12 * scale ? 0.0 : b );
+
+        const double c = a * from.x + b * from.y;
+        edges[ i ] = ( c < 0 ? HexEdge{ -a, -b, -c } : HexEdge{ a, b, c } );
+    }
+
+    return edges;
 }
 
 // ================================================================
-// Направление по модулю
+// Расположение гексов на плоскости
+// ================================================================
+HexLayout::HexLayout( HexOrientation_t orientation_, OffsetType_t offset_type_, Point size_, Point origin_ ) :
+    orientation( orientation_ ), offset_type( offset_type_ ), size( size_ ), origin( origin_ ),
+    start_angle( ( orientation_ == HEX_ORIENTATION_POINTY ? 0.5L : 0.0L ) ),
+    forward( HexLayoutMatrix( HEX_ORIENTATION_MATRIX_1, orientation_ ) ),
+    inverse( HexLayoutMatrix( HEX_ORIENTATION_MATRIX_2, orientation_ ) ),
+    corners( HexLayoutCorners( start_angle, size_ ) ),
+    bounds_min( HexLayoutBound( corners, -1 ) ), bounds_max( HexLayoutBound( corners, 1 ) ),
+    edges( HexLayoutEdges( corners ) ) {}
+
+// ================================================================
+// Отрезок строки развёртки (пересечение полуплоскостей рёбер)
 // ================================================================
-unsigned AbsDirection( int direction ) {
-    direction %= HEX_DIRECTION_COUNT;
+bool HexLayout::RowSpan( double dy, double& x_min, double& x_max ) const {
+    x_min = bounds_min.x;
+    x_max = bounds_max.x;
+
+    if ( dy < bounds_min.y || dy > bounds_max.y ) {
+        return false;
+    }
+
+    for ( const HexEdge& edge : edges ) {
+        const double limit = edge.c - edge.b * dy;
 
-    if ( direction < 0 ) {
-        direction += HEX_DIRECTION_COUNT;
+        if ( edge.a > 0 ) {
+            x_max = min( x_max, limit / edge.a );
+        } else if ( edge.a < 0 ) {
+            x_min = max( x_min, limit / edge.a );
+        } else if ( limit < 0 ) {
+            return false;
+        }
     }
 
-    return direction;
+    return ( x_min <= x_max );
 }
 
 // ================================================================
-// Направление
+// Операции над офсетными координатами
 // ================================================================
-const Hex& HexDirection( int direction ) {
-    return HEX_DIRECTIONS[ AbsDirection( direction ) ];
+bool operator ==( const OffsetHex& left, const OffsetHex& right ) {
+    return ( left.col == right.col && left.row == right.row );
+}
+
+bool operator !=( const OffsetHex& left, const OffsetHex& right ) {
+    return ( left.col != right.col || left.row != right.row );
+}
+
+ostream& operator <<( ostream& os, const OffsetHex& right ) {
+    os << "OffsetHex(" << right.col << "," << right.row << ")";
+    return os;
+}
+
+// ================================================================
+// Операции над кубическими координатами
+// ================================================================
+ostream& operator <<( ostream& os, const Hex& right ) {
+    os << "Hex(" << right.Q() << "," << right.R() << "," << right.S() << ")";
+    return os;
 }
 
 // ================================================================
@@ -150,16 +187,35 @@ Hex Hex::HexNeighbor( int direction ) const {
     return (*this) + HEX_DIRECTIONS[ AbsDirection( direction ) ];
 }
 
+// ================================================================
+// Гексы hex + steps[ i ] => out
+// ================================================================
+static void HexOffsetsFill( const Hex& hex, const Hex* steps, Hex* out ) {
+    for ( unsigned i = 0; i != HEX_DIRECTION_COUNT; ++i ) {
+        out[ i ] = hex + steps[ i ];
+    }
+}
+
 // ================================================================
 // Соседние гексы
 // ================================================================
 vector<Hex> Hex::HexNeighbors() const {
-    vector<Hex> neighbors;
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_NEIGHBORS );
 
-    for ( const auto& hexDirection : HEX_DIRECTIONS ) {
-        neighbors.push_back( (*this) + hexDirection );
-    }
+    vector<Hex> neighbors( HEX_DIRECTION_COUNT );
+    HexOffsetsFill( *this, HEX_DIRECTIONS, neighbors.data() );
+    return neighbors;
+}
 
+void Hex::HexNeighbors( Hex* out ) const {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_NEIGHBORS );
+
+    HexOffsetsFill( *this, HEX_DIRECTIONS, out );
+}
+
+array<Hex, HEX_DIRECTION_COUNT> Hex::HexNeighborsArray() const {
+    array<Hex, HEX_DIRECTION_COUNT> neighbors;
+    HexNeighbors( neighbors.data() );
     return neighbors;
 }
 
@@ -174,41 +230,61 @@ Hex Hex::HexDiagonal( int direction ) const {
 // Диагональные гексы
 // ================================================================
 vector<Hex> Hex::HexDiagonals() const {
-    vector<Hex> diagonals;
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_DIAGONALS );
 
-    for ( const auto& hexDiagonal : HEX_DIAGONALS ) {
-        diagonals.push_back( (*this) + hexDiagonal );
-    }
+    vector<Hex> diagonals( HEX_DIRECTION_COUNT );
+    HexOffsetsFill( *this, HEX_DIAGONALS, diagonals.data() );
+    return diagonals;
+}
 
+void Hex::HexDiagonals( Hex* out ) const {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_DIAGONALS );
+
+    HexOffsetsFill( *this, HEX_DIAGONALS, out );
+}
+
+array<Hex, HEX_DIRECTION_COUNT> Hex::HexDiagonalsArray() const {
+    array<Hex, HEX_DIRECTION_COUNT> diagonals;
+    HexDiagonals( diagonals.data() );
     return diagonals;
 }
 
 // ================================================================
 // Координаты гекса => Координаты на плоскости (координаты центра)
 // ================================================================
+// Офсетная система на преобразование не влияет
+// ================================================================
 Point Hex::HexToPixel( const HexLayout& layout ) const {
-    const double x = ( layout.QX() * Q() + layout.RX() * R() ) * layout.size.x;
-    const double y = ( layout.QY() * Q() + layout.RY() * R() ) * layout.size.y;
-    return Point( x + layout.origin.x, y + layout.origin.y );
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_TO_PIXEL );
+
+    if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
+        return HexLayoutFlatOdd( layout.size, layout.origin ).HexToPixel( *this );
+    } else {
+        return HexLayoutPointyOdd( layout.size, layout.origin ).HexToPixel( *this );
+    }
 }
 
 // ================================================================
 // Координаты на плоскости => Координаты гекса
 // ================================================================
+// Офсетная система на преобразование не влияет
+// ================================================================
 FractionalHex PixelToHex( const HexLayout& layout, const Point& pixel ) {
-    const double x = ( pixel.x - layout.origin.x ) / layout.size.x;
-    const double y = ( pixel.y - layout.origin.y ) / layout.size.y;
-    const double q = ( layout.XQ() * x + layout.YQ() * y );
-    const double r = ( layout.XR() * x + layout.YR() * y );
-    return FractionalHex( q, r );
+    HEX_PROFILE_SCOPE( HEX_PROFILE_PIXEL_TO_HEX );
+
+    if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
+        return HexLayoutFlatOdd( layout.size, layout.origin ).PixelToHex( pixel );
+    } else {
+        return HexLayoutPointyOdd( layout.size, layout.origin ).PixelToHex( pixel );
+    }
 }
 
 // ================================================================
 // Угол гекса на плоскости (Базовая функция)
 // ================================================================
 Point HexCornerBase( const HexLayout& layout, int corner ) {
-    double angle = M_PI * ( layout.start_angle + corner ) / 3.0L;
-    return Point( layout.size.x * cos( angle ), layout.size.y * sin( angle ) );
+    corner %= static_cast<int>( HEX_CORNER_COUNT );
+    return layout.corners[ corner < 0 ? corner + HEX_CORNER_COUNT : corner ];
 }
 
 // ================================================================
@@ -218,36 +294,78 @@ Point Hex::HexCorner( const HexLayout& layout, int corner ) const {
     return HexToPixel( layout ) + HexCornerBase( layout, corner );
 }
 
+// ================================================================
+// Углы гекса на плоскости => out
+// ================================================================
+static void HexCornersFill( const Hex& hex, const HexLayout& layout, Point* out ) {
+    const Point center = hex.HexToPixel( layout );
+
+    for ( unsigned i = 0; i != HEX_CORNER_COUNT; i++ ) {
+        out[ i ] = center + layout.corners[ i ];
+    }
+}
+
 // ================================================================
 // Углы гекса на плоскости
 // ================================================================
 vector<Point> Hex::HexCorners( const HexLayout& layout ) const {
-    vector<Point> corners;
-    const Point& center = HexToPixel( layout );
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_CORNERS );
 
-    for ( size_t i = 0; i != HEX_CORNERS_COUNT; i++ ) {
-        corners.push_back( center + HexCornerBase( layout, i ) );
-    }
+    vector<Point> corners( HEX_CORNER_COUNT );
+    HexCornersFill( *this, layout, corners.data() );
+    return corners;
+}
+
+void Hex::HexCorners( const HexLayout& layout, Point* out ) const {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_CORNERS );
+
+    HexCornersFill( *this, layout, out );
+}
 
+array<Point, HEX_CORNER_COUNT> Hex::HexCornersArray( const HexLayout& layout ) const {
+    array<Point, HEX_CORNER_COUNT> corners;
+    HexCorners( layout, corners.data() );
     return corners;
 }
 
+// ================================================================
+// Генератор алгоритма округления (свой у каждого потока)
+// ================================================================
+static std::minstd_rand& HexRoundGenerator() {
+    thread_local std::minstd_rand generator( HEX_ROUND_SEED );
+    return generator;
+}
+
+// ================================================================
+// Инициализация генератора алгоритма округления текущего потока
+// ================================================================
+void HexRoundSeed( unsigned seed ) {
+    HexRoundGenerator().seed( seed );
+}
+
 // ================================================================
 // Выбор алгоритма округления кубических координат
 // ================================================================
-int HexRoundAlgorithm() {
+int HexRoundAlgorithm( int round_algorithm ) {
+    if ( round_algorithm >= 0 ) {
+        return round_algorithm;
+    }
+
 #if HEX_ROUND_ALGORITHM_RANDOM
-    srand( time( 0 ) );
-    return rand() % 3;
-#else
-    return HEX_ROUND_ALGORITHM;
+    round_algorithm = HEX_ROUND_RANDOM;
 #endif
+
+    if ( round_algorithm == HEX_ROUND_RANDOM ) {
+        return HexRoundGenerator()() % 3;
+    }
+
+    return HEX_ROUND_ALGORITHM;
 }
 
 // ================================================================
 // Дробные координаты (Кубические)
 // ================================================================
-FractionalHex::FractionalHex( double q_, double r_, double s_ ) : coord( { q_, r_, s_ } ) {
+FractionalHex::FractionalHex( double q_, double r_, double s_ ) : coord{ q_, r_, s_ } {
     if ( round(Q() + R() + S()) != 0) {
         throw logic_error("Q + R + S must be 0.");
     }
@@ -257,6 +375,8 @@ FractionalHex::FractionalHex( double q_, double r_, double s_ ) : coord( { q_, r
 // Округление кубических координат
 // ================================================================
 Hex FractionalHex::Round( int round_algorithm ) const {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_ROUND );
+
     // Округляем координаты
     const double q = int( round( Q() ) );
     const double r = int( round( R() ) );
@@ -269,7 +389,7 @@ Hex FractionalHex::Round( int round_algorithm ) const {
 
     // Выбор алгоритма округления, если он не выбран
     if ( round_algorithm < 0 ) {
-        round_algorithm = HexRoundAlgorithm();
+        round_algorithm = HexRoundAlgorithm( round_algorithm );
     }
 
     // Отбрасываем координату с наибольшей дельтой
@@ -331,57 +451,63 @@ FractionalHex HexLinearInterpolation( const FractionalHex& hex_a, const Fraction
 }
 
 // ================================================================
-// Линия гексов
+// Количество гексов линии
 // ================================================================
-vector<Hex> HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range ) {
-    // Выбор алгоритма округления
-    const int round_algorithm = HexRoundAlgorithm();
-
-    // Расстояние между гексами
+unsigned HexLineSize( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range ) {
     const unsigned distance = HexDistance( hex_a, hex_b );
+    return ( !use_range || range > distance ? distance : range ) + 1;
+}
 
-    // Максимальный радиус
-    if ( !use_range || range > distance ) {
-        range = distance;
-    }
+// ================================================================
+// Линия гексов => out (Линейная интерполяция)
+// ================================================================
+static size_t HexLineFill( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, Hex* out,
+                           int round_algorithm ) {
+    // Выбор алгоритма округления
+    round_algorithm = HexRoundAlgorithm( round_algorithm );
 
-    // Строим линию гексов (Линейная интерполяция)
-    vector<Hex> hex_line;
+    // Расстояние между гексами и количество гексов (с учётом максимального радиуса)
+    const unsigned distance = HexDistance( hex_a, hex_b );
+    const unsigned count = HexLineSize( hex_a, hex_b, use_range, range );
     double step = 1.0L / max( distance, 1U );
 
-    for ( unsigned i = 0; i <= range; ++i ) {
-        hex_line.push_back( HexLinearInterpolation( hex_a, hex_b, step * i ).Round( round_algorithm ) );
+    for ( unsigned i = 0; i != count; ++i ) {
+        out[ i ] = HexLinearInterpolation( hex_a, hex_b, step * i ).Round( round_algorithm );
     }
 
-    return hex_line;
+    return count;
 }
 
 // ================================================================
-// Офсетные координаты -> Кубические координаты
-// ================================================================
-// Ориентация гекса на плоскости "Плоский" (HEX_ORIENTATION_FLAT)
+// Линия гексов
 // ================================================================
-Hex Q_Offset_to_Cube( OffsetType_t offset_type, const OffsetHex& offset ) {
-    int q = offset.col;
-    int r = offset.row - ( offset.col + static_cast<int>( offset_type ) * ( offset.col & 1 ) ) / 2;
-    return Hex( q, r );
+vector<Hex> HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, int round_algorithm ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_LINE );
+
+    vector<Hex> hex_line( HexLineSize( hex_a, hex_b, use_range, range ) );
+    HexLineFill( hex_a, hex_b, use_range, range, hex_line.data(), round_algorithm );
+    return hex_line;
 }
 
-// ================================================================
-// Офсетные координаты -> Кубические координаты
-// ================================================================
-// Ориентация гекса на плоскости "Заострённый" (HEX_ORIENTATION_POINTY)
-// ================================================================
-Hex R_Offset_to_Cube( OffsetType_t offset_type, const OffsetHex& offset ) {
-    int q = offset.col - ( offset.row + static_cast<int>( offset_type ) * ( offset.row & 1 ) ) / 2;
-    int r = offset.row;
-    return Hex( q, r );
+size_t HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, Hex* out, int round_algorithm ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_LINE );
+
+    return HexLineFill( hex_a, hex_b, use_range, range, out, round_algorithm );
+}
+
+void HexLine( const Hex& hex_a, const Hex& hex_b, bool use_range, unsigned range, vector<Hex>& line, int round_algorithm ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_LINE );
+
+    line.resize( HexLineSize( hex_a, hex_b, use_range, range ) );
+    HexLineFill( hex_a, hex_b, use_range, range, line.data(), round_algorithm );
 }
 
 // ================================================================
 // Офсетные координаты -> Кубические координаты
 // ================================================================
 Hex Offset_to_Cube( const HexLayout& layout, const OffsetHex& offset ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_OFFSET_TO_CUBE );
+
     if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
         return Q_Offset_to_Cube( layout.offset_type, offset );
     } else {
@@ -389,36 +515,16 @@ Hex Offset_to_Cube( const HexLayout& layout, const OffsetHex& offset ) {
     }
 }
 
-// ================================================================
-// Кубические координаты -> Офсетные координаты
-// ================================================================
-// Ориентация гекса на плоскости "Плоский" (HEX_ORIENTATION_FLAT)
-// ================================================================
-OffsetHex Cube_to_Offset_Q( OffsetType_t offset_type, const Hex& hex ) {
-    int col = hex.Q();
-    int row = hex.R() + ( hex.Q() + static_cast<int>( offset_type ) * ( hex.Q() & 1 ) ) / 2;
-    return OffsetHex( col, row );
-}
-
-// ================================================================
-// Кубические координаты -> Офсетные координаты
-// ================================================================
-// Ориентация гекса на плоскости "Заострённый" (HEX_ORIENTATION_POINTY)
-// ================================================================
-OffsetHex Cube_to_Offset_R( OffsetType_t offset_type, const Hex& hex ) {
-    int col = hex.Q() + ( hex.R() + static_cast<int>( offset_type ) * ( hex.R() & 1 ) ) / 2;
-    int row = hex.R();
-    return OffsetHex( col, row );
-}
-
 // ================================================================
 // Кубические координаты -> Офсетные координаты
 // ================================================================
 OffsetHex Cube_to_Offset( const HexLayout& layout, const Hex& hex ) {
+    HEX_PROFILE_SCOPE( HEX_PROFILE_CUBE_TO_OFFSET );
+
     if ( layout.orientation == HEX_ORIENTATION_FLAT ) {
-        return Cube_to_Offset_Q( layout.offset_type, cube );
+        return Cube_to_Offset_Q( layout.offset_type, hex );
     } else {
-        return Cube_to_Offset_R( layout.offset_type, cube );
+        return Cube_to_Offset_R( layout.offset_type, hex );
     }
 }
 
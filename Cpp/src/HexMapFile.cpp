@@ -0,0 +1,445 @@
+/*
+ * HexMapFile.cpp
+ *
+ * Двоичный файл карты гексов: отображение в память без разбора и копирования
+ */
+
+#include "HexMapFile.h"
+#include "HexKey.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Размер буфера записи
+static const size_t HEX_MAP_FILE_BUFFER = 1 << 20;
+
+const char* HexMapFileStatusText( HexMapFileStatus_t status ) {
+    switch ( status ) {
+    case HEX_MAP_FILE_OK: return "OK";
+    case HEX_MAP_FILE_IO_ERROR: return "I/O error";
+    case HEX_MAP_FILE_TRUNCATED: return "file is truncated";
+    case HEX_MAP_FILE_BAD_MAGIC: return "not a hex map file";
+    case HEX_MAP_FILE_BAD_ENDIAN: return "byte order mismatch";
+    case HEX_MAP_FILE_BAD_VERSION: return "unsupported version";
+    case HEX_MAP_FILE_BAD_HEADER: return "invalid header";
+    case HEX_MAP_FILE_BAD_ROWS: return "invalid row table";
+    case HEX_MAP_FILE_BAD_CELL_TYPE: return "cell type mismatch";
+    case HEX_MAP_FILE_BAD_CHECKSUM: return "checksum mismatch";
+    }
+
+    return "unknown status";
+}
+
+// ================================================================
+// Контрольная сумма
+// ================================================================
+void HexMapFileHasher::Update( const void* data, size_t size ) {
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+
+    // Дополнение неполного слова
+    while ( size != 0 && ( length & 7 ) != 0 ) {
+        pending[ length & 7 ] = *bytes++;
+        --size;
+
+        if ( ( ++length & 7 ) == 0 ) {
+            uint64_t word;
+            memcpy( &word, pending, sizeof( word ) );
+            Mix( word );
+        }
+    }
+
+    for ( ; size >= 8; bytes += 8, size -= 8, length += 8 ) {
+        uint64_t word;
+        memcpy( &word, bytes, sizeof( word ) );
+        Mix( word );
+    }
+
+    for ( ; size != 0; --size ) {
+        pending[ length++ & 7 ] = *bytes++;
+    }
+}
+
+uint64_t HexMapFileHasher::Value() const {
+    HexMapFileHasher hasher( *this );
+
+    if ( ( length & 7 ) != 0 ) {
+        unsigned char tail[ 8 ] = {};
+        memcpy( tail, pending, length & 7 );
+        uint64_t word;
+        memcpy( &word, tail, sizeof( word ) );
+        hasher.Mix( word );
+    }
+
+    return HexHash64( hasher.state ^ length );
+}
+
+// ================================================================
+// Отображение файла в память
+// ================================================================
+HexMappedFile& HexMappedFile::operator =( HexMappedFile&& other ) noexcept {
+    if ( this != &other ) {
+        Close();
+        std::swap( data, other.data );
+        std::swap( size, other.size );
+    }
+
+    return *this;
+}
+
+bool HexMappedFile::Open( const string& path ) {
+    Close();
+
+#if defined( _WIN32 )
+    const HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr );
+
+    if ( file == INVALID_HANDLE_VALUE ) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    bool result = ( GetFileSizeEx( file, &file_size ) != 0 );
+
+    if ( result && file_size.QuadPart != 0 ) {
+        const HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+        const void* view = ( mapping != nullptr ? MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) : nullptr );
+
+        // Отображение остаётся действительным после закрытия описателей
+        if ( mapping != nullptr ) {
+            CloseHandle( mapping );
+        }
+
+        result = ( view != nullptr );
+        data = static_cast<const unsigned char*>( view );
+        size = ( result ? static_cast<size_t>( file_size.QuadPart ) : 0 );
+    }
+
+    CloseHandle( file );
+    return result;
+#else
+    const int file = open( path.c_str(), O_RDONLY );
+
+    if ( file < 0 ) {
+        return false;
+    }
+
+    struct stat info;
+    bool result = ( fstat( file, &info ) == 0 );
+
+    if ( result && info.st_size != 0 ) {
+        void* view = mmap( nullptr, static_cast<size_t>( info.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+        result = ( view != MAP_FAILED );
+
+        if ( result ) {
+            data = static_cast<const unsigned char*>( view );
+            size = static_cast<size_t>( info.st_size );
+        }
+    }
+
+    // Отображение остаётся действительным после закрытия файла
+    close( file );
+    return result;
+#endif
+}
+
+void HexMappedFile::Close() {
+    if ( data != nullptr ) {
+#if defined( _WIN32 )
+        UnmapViewOfFile( data );
+#else
+        munmap( const_cast<unsigned char*>( data ), size );
+#endif
+    }
+
+    data = nullptr;
+    size = 0;
+}
+
+// ================================================================
+// Проверка файла карты в памяти
+// ================================================================
+HexMapFileStatus_t HexMapFileCheck( const unsigned char* data, size_t size, uint32_t cell_size, uint32_t cell_align,
+                                    uint32_t cell_tag, bool checksum ) {
+    if ( size < sizeof( HexMapFileHeader ) ) {
+        return HEX_MAP_FILE_TRUNCATED;
+    }
+
+    HexMapFileHeader header;
+    memcpy( &header, data, sizeof( header ) );
+
+    if ( memcmp( header.magic, HEX_MAP_FILE_MAGIC, sizeof( header.magic ) ) != 0 ) {
+        return HEX_MAP_FILE_BAD_MAGIC;
+    }
+
+    if ( header.endian != HEX_MAP_FILE_ENDIAN ) {
+        return HEX_MAP_FILE_BAD_ENDIAN;
+    }
+
+    if ( header.version != HEX_MAP_FILE_VERSION ) {
+        return HEX_MAP_FILE_BAD_VERSION;
+    }
+
+    // Поля заголовка
+    const bool cell_type_valid = ( header.cell_size != 0 && header.cell_align != 0 && header.cell_align <= HEX_MAP_FILE_ALIGN
+                                   && ( header.cell_align & ( header.cell_align - 1 ) ) == 0
+                                   && header.cell_size % header.cell_align == 0 );
+    const bool layout_valid = ( ( header.orientation == HEX_ORIENTATION_FLAT || header.orientation == HEX_ORIENTATION_POINTY )
+                                && ( header.offset_type == OFFSET_TYPE_ODD || header.offset_type == OFFSET_TYPE_EVEN )
+                                && std::isfinite( header.size_x ) && std::isfinite( header.size_y )
+                                && std::isfinite( header.origin_x ) && std::isfinite( header.origin_y ) );
+    const bool shape_valid = ( header.by_column <= 1
+                               && ( header.order == HEX_MAP_ORDER_ROWS || header.order == HEX_MAP_ORDER_MORTON ) );
+
+    if ( header.header_size != sizeof( HexMapFileHeader ) || !cell_type_valid || !layout_valid || !shape_valid ) {
+        return HEX_MAP_FILE_BAD_HEADER;
+    }
+
+    // Части файла идут подряд: заголовок, строки, выравнивание, ячейки
+    const uint64_t max_size = UINT64_MAX / 2;
+
+    if ( header.rows_offset != sizeof( HexMapFileHeader ) || header.rows > max_size / sizeof( HexMapFileRow )
+         || header.cell_count > max_size / header.cell_size || header.cells_offset > max_size
+         || header.cells_offset % HEX_MAP_FILE_ALIGN != 0
+         || header.cells_offset < header.rows_offset + header.rows * sizeof( HexMapFileRow )
+         || header.cells_offset - ( header.rows_offset + header.rows * sizeof( HexMapFileRow ) ) >= HEX_MAP_FILE_ALIGN
+         || header.file_size != header.cells_offset + header.cell_count * header.cell_size ) {
+        return HEX_MAP_FILE_BAD_HEADER;
+    }
+
+    if ( size != header.file_size ) {
+        return ( size < header.file_size ? HEX_MAP_FILE_TRUNCATED : HEX_MAP_FILE_BAD_HEADER );
+    }
+
+    if ( cell_size != 0 && ( header.cell_size != cell_size || header.cell_align != cell_align ) ) {
+        return HEX_MAP_FILE_BAD_CELL_TYPE;
+    }
+
+    if ( cell_tag != 0 && header.cell_tag != cell_tag ) {
+        return HEX_MAP_FILE_BAD_CELL_TYPE;
+    }
+
+    // Строки: координаты в диапазоне int, сумма длин - количество ячеек
+    if ( header.rows != 0 && static_cast<int64_t>( header.major_min ) + static_cast<int64_t>( header.rows - 1 ) > INT_MAX ) {
+        return HEX_MAP_FILE_BAD_ROWS;
+    }
+
+    const HexMapFileRow* rows = reinterpret_cast<const HexMapFileRow*>( data + header.rows_offset );
+    uint64_t cells = 0;
+
+    for ( uint64_t row = 0; row != header.rows; ++row ) {
+        if ( rows[ row ].length < 0 || static_cast<int64_t>( rows[ row ].minor_min ) + rows[ row ].length - 1 > INT_MAX ) {
+            return HEX_MAP_FILE_BAD_ROWS;
+        }
+
+        cells += static_cast<uint64_t>( rows[ row ].length );
+    }
+
+    if ( cells != header.cell_count ) {
+        return HEX_MAP_FILE_BAD_ROWS;
+    }
+
+    if ( checksum ) {
+        HexMapFileHasher hasher;
+        hasher.Update( data + header.rows_offset, static_cast<size_t>( header.file_size - header.rows_offset ) );
+
+        if ( hasher.Value() != header.checksum ) {
+            return HEX_MAP_FILE_BAD_CHECKSUM;
+        }
+    }
+
+    return HEX_MAP_FILE_OK;
+}
+
+HexMapFileStatus_t HexMapFileValidate( const string& path, uint32_t cell_size, uint32_t cell_align, uint32_t cell_tag ) {
+    HexMappedFile file;
+
+    if ( !file.Open( path ) ) {
+        return HEX_MAP_FILE_IO_ERROR;
+    }
+
+    return HexMapFileCheck( file.Data(), file.Size(), cell_size, cell_align, cell_tag, true );
+}
+
+// ================================================================
+// Открытие файла карты
+// ================================================================
+HexMappedFile HexMapFileOpen( const string& path, uint32_t cell_size, uint32_t cell_align, uint32_t cell_tag ) {
+    HexMappedFile file;
+    const HexMapFileStatus_t status = ( file.Open( path )
+                                        ? HexMapFileCheck( file.Data(), file.Size(), cell_size, cell_align, cell_tag, false )
+                                        : HEX_MAP_FILE_IO_ERROR );
+
+    if ( status != HEX_MAP_FILE_OK ) {
+        throw std::runtime_error( "HexMapFile " + path + ": " + HexMapFileStatusText( status ) + "." );
+    }
+
+    return file;
+}
+
+HexLayout HexMapFileLayout( const HexMapFileHeader& header ) {
+    return HexLayout( static_cast<HexOrientation_t>( header.orientation ), static_cast<OffsetType_t>( header.offset_type ),
+                      Point( header.size_x, header.size_y ), Point( header.origin_x, header.origin_y ) );
+}
+
+HexMapShape HexMapFileShape( const unsigned char* data ) {
+    const HexMapFileHeader& header = *reinterpret_cast<const HexMapFileHeader*>( data );
+    const HexMapFileRow* rows = reinterpret_cast<const HexMapFileRow*>( data + header.rows_offset );
+    vector<int32_t> minor_min( static_cast<size_t>( header.rows ) );
+    vector<int32_t> lengths( static_cast<size_t>( header.rows ) );
+
+    for ( size_t row = 0; row != minor_min.size(); ++row ) {
+        minor_min[ row ] = rows[ row ].minor_min;
+        lengths[ row ] = rows[ row ].length;
+    }
+
+    const HexMapShape shape = HexMapShape::FromRows( header.by_column != 0, header.major_min, minor_min.data(),
+                                                     lengths.data(), minor_min.size() );
+    return ( header.order == HEX_MAP_ORDER_ROWS ? shape : shape.WithOrder( static_cast<HexMapOrder_t>( header.order ) ) );
+}
+
+// ================================================================
+// Потоковая запись файла карты
+// ================================================================
+HexMapFileOutput::HexMapFileOutput( const string& path_, const HexLayout& layout, const HexMapShape& shape,
+                                    uint32_t cell_size, uint32_t cell_align, uint32_t cell_tag ) :
+    path( path_ ), file( fopen( path_.c_str(), "wb" ) ), written( 0 ), buffer( HEX_MAP_FILE_BUFFER ), buffered( 0 ) {
+    if ( file == nullptr ) {
+        throw std::runtime_error( "HexMapFile " + path + ": cannot create file." );
+    }
+
+    memset( &header, 0, sizeof( header ) );
+    header.version = HEX_MAP_FILE_VERSION;
+    header.header_size = sizeof( HexMapFileHeader );
+    header.endian = HEX_MAP_FILE_ENDIAN;
+    header.cell_size = cell_size;
+    header.cell_align = cell_align;
+    header.cell_tag = cell_tag;
+    header.orientation = layout.orientation;
+    header.offset_type = layout.offset_type;
+    header.size_x = layout.size.x;
+    header.size_y = layout.size.y;
+    header.origin_x = layout.origin.x;
+    header.origin_y = layout.origin.y;
+    header.by_column = ( shape.ByColumn() ? 1 : 0 );
+    header.order = shape.Order();
+    header.major_min = shape.MajorMin();
+    header.rows = shape.Rows();
+    header.cell_count = shape.Size();
+    header.rows_offset = sizeof( HexMapFileHeader );
+    const uint64_t rows_end = header.rows_offset + header.rows * sizeof( HexMapFileRow );
+    header.cells_offset = ( rows_end + HEX_MAP_FILE_ALIGN - 1 ) / HEX_MAP_FILE_ALIGN * HEX_MAP_FILE_ALIGN;
+    header.file_size = header.cells_offset + header.cell_count * header.cell_size;
+
+    // Заголовок без сигнатуры (дописывается в Finish)
+    if ( fwrite( &header, sizeof( header ), 1, file ) != 1 ) {
+        Fail( "write error" );
+    }
+
+    for ( size_t row = 0; row != shape.Rows(); ++row ) {
+        const HexMapFileRow file_row = { shape.RowMinor( row ), static_cast<int32_t>( shape.RowLength( row ) ) };
+        memcpy( &buffer[ buffered ], &file_row, sizeof( file_row ) );
+        buffered += sizeof( file_row );
+
+        if ( buffered == buffer.size() ) {
+            Flush();
+        }
+    }
+
+    const unsigned char zeros[ HEX_MAP_FILE_ALIGN ] = {};
+    const size_t padding = static_cast<size_t>( header.cells_offset - rows_end );
+    Flush();
+    hasher.Update( zeros, padding );
+
+    if ( fwrite( zeros, 1, padding, file ) != padding ) {
+        Fail( "write error" );
+    }
+}
+
+HexMapFileOutput::~HexMapFileOutput() {
+    if ( file != nullptr ) {
+        fclose( file );
+    }
+}
+
+void HexMapFileOutput::WriteBytes( const void* data, size_t size ) {
+    CheckOpen();
+
+    if ( size > header.cell_count * header.cell_size - written ) {
+        Fail( "too many cells" );
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    written += size;
+
+    while ( size != 0 ) {
+        const size_t part = std::min( size, buffer.size() - buffered );
+        memcpy( &buffer[ buffered ], bytes, part );
+        buffered += part;
+        bytes += part;
+        size -= part;
+
+        if ( buffered == buffer.size() ) {
+            Flush();
+        }
+    }
+}
+
+void HexMapFileOutput::Finish() {
+    CheckOpen();
+
+    if ( written != header.cell_count * header.cell_size ) {
+        Fail( "not all cells are written" );
+    }
+
+    Flush();
+    header.checksum = hasher.Value();
+    memcpy( header.magic, HEX_MAP_FILE_MAGIC, sizeof( header.magic ) );
+
+    if ( fseek( file, 0, SEEK_SET ) != 0 || fwrite( &header, sizeof( header ), 1, file ) != 1 ) {
+        Fail( "write error" );
+    }
+
+    const bool closed = ( fclose( file ) == 0 );
+    file = nullptr;
+
+    if ( !closed ) {
+        Fail( "write error" );
+    }
+}
+
+void HexMapFileOutput::CheckOpen() const {
+    if ( file == nullptr ) {
+        throw std::runtime_error( "HexMapFile " + path + ": file is already closed." );
+    }
+}
+
+void HexMapFileOutput::Flush() {
+    hasher.Update( buffer.data(), buffered );
+
+    if ( buffered != 0 && fwrite( buffer.data(), 1, buffered, file ) != buffered ) {
+        Fail( "write error" );
+    }
+
+    buffered = 0;
+}
+
+void HexMapFileOutput::Fail( const char* what ) {
+    if ( file != nullptr ) {
+        fclose( file );
+        file = nullptr;
+    }
+
+    throw std::runtime_error( "HexMapFile " + path + ": " + what + "." );
+}
@@ -0,0 +1,222 @@
+/*
+ * HexProfile.cpp
+ *
+ * Счётчики вызовов, выделений памяти и времени функций библиотеки
+ */
+
+#include "HexProfile.h"
+
+#include <sstream>
+
+#if HEX_PROFILE
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#endif
+
+// ================================================================
+// Названия точек замера
+// ================================================================
+static const char* const HEX_PROFILE_POINT_NAMES[ HEX_PROFILE_POINT_COUNT ] = {
+    "Hex::HexNeighbors",
+    "Hex::HexDiagonals",
+    "Hex::HexToPixel",
+    "PixelToHex",
+    "Hex::HexCorners",
+    "FractionalHex::Round",
+    "HexLine",
+    "Offset_to_Cube",
+    "Cube_to_Offset",
+    "PixelToHexBatch",
+    "HexToPixelBatch",
+    "HexCornersBatch",
+    "OffsetToCubeBatch",
+    "CubeToOffsetBatch"
+};
+
+const char* HexProfilePointName( HexProfilePoint_t point ) {
+    return ( point >= 0 && point < HEX_PROFILE_POINT_COUNT ? HEX_PROFILE_POINT_NAMES[ point ] : "unknown" );
+}
+
+bool HexProfileEnabled() {
+    return HEX_PROFILE != 0;
+}
+
+#if HEX_PROFILE
+
+// ================================================================
+// Счётчики потока
+// ================================================================
+// Записываются только своим потоком (чтение и запись без
+// блокировки шины), читаются запросами из любого потока
+// ================================================================
+struct HexProfileCounters {
+    std::atomic<uint64_t> calls[ HEX_PROFILE_POINT_COUNT ] = {};
+    std::atomic<uint64_t> allocations[ HEX_PROFILE_POINT_COUNT ] = {};
+    std::atomic<uint64_t> nanoseconds[ HEX_PROFILE_POINT_COUNT ] = {};
+};
+
+static inline void HexProfileAdd( std::atomic<uint64_t>& counter, uint64_t value ) {
+    counter.store( counter.load( std::memory_order_relaxed ) + value, std::memory_order_relaxed );
+}
+
+// ================================================================
+// Список счётчиков потоков (блокировка - только при создании и
+// завершении потока и при запросах)
+// ================================================================
+struct HexProfileRegistry {
+    std::mutex mutex;
+    std::vector<const HexProfileCounters*> threads;
+
+    // Сумма счётчиков завершившихся потоков и значения на момент HexProfileReset()
+    HexProfileStats retired[ HEX_PROFILE_POINT_COUNT ];
+    HexProfileStats baseline[ HEX_PROFILE_POINT_COUNT ];
+
+    // Сумма счётчиков всех потоков (под блокировкой)
+    HexProfileStats Total( HexProfilePoint_t point ) const {
+        HexProfileStats total = retired[ point ];
+
+        for ( const HexProfileCounters* counters : threads ) {
+            total.calls += counters->calls[ point ].load( std::memory_order_relaxed );
+            total.allocations += counters->allocations[ point ].load( std::memory_order_relaxed );
+            total.nanoseconds += counters->nanoseconds[ point ].load( std::memory_order_relaxed );
+        }
+
+        return total;
+    }
+};
+
+// Не разрушается: потоки могут завершаться после выхода из main()
+static HexProfileRegistry& Registry() {
+    static HexProfileRegistry* registry = new HexProfileRegistry();
+    return *registry;
+}
+
+// ================================================================
+// Счётчики текущего потока (регистрируются при первом замере)
+// ================================================================
+struct HexProfileThread {
+    HexProfileThread() {
+        HexProfileRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+        registry.threads.push_back( &counters );
+    }
+
+    ~HexProfileThread() {
+        HexProfileRegistry& registry = Registry();
+        std::lock_guard<std::mutex> lock( registry.mutex );
+
+        for ( int point = 0; point != HEX_PROFILE_POINT_COUNT; ++point ) {
+            registry.retired[ point ].calls += counters.calls[ point ].load( std::memory_order_relaxed );
+            registry.retired[ point ].allocations += counters.allocations[ point ].load( std::memory_order_relaxed );
+            registry.retired[ point ].nanoseconds += counters.nanoseconds[ point ].load( std::memory_order_relaxed );
+        }
+
+        for ( size_t i = 0; i != registry.threads.size(); ++i ) {
+            if ( registry.threads[ i ] == &counters ) {
+                registry.threads[ i ] = registry.threads.back();
+                registry.threads.pop_back();
+                break;
+            }
+        }
+    }
+
+    HexProfileCounters counters;
+};
+
+static HexProfileCounters& ThreadCounters() {
+    thread_local HexProfileThread thread;
+    return thread.counters;
+}
+
+// ================================================================
+// Количество выделений памяти в текущем потоке
+// ================================================================
+// Тривиальная переменная потока: HexProfileAllocation() вызывается
+// из operator new и не должна выделять память
+// ================================================================
+static thread_local uint64_t hex_profile_allocations = 0;
+
+static inline int64_t HexProfileNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void HexProfileAllocation() {
+    ++hex_profile_allocations;
+}
+
+// Количество выделений памяти в начале замера: счётчики потока
+// регистрируются до чтения, иначе выделения памяти при регистрации
+// (список потоков) учитывались бы в первом замере потока
+static inline uint64_t HexProfileScopeAllocations() {
+    ThreadCounters();
+    return hex_profile_allocations;
+}
+
+HexProfileScope::HexProfileScope( HexProfilePoint_t point_ ) :
+    point( point_ ), allocations( HexProfileScopeAllocations() ), start( HexProfileNow() ) {}
+
+HexProfileScope::~HexProfileScope() {
+    const int64_t finish = HexProfileNow();
+    HexProfileCounters& counters = ThreadCounters();
+    HexProfileAdd( counters.calls[ point ], 1 );
+    HexProfileAdd( counters.allocations[ point ], hex_profile_allocations - allocations );
+    HexProfileAdd( counters.nanoseconds[ point ], static_cast<uint64_t>( finish - start ) );
+}
+
+HexProfileStats HexProfileGet( HexProfilePoint_t point ) {
+    if ( point < 0 || point >= HEX_PROFILE_POINT_COUNT ) {
+        return HexProfileStats();
+    }
+
+    HexProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+    HexProfileStats stats = registry.Total( point );
+    stats.calls -= registry.baseline[ point ].calls;
+    stats.allocations -= registry.baseline[ point ].allocations;
+    stats.nanoseconds -= registry.baseline[ point ].nanoseconds;
+    return stats;
+}
+
+void HexProfileReset() {
+    HexProfileRegistry& registry = Registry();
+    std::lock_guard<std::mutex> lock( registry.mutex );
+
+    for ( int point = 0; point != HEX_PROFILE_POINT_COUNT; ++point ) {
+        registry.baseline[ point ] = registry.Total( static_cast<HexProfilePoint_t>( point ) );
+    }
+}
+
+#else
+
+void HexProfileAllocation() {}
+
+HexProfileStats HexProfileGet( HexProfilePoint_t ) {
+    return HexProfileStats();
+}
+
+void HexProfileReset() {}
+
+#endif // HEX_PROFILE
+
+// ================================================================
+// Результаты в формате JSON
+// ================================================================
+void HexProfileDump( std::ostream& os ) {
+    os << "{\"enabled\": " << ( HexProfileEnabled() ? "true" : "false" ) << ", \"points\": [";
+
+    for ( int point = 0; point != HEX_PROFILE_POINT_COUNT; ++point ) {
+        const HexProfileStats stats = HexProfileGet( static_cast<HexProfilePoint_t>( point ) );
+        os << ( point != 0 ? ", " : "" ) << "{\"name\": \"" << HEX_PROFILE_POINT_NAMES[ point ] << "\", \"calls\": " << stats.calls
+           << ", \"allocations\": " << stats.allocations << ", \"nanoseconds\": " << stats.nanoseconds << "}";
+    }
+
+    os << "]}";
+}
+
+string HexProfileJSON() {
+    std::ostringstream os;
+    HexProfileDump( os );
+    return os.str();
+}
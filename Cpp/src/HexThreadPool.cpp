@@ -0,0 +1,167 @@
+/*
+ * HexThreadPool.cpp
+ *
+ * Пул потоков с перераспределением работы (work stealing)
+ */
+
+#include "HexThreadPool.h"
+
+#include <algorithm>
+
+HexThreadPool::HexThreadPool( unsigned thread_count_ ) :
+    thread_count( thread_count_ != 0 ? thread_count_ : std::max( std::thread::hardware_concurrency(), 1U ) ),
+    ranges( new Range[ thread_count ] ) {
+    for ( unsigned thread = 1; thread < thread_count; ++thread ) {
+        threads.emplace_back( &HexThreadPool::WorkerMain, this, thread );
+    }
+}
+
+HexThreadPool::~HexThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stop = true;
+    }
+
+    start_condition.notify_all();
+
+    for ( std::thread& thread : threads ) {
+        thread.join();
+    }
+}
+
+// ================================================================
+// Выполнение задания всеми потоками
+// ================================================================
+void HexThreadPool::Run( size_t count, size_t grain_, Call call_, void* context_ ) {
+    if ( count == 0 ) {
+        return;
+    }
+
+    // Одно задание в каждый момент времени
+    std::lock_guard<std::mutex> run_lock( run_mutex );
+
+    if ( thread_count == 1 ) {
+        for ( size_t index = 0; index != count; ++index ) {
+            call_( context_, index, 0 );
+        }
+
+        return;
+    }
+
+    for ( unsigned thread = 0; thread != thread_count; ++thread ) {
+        std::lock_guard<std::mutex> lock( ranges[ thread ].mutex );
+        ranges[ thread ].begin = count * thread / thread_count;
+        ranges[ thread ].end = count * ( thread + 1 ) / thread_count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        call = call_;
+        context = context_;
+        grain = std::max<size_t>( grain_, 1 );
+        active = thread_count - 1;
+        ++generation;
+    }
+
+    start_condition.notify_all();
+    Work( 0 );
+
+    std::unique_lock<std::mutex> lock( mutex );
+    done_condition.wait( lock, [this] { return active == 0; } );
+}
+
+// ================================================================
+// Цикл фонового потока
+// ================================================================
+void HexThreadPool::WorkerMain( unsigned thread ) {
+    uint64_t done_generation = 0;
+
+    for ( ;; ) {
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            start_condition.wait( lock, [&] { return stop || generation != done_generation; } );
+
+            if ( stop ) {
+                return;
+            }
+
+            done_generation = generation;
+        }
+
+        Work( thread );
+
+        std::lock_guard<std::mutex> lock( mutex );
+
+        if ( --active == 0 ) {
+            done_condition.notify_one();
+        }
+    }
+}
+
+// ================================================================
+// Обработка своего диапазона, затем перехват чужой работы
+// ================================================================
+void HexThreadPool::Work( unsigned thread ) {
+    size_t begin;
+    size_t end;
+
+    for ( ;; ) {
+        if ( !Take( thread, begin, end ) ) {
+            // Перехваченную работу могут перехватить снова, поэтому повторяем Take
+            if ( !Steal( thread ) ) {
+                return;
+            }
+
+            continue;
+        }
+
+        for ( size_t index = begin; index != end; ++index ) {
+            call( context, index, thread );
+        }
+    }
+}
+
+// Порция индексов из начала своего диапазона
+bool HexThreadPool::Take( unsigned thread, size_t& begin, size_t& end ) {
+    Range& range = ranges[ thread ];
+    std::lock_guard<std::mutex> lock( range.mutex );
+
+    if ( range.begin == range.end ) {
+        return false;
+    }
+
+    begin = range.begin;
+    end = std::min( range.begin + grain, range.end );
+    range.begin = end;
+    return true;
+}
+
+// Перехват второй половины оставшейся работы другого потока
+bool HexThreadPool::Steal( unsigned thread ) {
+    for ( unsigned i = 1; i != thread_count; ++i ) {
+        Range& victim = ranges[ ( thread + i ) % thread_count ];
+        size_t begin;
+        size_t end;
+
+        {
+            std::lock_guard<std::mutex> lock( victim.mutex );
+
+            if ( victim.begin == victim.end ) {
+                continue;
+            }
+
+            // Остался один индекс - забираем его целиком
+            begin = victim.begin + ( victim.end - victim.begin ) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        Range& range = ranges[ thread ];
+        std::lock_guard<std::mutex> lock( range.mutex );
+        range.begin = begin;
+        range.end = end;
+        return true;
+    }
+
+    return false;
+}
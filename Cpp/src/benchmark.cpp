@@ -0,0 +1,1582 @@
+/*
+ * benchmark.cpp
+ *
+ * Микро-бенчмарки HexGrid
+ */
+
+#include "bench_runner.h"
+#include "HexGrid.h"
+#include "HexBatch.h"
+#include "HexBinner.h"
+#include "HexChunkMap.h"
+#include "HexFlowField.h"
+#include "HexHierarchicalPathfinder.h"
+#include "HexHierarchy.h"
+#include "HexKey.h"
+#include "HexLineWalker.h"
+#include "HexMap.h"
+#include "HexMapFile.h"
+#include "HexMorton.h"
+#include "HexPathBatch.h"
+#include "HexPathfinder.h"
+#include "HexProfile.h"
+#include "HexRange.h"
+#include "HexSpatialIndex.h"
+#include "HexStencil.h"
+#include "HexThreadPool.h"
+#include "HexVisibility.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined( __unix__ )
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ================================================================
+// Подсчёт выделений памяти ( allocs/op в результатах )
+// ================================================================
+// Остальные формы operator new / delete (массивы, nothrow) в
+// стандартной библиотеке выражены через эти; выделения с
+// повышенным выравниванием не учитываются. Выделения передаются
+// и в счётчики HexProfile (при сборке с HEX_PROFILE)
+// ================================================================
+// Замены не встраиваются: иначе GCC сопоставляет malloc / free
+// в вызывающем коде с new / delete ( -Wmismatched-new-delete )
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void* operator new( std::size_t size ) {
+    BenchAllocations().fetch_add( 1, std::memory_order_relaxed );
+    HexProfileAllocation();
+
+    if ( void* data = std::malloc( size != 0 ? size : 1 ) ) {
+        return data;
+    }
+
+    throw std::bad_alloc();
+}
+
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void operator delete( void* data ) noexcept {
+    std::free( data );
+}
+
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void operator delete( void* data, std::size_t ) noexcept {
+    std::free( data );
+}
+
+// ================================================================
+// Количество операций за один вызов бенчмарка
+// ================================================================
+const int BENCH_OPS = 4096;
+
+// ================================================================
+// Базовые операции над гексами
+// ================================================================
+void Bench_HexValue( BenchRunner& runner ) {
+    runner.RunBench( [] {
+        Hex sum( 0, 0 );
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = sum + Hex( i & 7, -( i & 3 ) );
+            DoNotOptimize( next );
+        }
+    }, "Hex operator+", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const Hex hex( 3, -7 );
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = hex.HexNeighbor( i );
+            DoNotOptimize( next );
+        }
+    }, "Hex::HexNeighbor", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const Hex hex( 3, -7 );
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const unsigned distance = HexDistance( hex, Hex( i & 63, -( i >> 6 ) ) );
+            DoNotOptimize( distance );
+        }
+    }, "HexDistance", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const Hex hex( 3, -7 );
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = hex.HexRotateLeft();
+            DoNotOptimize( next );
+        }
+    }, "Hex::HexRotateLeft", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const Hex hex( 3, -7 );
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const vector<Hex> next = hex.HexNeighbors();
+            DoNotOptimize( next );
+        }
+    }, "Hex::HexNeighbors", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const Hex hex( 3, -7 );
+        Hex next[ HEX_DIRECTION_COUNT ];
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            hex.HexNeighbors( next );
+            DoNotOptimize( next );
+        }
+    }, "Hex::HexNeighbors (out)", BENCH_OPS );
+
+    runner.RunBench( [] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = FractionalHex( 0.37L * i, -0.21L * i ).Round( 0 );
+            DoNotOptimize( next );
+        }
+    }, "FractionalHex::Round", BENCH_OPS );
+
+    runner.RunBench( [] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = FractionalHex( 0.37L * i, -0.21L * i ).Round( HEX_ROUND_DEFAULT );
+            DoNotOptimize( next );
+        }
+    }, "FractionalHex::Round (HEX_ROUND_DEFAULT)", BENCH_OPS );
+
+    runner.RunBench( [] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Hex next = FractionalHex( 0.37L * i, -0.21L * i ).Round( HEX_ROUND_RANDOM );
+            DoNotOptimize( next );
+        }
+    }, "FractionalHex::Round (HEX_ROUND_RANDOM)", BENCH_OPS );
+
+    runner.RunBench( [] {
+        const vector<Hex> line = HexLine( Hex( 0, 0 ), Hex( 10, -25 ), false, 0 );
+        DoNotOptimize( line );
+    }, "HexLine (distance 25)", 1 );
+
+    vector<Hex> line;
+    runner.RunBench( [&line] {
+        HexLine( Hex( 0, 0 ), Hex( 10, -25 ), false, 0, line, 0 );
+        DoNotOptimize( line.data() );
+    }, "HexLine (distance 25, buffer)", 1 );
+}
+
+// ================================================================
+// Преобразования координат: HexLayout против StaticHexLayout
+// ================================================================
+void Bench_HexLayout( BenchRunner& runner ) {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    const HexLayoutPointyOdd static_layout( Point( 10, 15 ), Point( 35, 71 ) );
+
+    runner.RunBench( [&layout] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Point pixel = Hex( i & 63, -( i >> 6 ) ).HexToPixel( layout );
+            DoNotOptimize( pixel );
+        }
+    }, "HexToPixel (HexLayout)", BENCH_OPS );
+
+    runner.RunBench( [&static_layout] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const Point pixel = static_layout.HexToPixel( Hex( i & 63, -( i >> 6 ) ) );
+            DoNotOptimize( pixel );
+        }
+    }, "HexToPixel (StaticHexLayout)", BENCH_OPS );
+
+    runner.RunBench( [&layout] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const FractionalHex hex = PixelToHex( layout, Point( 0.37L * i, 0.21L * i ) );
+            DoNotOptimize( hex );
+        }
+    }, "PixelToHex (HexLayout)", BENCH_OPS );
+
+    runner.RunBench( [&static_layout] {
+        for ( int i = 0; i < BENCH_OPS; ++i ) {
+            const FractionalHex hex = PixelToHex( static_layout, Point( 0.37L * i, 0.21L * i ) );
+            DoNotOptimize( hex );
+        }
+    }, "PixelToHex (StaticHexLayout)", BENCH_OPS );
+}
+
+// ================================================================
+// Пакетное PixelToHex + Round против скалярного цикла
+// ================================================================
+void Bench_PixelToHexBatch( BenchRunner& runner ) {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    const size_t count = 1 << 16;
+    vector<double> x( count ), y( count );
+    vector<int> q( count ), r( count );
+
+    for ( size_t i = 0; i != count; ++i ) {
+        x[ i ] = 0.37L * ( i % 1024 ) - 100.0L;
+        y[ i ] = 0.53L * ( i / 1024 ) - 10.0L;
+    }
+
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            const Hex hex = PixelToHex( layout, Point( x[ i ], y[ i ] ) ).Round( HEX_ROUND_Q );
+            q[ i ] = hex.Q();
+            r[ i ] = hex.R();
+        }
+        DoNotOptimize( q.data() );
+    }, "PixelToHex(...).Round(...) loop", count );
+
+    for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+        if ( HexBatchKernel( kernel ) != kernel ) {
+            continue;
+        }
+
+        runner.RunBench( [&] {
+            PixelToHexBatch( layout, x.data(), y.data(), count, q.data(), r.data(), HEX_ROUND_Q, kernel );
+            DoNotOptimize( q.data() );
+        }, string( "PixelToHexBatch (" ) + HexBatchKernelName( kernel ) + ")", count );
+    }
+}
+
+// ================================================================
+// Пакетные HexToPixel / HexCorners против методов Hex
+// ================================================================
+void Bench_HexCornersBatch( BenchRunner& runner ) {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    const size_t count = 1 << 14;
+    vector<int> q( count ), r( count );
+    vector<double> x( count ), y( count ), vertices( count * HEX_CORNER_VERTEX_STRIDE );
+
+    for ( size_t i = 0; i != count; ++i ) {
+        q[ i ] = i % 128;
+        r[ i ] = i / 128 - q[ i ] / 2;
+    }
+
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            const Point center = Hex( q[ i ], r[ i ] ).HexToPixel( layout );
+            x[ i ] = center.x;
+            y[ i ] = center.y;
+        }
+        DoNotOptimize( x.data() );
+    }, "Hex::HexToPixel loop", count );
+
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            const vector<Point> corners = Hex( q[ i ], r[ i ] ).HexCorners( layout );
+
+            for ( size_t j = 0; j != corners.size(); ++j ) {
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j ] = corners[ j ].x;
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j + 1 ] = corners[ j ].y;
+            }
+        }
+        DoNotOptimize( vertices.data() );
+    }, "Hex::HexCorners loop", count );
+
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            Point corners[ HEX_CORNER_COUNT ];
+            Hex( q[ i ], r[ i ] ).HexCorners( layout, corners );
+
+            for ( size_t j = 0; j != HEX_CORNER_COUNT; ++j ) {
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j ] = corners[ j ].x;
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j + 1 ] = corners[ j ].y;
+            }
+        }
+        DoNotOptimize( vertices.data() );
+    }, "Hex::HexCorners (out) loop", count );
+
+    // Углы через cos / sin на каждый угол (до кэширования смещений в HexLayout)
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            const Point center = Hex( q[ i ], r[ i ] ).HexToPixel( layout );
+
+            for ( size_t j = 0; j != HEX_CORNER_COUNT; ++j ) {
+                const double angle = 3.141592653589793 * ( layout.start_angle + j ) / 3.0;
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j ] = center.x + layout.size.x * cos( angle );
+                vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j + 1 ] = center.y + layout.size.y * sin( angle );
+            }
+        }
+        DoNotOptimize( vertices.data() );
+    }, "HexCorners via cos/sin loop", count );
+
+    runner.RunBench( [&] {
+        for ( size_t i = 0; i != count; ++i ) {
+            const Point corner = Hex( q[ i ], r[ i ] ).HexCorner( layout, static_cast<int>( i ) );
+            vertices[ 2 * i ] = corner.x;
+            vertices[ 2 * i + 1 ] = corner.y;
+        }
+        DoNotOptimize( vertices.data() );
+    }, "Hex::HexCorner loop", count );
+
+    for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+        if ( HexBatchKernel( kernel ) != kernel ) {
+            continue;
+        }
+
+        runner.RunBench( [&] {
+            HexToPixelBatch( layout, q.data(), r.data(), count, x.data(), y.data(), kernel );
+            DoNotOptimize( x.data() );
+        }, string( "HexToPixelBatch (" ) + HexBatchKernelName( kernel ) + ")", count );
+
+        runner.RunBench( [&] {
+            HexCornersBatch( layout, q.data(), r.data(), count, vertices.data(), kernel );
+            DoNotOptimize( vertices.data() );
+        }, string( "HexCornersBatch (" ) + HexBatchKernelName( kernel ) + ")", count );
+    }
+}
+
+// ================================================================
+// Пакетные OffsetToCube / CubeToOffset против Offset_to_Cube / Cube_to_Offset
+// ================================================================
+void Bench_OffsetCubeBatch( BenchRunner& runner ) {
+    const size_t count = 1 << 16;
+    vector<int> col( count ), row( count ), q( count ), r( count );
+
+    for ( size_t i = 0; i != count; ++i ) {
+        col[ i ] = static_cast<int>( i % 256 ) - 128;
+        row[ i ] = static_cast<int>( i / 256 ) - 128;
+    }
+
+    for ( HexOrientation_t orientation : { HEX_ORIENTATION_FLAT, HEX_ORIENTATION_POINTY } ) {
+        const HexLayout layout( orientation, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+        const string suffix = ( orientation == HEX_ORIENTATION_FLAT ? ", flat" : ", pointy" );
+
+        runner.RunBench( [&] {
+            for ( size_t i = 0; i != count; ++i ) {
+                const Hex hex = Offset_to_Cube( layout, OffsetHex( col[ i ], row[ i ] ) );
+                q[ i ] = hex.Q();
+                r[ i ] = hex.R();
+            }
+            DoNotOptimize( q.data() );
+        }, "Offset_to_Cube loop" + suffix, count );
+
+        runner.RunBench( [&] {
+            for ( size_t i = 0; i != count; ++i ) {
+                const OffsetHex offset = Cube_to_Offset( layout, Hex( q[ i ], r[ i ] ) );
+                col[ i ] = offset.col;
+                row[ i ] = offset.row;
+            }
+            DoNotOptimize( col.data() );
+        }, "Cube_to_Offset loop" + suffix, count );
+
+        for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+            if ( HexBatchKernel( kernel ) != kernel ) {
+                continue;
+            }
+
+            runner.RunBench( [&] {
+                OffsetToCubeBatch( layout, col.data(), row.data(), count, q.data(), r.data(), kernel );
+                DoNotOptimize( q.data() );
+            }, string( "OffsetToCubeBatch (" ) + HexBatchKernelName( kernel ) + ")" + suffix, count );
+
+            runner.RunBench( [&] {
+                CubeToOffsetBatch( layout, q.data(), r.data(), count, col.data(), row.data(), kernel );
+                DoNotOptimize( col.data() );
+            }, string( "CubeToOffsetBatch (" ) + HexBatchKernelName( kernel ) + ")" + suffix, count );
+        }
+    }
+}
+
+// ================================================================
+// Хеш гекса для сравнения с std::unordered_map
+// ================================================================
+struct BenchHexHash {
+    size_t operator ()( const Hex& hex ) const {
+        return std::hash<long long>()( ( static_cast<long long>( hex.Q() ) << 32 ) ^ static_cast<unsigned>( hex.R() ) );
+    }
+};
+
+// ================================================================
+// HexMap против std::unordered_map<Hex, T>
+// ================================================================
+void Bench_HexMap( BenchRunner& runner ) {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    const int side = 1024;
+    HexMap<int> map( HexMapShape::Rectangle( layout, side, side ) );
+    std::unordered_map<Hex, int, BenchHexHash> hash_map;
+    vector<Hex> probes;
+
+    for ( auto cell : map ) {
+        cell.value = cell.hex.Q() ^ cell.hex.R();
+        hash_map[ cell.hex ] = cell.value;
+    }
+
+    for ( int i = 0; i < BENCH_OPS; ++i ) {
+        probes.push_back( Offset_to_Cube( layout, OffsetHex( ( i * 7919 ) % side, ( i * 104729 ) % side ) ) );
+    }
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& hex : probes ) {
+            sum += map[ hex ];
+        }
+        DoNotOptimize( sum );
+    }, "HexMap lookup", BENCH_OPS );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& hex : probes ) {
+            sum += hash_map.find( hex )->second;
+        }
+        DoNotOptimize( sum );
+    }, "unordered_map lookup", BENCH_OPS );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( auto cell : map ) {
+            sum += cell.value;
+        }
+        DoNotOptimize( sum );
+    }, "HexMap iteration", map.Size() );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const auto& cell : hash_map ) {
+            sum += cell.second;
+        }
+        DoNotOptimize( sum );
+    }, "unordered_map iteration", hash_map.size() );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& hex : probes ) {
+            map.ForEachNeighbor( hex, [&sum]( const Hex&, int value ) { sum += value; } );
+        }
+        DoNotOptimize( sum );
+    }, "HexMap neighbor sum", BENCH_OPS );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& hex : probes ) {
+            for ( int direction = 0; direction != 6; ++direction ) {
+                const auto it = hash_map.find( hex.HexNeighbor( direction ) );
+                if ( it != hash_map.end() ) {
+                    sum += it->second;
+                }
+            }
+        }
+        DoNotOptimize( sum );
+    }, "unordered_map neighbor sum", BENCH_OPS );
+}
+
+// ================================================================
+// Хранение по строкам и по коду Мортона: соседи и поиск пути
+// ================================================================
+void Bench_HexMorton( BenchRunner& runner ) {
+    vector<Hex> hexes;
+
+    for ( int i = 0; i < BENCH_OPS; ++i ) {
+        hexes.push_back( Hex( ( i * 7919 ) % 100000 - 50000, ( i * 104729 ) % 100000 - 50000 ) );
+    }
+
+    runner.RunBench( [&] {
+        uint64_t sum = 0;
+        for ( const Hex& hex : hexes ) {
+            sum += HexMortonEncode( hex );
+        }
+        DoNotOptimize( sum );
+    }, "HexMortonEncode", BENCH_OPS );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( size_t i = 0; i != hexes.size(); ++i ) {
+            sum += HexMortonDecode( i * 0x9E3779B97F4A7C15ULL ).Q();
+        }
+        DoNotOptimize( sum );
+    }, "HexMortonDecode", BENCH_OPS );
+
+    const HexMapOrder_t orders[] = { HEX_MAP_ORDER_ROWS, HEX_MAP_ORDER_MORTON };
+    const char* order_names[] = { "rows", "Morton" };
+
+    // Карта 2048x2048 (4M ячеек) не помещается в кэш
+    const HexMapShape rows_shape = HexMapShape::Rhombus( Hex( 0, 0 ), 2048, 2048 );
+
+    // Окрестности радиуса 8 вокруг случайных центров (локальные операции)
+    vector<Hex> centers;
+    unsigned seed = 12345;
+
+    for ( int i = 0; i != 1024; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const int q = 8 + static_cast<int>( ( seed >> 8 ) % 2032 );
+        seed = seed * 1103515245U + 12345U;
+        const int r = 8 + static_cast<int>( ( seed >> 8 ) % 2032 );
+        centers.push_back( Hex( q, r ) );
+    }
+
+    for ( size_t o = 0; o != std::size( orders ); ++o ) {
+        HexMap<float> map( rows_shape.WithOrder( orders[ o ] ), 1.0f );
+        const string suffix = string( " (" ) + order_names[ o ] + ")";
+
+        runner.RunBench( [&] {
+            float sum = 0.0f;
+            for ( auto cell : map ) {
+                map.ForEachNeighbor( cell.hex, [&sum]( const Hex&, float value ) { sum += value; } );
+            }
+            DoNotOptimize( sum );
+        }, "HexMap 2048x2048 neighbor sum, full sweep" + suffix, map.Size() );
+
+        runner.RunBench( [&] {
+            float sum = 0.0f;
+            for ( const Hex& center : centers ) {
+                for ( const Hex& hex : HexRange( center, 8 ) ) {
+                    map.ForEachNeighbor( hex, [&sum]( const Hex&, float value ) { sum += value; } );
+                }
+            }
+            DoNotOptimize( sum );
+        }, "HexMap 2048x2048 neighbor sum, radius 8" + suffix, centers.size() * HexRangeSize( 8 ) );
+    }
+
+    // Поиск пути на карте 1024x1024 (25% непроходимых ячеек)
+    const HexMapShape path_shape = HexMapShape::Rhombus( Hex( 0, 0 ), 1024, 1024 );
+    vector<float> values( path_shape.Size() );
+
+    for ( float& value : values ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned cost = ( seed >> 16 ) % 16;
+        value = ( cost < 4 ? HEX_PATH_BLOCKED : 1.0f + cost % 4 );
+    }
+
+    vector<std::pair<Hex, Hex>> queries;
+
+    while ( queries.size() != 8 ) {
+        seed = seed * 1103515245U + 12345U;
+        const size_t start = ( seed >> 4 ) % values.size();
+        seed = seed * 1103515245U + 12345U;
+        const size_t goal = ( seed >> 4 ) % values.size();
+
+        if ( values[ start ] < HEX_PATH_BLOCKED && values[ goal ] < HEX_PATH_BLOCKED ) {
+            queries.emplace_back( path_shape.HexAt( start ), path_shape.HexAt( goal ) );
+        }
+    }
+
+    for ( size_t o = 0; o != std::size( orders ); ++o ) {
+        const string name = string( "HexPathfinder A* 1024x1024 (" ) + order_names[ o ] + ")";
+
+        if ( !runner.Enabled( name ) ) {
+            continue;
+        }
+
+        const HexMapShape shape = path_shape.WithOrder( orders[ o ] );
+        HexMap<float> costs( shape );
+
+        for ( size_t i = 0; i != values.size(); ++i ) {
+            costs[ path_shape.HexAt( i ) ] = values[ i ];
+        }
+
+        HexPathfinder pathfinder( shape );
+        vector<Hex> path;
+
+        runner.RunBench( [&] {
+            for ( const auto& query : queries ) {
+                DoNotOptimize( pathfinder.FindPath( query.first, query.second, costs, path ).cost );
+            }
+        }, name, queries.size() );
+    }
+}
+
+// ================================================================
+// Сброс файла из кеша страниц (холодная загрузка)
+// ================================================================
+static bool BenchDropCache( const string& path ) {
+#if defined( __unix__ ) && defined( POSIX_FADV_DONTNEED )
+    const int file = open( path.c_str(), O_RDONLY );
+
+    if ( file < 0 ) {
+        return false;
+    }
+
+    const bool result = ( fsync( file ) == 0 && posix_fadvise( file, 0, 0, POSIX_FADV_DONTNEED ) == 0 );
+    close( file );
+    return result;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// ================================================================
+// Загрузка карты: текстовый формат против HexMapFileView
+// ================================================================
+void Bench_HexMapFile( BenchRunner& runner ) {
+    if ( !runner.Enabled( "HexMapFile" ) ) {
+        return;
+    }
+
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    const int side = 1024;
+    const HexMapShape shape = HexMapShape::Rectangle( layout, side, side );
+    const string text_path = "Bench_HexMapFile.txt";
+    const string binary_path = "Bench_HexMapFile.hexmap";
+    HexMap<float> map( shape );
+    unsigned seed = 99;
+
+    for ( size_t i = 0; i != map.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        map.Cell( i ) = static_cast<float>( ( seed >> 8 ) % 1000 ) / 8.0f;
+    }
+
+    // Текстовый формат: размеры, затем значения ячеек по строкам
+    {
+        std::ofstream output( text_path );
+        output << side << ' ' << side << '\n';
+
+        for ( size_t i = 0; i != map.Size(); ++i ) {
+            output << map.Cell( i ) << ( ( i + 1 ) % side == 0 ? '\n' : ' ' );
+        }
+    }
+
+    const auto load_text = [&] {
+        std::ifstream input( text_path );
+        int width = 0;
+        int height = 0;
+        input >> width >> height;
+        HexMap<float> loaded( HexMapShape::Rectangle( layout, width, height ) );
+
+        for ( size_t i = 0; i != loaded.Size(); ++i ) {
+            input >> loaded.Cell( i );
+        }
+
+        float sum = 0.0f;
+
+        for ( size_t i = 0; i != loaded.Size(); ++i ) {
+            sum += loaded.Cell( i );
+        }
+
+        DoNotOptimize( sum );
+    };
+
+    const auto load_binary = [&] {
+        const HexMapFileView<float> view( binary_path );
+        float sum = 0.0f;
+
+        for ( size_t i = 0; i != view.Size(); ++i ) {
+            sum += view.Cell( i );
+        }
+
+        DoNotOptimize( sum );
+    };
+
+    runner.RunBench( [&] { HexMapFileSave( binary_path, layout, map ); }, "HexMapFileSave (1024x1024 float)", map.Size() );
+
+    runner.RunBench( [&] {
+        const HexMapFileView<float> view( binary_path );
+        DoNotOptimize( view.Data() );
+    }, "HexMapFileView open (1024x1024 float)", map.Size() );
+
+    runner.RunBench( load_text, "HexMapFile text load+sum (warm)", map.Size() );
+    runner.RunBench( load_binary, "HexMapFileView open+sum (warm)", map.Size() );
+
+    if ( BenchDropCache( text_path ) && BenchDropCache( binary_path ) ) {
+        runner.RunBench( [&] { BenchDropCache( text_path ); load_text(); }, "HexMapFile text load+sum (cold)", map.Size() );
+        runner.RunBench( [&] { BenchDropCache( binary_path ); load_binary(); }, "HexMapFileView open+sum (cold)", map.Size() );
+    }
+
+    runner.RunBench( [&] { DoNotOptimize( HexMapFileValidate( binary_path ) ); }, "HexMapFileValidate (1024x1024 float)", map.Size() );
+
+    std::ifstream text( text_path, std::ios::binary | std::ios::ate );
+    std::ifstream binary( binary_path, std::ios::binary | std::ios::ate );
+    runner.Report( "HexMapFile size", { { static_cast<double>( text.tellg() ), "text bytes" },
+                                        { static_cast<double>( binary.tellg() ), "binary bytes" } } );
+    text.close();
+    binary.close();
+
+    std::remove( text_path.c_str() );
+    std::remove( binary_path.c_str() );
+}
+
+// ================================================================
+// HexChunkMap против std::unordered_map<Hex, T> (разреженный мир)
+// ================================================================
+void Bench_HexChunkMap( BenchRunner& runner ) {
+    // Случайное блуждание: несколько областей активности в неограниченном мире
+    vector<Hex> walk;
+    Hex hex( 0, 0 );
+    unsigned seed = 12345;
+
+    for ( int i = 0; i < ( 1 << 18 ); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        hex = ( ( i & 0xffff ) == 0 ? Hex( ( seed >> 8 ) % 100000, -static_cast<int>( ( seed >> 4 ) % 100000 ) )
+                                    : hex.HexNeighbor( ( seed >> 16 ) % 6 ) );
+        walk.push_back( hex );
+    }
+
+    HexChunkMap<int> chunk_map;
+    std::unordered_map<Hex, int, BenchHexHash> hash_map;
+
+    runner.RunBench( [&] {
+        HexChunkMap<int> map;
+        for ( const Hex& cell : walk ) {
+            ++map[ cell ];
+        }
+        DoNotOptimize( map.ChunkCount() );
+    }, "HexChunkMap insert", walk.size() );
+
+    runner.RunBench( [&] {
+        std::unordered_map<Hex, int, BenchHexHash> map;
+        for ( const Hex& cell : walk ) {
+            ++map[ cell ];
+        }
+        DoNotOptimize( map.size() );
+    }, "unordered_map insert (sparse)", walk.size() );
+
+    for ( const Hex& cell : walk ) {
+        ++chunk_map[ cell ];
+        ++hash_map[ cell ];
+    }
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& cell : walk ) {
+            chunk_map.ForEachNeighbor( cell, [&sum]( const Hex&, int value ) { sum += value; } );
+        }
+        DoNotOptimize( sum );
+    }, "HexChunkMap neighbor sum", walk.size() );
+
+    runner.RunBench( [&] {
+        int sum = 0;
+        for ( const Hex& cell : walk ) {
+            for ( int direction = 0; direction != 6; ++direction ) {
+                const auto it = hash_map.find( cell.HexNeighbor( direction ) );
+                if ( it != hash_map.end() ) {
+                    sum += it->second;
+                }
+            }
+        }
+        DoNotOptimize( sum );
+    }, "unordered_map neighbor sum (sparse)", walk.size() );
+
+    if ( runner.Enabled( "HexChunkMap memory" ) ) {
+        runner.Report( "HexChunkMap memory", { { static_cast<double>( hash_map.size() ), "cells" },
+                                               { static_cast<double>( chunk_map.ChunkCount() ), "chunks" },
+                                               { static_cast<double>( chunk_map.MemoryUsage() ), "bytes" } } );
+    }
+}
+
+// ================================================================
+// Ключи гексов в unordered_set / set: Hex против упакованного ключа
+// ================================================================
+void Bench_HexKey( BenchRunner& runner ) {
+    // Плотная область и промахи вне её
+    vector<Hex> hexes;
+    vector<Hex> probes;
+    unsigned seed = 777;
+
+    for ( const Hex& hex : HexRange( Hex( 0, 0 ), 300 ) ) {
+        hexes.push_back( hex );
+    }
+
+    for ( size_t i = 0; i != hexes.size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        probes.push_back( Hex( static_cast<int>( ( seed >> 8 ) % 700 ) - 350, static_cast<int>( ( seed >> 16 ) % 700 ) - 350 ) );
+    }
+
+    vector<uint64_t> keys( hexes.size() );
+    vector<uint64_t> probe_keys( probes.size() );
+    std::transform( hexes.begin(), hexes.end(), keys.begin(), HexPack );
+    std::transform( probes.begin(), probes.end(), probe_keys.begin(), HexPack );
+
+    // Вставка элементов items и поиск queries
+    const auto run = [&]( auto set, const auto& items, const auto& queries, const char* name ) {
+        runner.RunBench( [&] {
+            decltype( set ) filled;
+            filled.reserve( items.size() );
+            for ( const auto& item : items ) {
+                filled.insert( item );
+            }
+            DoNotOptimize( filled.size() );
+        }, string( name ) + " insert", items.size() );
+
+        for ( const auto& item : items ) {
+            set.insert( item );
+        }
+
+        runner.RunBench( [&] {
+            size_t found = 0;
+            for ( const auto& query : queries ) {
+                found += set.count( query );
+            }
+            DoNotOptimize( found );
+        }, string( name ) + " lookup", queries.size() );
+    };
+
+    run( std::unordered_set<Hex, BenchHexHash>(), hexes, probes, "unordered_set<Hex> (BenchHexHash)" );
+    run( std::unordered_set<Hex>(), hexes, probes, "unordered_set<Hex> (std::hash)" );
+    run( std::unordered_set<Hex, HexHash>(), hexes, probes, "unordered_set<Hex> (HexHash)" );
+    run( std::unordered_set<uint64_t>(), keys, probe_keys, "unordered_set<HexPack> (std::hash)" );
+    run( std::unordered_set<uint64_t, HexKeyHash>(), keys, probe_keys, "unordered_set<HexPack> (HexKeyHash)" );
+
+    std::set<Hex> tree_set( hexes.begin(), hexes.end() );
+    std::set<uint64_t> key_tree_set( keys.begin(), keys.end() );
+
+    runner.RunBench( [&] {
+        size_t found = 0;
+        for ( const Hex& probe : probes ) {
+            found += tree_set.count( probe );
+        }
+        DoNotOptimize( found );
+    }, "set<Hex> lookup", probes.size() );
+
+    runner.RunBench( [&] {
+        size_t found = 0;
+        for ( uint64_t key : probe_keys ) {
+            found += key_tree_set.count( key );
+        }
+        DoNotOptimize( found );
+    }, "set<HexPack> lookup", probe_keys.size() );
+}
+
+// ================================================================
+// Диапазон / кольцо / спираль: итераторы против построения вектора
+// ================================================================
+void Bench_HexRange( BenchRunner& runner ) {
+    const Hex center( 3, -7 );
+
+    for ( int radius : { 1, 10, 100, 500 } ) {
+        const string suffix = " (radius " + std::to_string( radius ) + ")";
+        vector<Hex> buffer( HexRangeSize( radius ) );
+
+        runner.RunBench( [&] {
+            vector<Hex> range;
+            for ( int dq = -radius; dq <= radius; ++dq ) {
+                for ( int dr = std::max( -radius, -dq - radius ); dr <= std::min( radius, -dq + radius ); ++dr ) {
+                    range.push_back( center + Hex( dq, dr ) );
+                }
+            }
+            DoNotOptimize( range.data() );
+        }, "HexRange naive vector" + suffix, HexRangeSize( radius ) );
+
+        runner.RunBench( [&] {
+            int sum = 0;
+            for ( const Hex& hex : HexRange( center, radius ) ) {
+                sum += hex.Q();
+            }
+            DoNotOptimize( sum );
+        }, "HexRange iterator" + suffix, HexRangeSize( radius ) );
+
+        runner.RunBench( [&] {
+            DoNotOptimize( HexRange( center, radius ).CopyTo( buffer.data() ) );
+        }, "HexRange CopyTo" + suffix, HexRangeSize( radius ) );
+
+        runner.RunBench( [&] {
+            vector<Hex> ring;
+            Hex hex = center.HexNeighbor( 4 ) + HexDirection( 4 ) * ( radius - 1 );
+            for ( int side = 0; side != 6; ++side ) {
+                for ( int step = 0; step != radius; ++step ) {
+                    ring.push_back( hex );
+                    hex = hex.HexNeighbor( side );
+                }
+            }
+            DoNotOptimize( ring.data() );
+        }, "HexRing naive vector" + suffix, HexRingSize( radius ) );
+
+        runner.RunBench( [&] {
+            int sum = 0;
+            for ( const Hex& hex : HexRing( center, radius ) ) {
+                sum += hex.Q();
+            }
+            DoNotOptimize( sum );
+        }, "HexRing iterator" + suffix, HexRingSize( radius ) );
+
+        runner.RunBench( [&] {
+            vector<Hex> spiral( 1, center );
+            for ( int ring = 1; ring <= radius; ++ring ) {
+                Hex hex = center + HexDirection( 4 ) * ring;
+                for ( int side = 0; side != 6; ++side ) {
+                    for ( int step = 0; step != ring; ++step ) {
+                        spiral.push_back( hex );
+                        hex = hex.HexNeighbor( side );
+                    }
+                }
+            }
+            DoNotOptimize( spiral.data() );
+        }, "HexSpiral naive vector" + suffix, HexRangeSize( radius ) );
+
+        runner.RunBench( [&] {
+            int sum = 0;
+            for ( const Hex& hex : HexSpiral( center, radius ) ) {
+                sum += hex.Q();
+            }
+            DoNotOptimize( sum );
+        }, "HexSpiral iterator" + suffix, HexRangeSize( radius ) );
+    }
+}
+
+// ================================================================
+// Поиск пути на случайных картах с препятствиями
+// ================================================================
+void Bench_HexPathfinder( BenchRunner& runner ) {
+    const HexPathAlgorithm_t algorithms[] = { HEX_PATH_ASTAR, HEX_PATH_DIJKSTRA,
+                                              HEX_PATH_BIDIRECTIONAL_ASTAR, HEX_PATH_BIDIRECTIONAL_DIJKSTRA };
+    const char* algorithm_names[] = { "A*", "Dijkstra", "bidirectional A*", "bidirectional Dijkstra" };
+
+    for ( int size : { 64, 256, 1024 } ) {
+        // 25% непроходимых ячеек, стоимость проходимых 1..4
+        const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), size, size );
+        HexMap<float> costs( shape, 1.0f );
+        unsigned seed = 12345;
+
+        for ( size_t i = 0; i != costs.Size(); ++i ) {
+            seed = seed * 1103515245U + 12345U;
+            const unsigned value = ( seed >> 16 ) % 16;
+            costs.Cell( i ) = ( value < 4 ? HEX_PATH_BLOCKED : 1.0f + value % 4 );
+        }
+
+        // Запросы между случайными проходимыми ячейками
+        vector<std::pair<Hex, Hex>> queries;
+
+        while ( queries.size() != ( size < 1024 ? 64U : 8U ) ) {
+            seed = seed * 1103515245U + 12345U;
+            const size_t start = ( seed >> 4 ) % costs.Size();
+            seed = seed * 1103515245U + 12345U;
+            const size_t goal = ( seed >> 4 ) % costs.Size();
+
+            if ( costs.Cell( start ) < HEX_PATH_BLOCKED && costs.Cell( goal ) < HEX_PATH_BLOCKED ) {
+                queries.emplace_back( shape.HexAt( start ), shape.HexAt( goal ) );
+            }
+        }
+
+        HexPathfinder pathfinder( shape );
+        vector<Hex> path;
+        const string suffix = " (" + std::to_string( size ) + "x" + std::to_string( size ) + ")";
+
+        for ( size_t a = 0; a != std::size( algorithms ); ++a ) {
+            const string name = string( "HexPathfinder " ) + algorithm_names[ a ] + suffix;
+
+            if ( !runner.Enabled( name ) ) {
+                continue;
+            }
+
+            size_t expanded = 0;
+            const auto start = std::chrono::steady_clock::now();
+
+            for ( const auto& query : queries ) {
+                expanded += pathfinder.FindPath( query.first, query.second, costs, path, algorithms[ a ] ).nodes_expanded;
+            }
+
+            const double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            runner.Report( name, { { static_cast<double>( expanded ) / queries.size(), "nodes/query" },
+                                   { queries.size() / elapsed, "queries/s" } } );
+
+            runner.RunBench( [&] {
+                for ( const auto& query : queries ) {
+                    DoNotOptimize( pathfinder.FindPath( query.first, query.second, costs, path, algorithms[ a ] ).cost );
+                }
+            }, name, queries.size() );
+        }
+    }
+}
+
+// ================================================================
+// Пакетный поиск пути: масштабирование от 1 до N потоков
+// ================================================================
+void Bench_HexPathBatch( BenchRunner& runner ) {
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), 256, 256 );
+    HexMap<float> costs( shape, 1.0f );
+    unsigned seed = 12345;
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned value = ( seed >> 16 ) % 16;
+        costs.Cell( i ) = ( value < 4 ? HEX_PATH_BLOCKED : 1.0f + value % 4 );
+    }
+
+    // Пакет коротких и средних запросов (разброс длины для проверки перераспределения работы)
+    vector<HexPathQuery> queries;
+
+    while ( queries.size() != 256 ) {
+        seed = seed * 1103515245U + 12345U;
+        const size_t start = ( seed >> 4 ) % costs.Size();
+        const Hex start_hex = shape.HexAt( start );
+        seed = seed * 1103515245U + 12345U;
+        const int radius = 4 + static_cast<int>( ( seed >> 8 ) % 60 );
+        const Hex goal_hex = start_hex + HexDirection( ( seed >> 4 ) % 6 ) * radius;
+
+        if ( costs.Cell( start ) < HEX_PATH_BLOCKED && costs.Contains( goal_hex ) && costs[ goal_hex ] < HEX_PATH_BLOCKED ) {
+            queries.push_back( { start_hex, goal_hex } );
+        }
+    }
+
+    const unsigned max_threads = std::max( std::thread::hardware_concurrency(), 4U );
+    vector<HexPathResult> results;
+
+    for ( unsigned threads = 1; threads <= max_threads; threads *= 2 ) {
+        const string name = "HexPathBatch A* 256 queries (" + std::to_string( threads ) + " threads)";
+
+        if ( !runner.Enabled( name ) ) {
+            continue;
+        }
+
+        HexThreadPool pool( threads );
+        HexPathBatch batch( shape, pool );
+
+        runner.RunBench( [&] {
+            batch.Solve( queries, costs, results );
+            DoNotOptimize( results.data() );
+        }, name, queries.size() );
+    }
+}
+
+// ================================================================
+// Поле движения на карте 1024x1024 (1M ячеек)
+// ================================================================
+void Bench_HexFlowField( BenchRunner& runner ) {
+    const int size = 1024;
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), size, size );
+    HexMap<float> costs( shape, 1.0f );
+    unsigned seed = 12345;
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned value = ( seed >> 16 ) % 16;
+        costs.Cell( i ) = ( value < 4 ? HEX_PATH_BLOCKED : 1.0f + value % 4 );
+    }
+
+    vector<Hex> goals;
+
+    while ( goals.size() != 16 ) {
+        seed = seed * 1103515245U + 12345U;
+        const size_t index = ( seed >> 4 ) % costs.Size();
+
+        if ( costs.Cell( index ) < HEX_PATH_BLOCKED ) {
+            goals.push_back( shape.HexAt( index ) );
+        }
+    }
+
+    HexFlowField field( shape );
+    const string suffix = " (" + std::to_string( size ) + "x" + std::to_string( size ) + ")";
+    const unsigned max_threads = std::max( std::thread::hardware_concurrency(), 4U );
+
+    runner.RunBench( [&] {
+        field.Compute( { goals.front() }, costs );
+        DoNotOptimize( field.Distances().Data() );
+    }, "HexFlowField Compute 1 goal" + suffix, shape.Size() );
+
+    for ( unsigned threads = 1; threads <= max_threads; threads *= 2 ) {
+        const string name = "HexFlowField Compute 16 goals" + suffix + " (" + std::to_string( threads ) + " threads)";
+
+        if ( runner.Enabled( name ) ) {
+            HexThreadPool pool( threads );
+
+            runner.RunBench( [&] {
+                field.Compute( goals, costs, &pool );
+                DoNotOptimize( field.Distances().Data() );
+            }, name, shape.Size() );
+        }
+    }
+
+    // Изменение 16 случайных ячеек (стоимость переключается туда и обратно)
+    vector<Hex> changed;
+
+    for ( int i = 0; i != 16; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        changed.push_back( shape.HexAt( ( seed >> 4 ) % costs.Size() ) );
+    }
+
+    if ( runner.Enabled( "HexFlowField Update 16 cells" + suffix ) ) {
+        field.Compute( goals, costs );
+    }
+
+    runner.RunBench( [&] {
+        for ( const Hex& hex : changed ) {
+            costs[ hex ] = ( costs[ hex ] < HEX_PATH_BLOCKED ? HEX_PATH_BLOCKED : 1.0f );
+        }
+        field.Update( changed, costs );
+        DoNotOptimize( field.Distances().Data() );
+    }, "HexFlowField Update 16 cells" + suffix, 1 );
+}
+
+// ================================================================
+// Область видимости: теневое отбрасывание против трассировки лучей
+// ================================================================
+void Bench_HexVisibility( BenchRunner& runner ) {
+    HexMap<uint8_t> blockers( HexMapShape::Rhombus( Hex( 0, 0 ), 256, 256 ), 0 );
+    unsigned seed = 12345;
+
+    for ( size_t i = 0; i != blockers.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        blockers.Cell( i ) = ( ( seed >> 16 ) % 100 < 15 );
+    }
+
+    const auto blocks = [&blockers]( const Hex& hex ) {
+        const uint8_t* blocker = blockers.Find( hex );
+        return ( blocker == nullptr || *blocker != 0 );
+    };
+
+    vector<Hex> viewers;
+
+    for ( int i = 0; i != 64; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        viewers.push_back( Hex( 32 + ( seed >> 8 ) % 192, 32 + ( seed >> 20 ) % 192 ) );
+    }
+
+    for ( int radius : { 10, 20 } ) {
+        const string suffix = " (radius " + std::to_string( radius ) + ")";
+        vector<Hex> visible;
+
+        runner.RunBench( [&] {
+            for ( const Hex& viewer : viewers ) {
+                visible.clear();
+                for ( const Hex& hex : HexRange( viewer, radius ) ) {
+                    const vector<Hex> line = HexLine( viewer, hex, false, 0 );
+                    bool clear = true;
+                    for ( size_t i = 1; i + 1 < line.size() && clear; ++i ) {
+                        clear = !blocks( line[ i ] );
+                    }
+                    if ( clear ) {
+                        visible.push_back( hex );
+                    }
+                }
+                DoNotOptimize( visible.data() );
+            }
+        }, "FOV naive HexLine raycast" + suffix, viewers.size() );
+
+        runner.RunBench( [&] {
+            for ( const Hex& viewer : viewers ) {
+                visible.clear();
+                for ( const Hex& hex : HexRange( viewer, radius ) ) {
+                    if ( HexLineOfSight( viewer, hex, blocks ) ) {
+                        visible.push_back( hex );
+                    }
+                }
+                DoNotOptimize( visible.data() );
+            }
+        }, "FOV HexLineOfSight raycast" + suffix, viewers.size() );
+
+        HexVisibility visibility;
+
+        runner.RunBench( [&] {
+            for ( const Hex& viewer : viewers ) {
+                visibility.FieldOfView( viewer, radius, blockers, visible );
+                DoNotOptimize( visible.data() );
+            }
+        }, "FOV HexVisibility shadowcast" + suffix, viewers.size() );
+
+        const string batch_name = "FOV HexVisibilityBatch shadowcast" + suffix;
+
+        if ( runner.Enabled( batch_name ) ) {
+            HexThreadPool pool;
+            HexVisibilityBatch batch( pool );
+            vector<vector<Hex>> batch_visible;
+
+            runner.RunBench( [&] {
+                batch.FieldOfView( viewers, radius, blockers, batch_visible );
+                DoNotOptimize( batch_visible.data() );
+            }, batch_name, viewers.size() );
+        }
+    }
+}
+
+// ================================================================
+// Линия гексов: HexLine против HexLineWalker
+// ================================================================
+void Bench_HexLineWalker( BenchRunner& runner ) {
+    for ( int length : { 8, 64, 1024 } ) {
+        // Линии во всех направлениях (в том числе с точками посередине между гексами)
+        vector<std::pair<Hex, Hex>> lines;
+        size_t hexes = 0;
+
+        for ( const Hex& end : HexRing( Hex( 0, 0 ), length ) ) {
+            lines.emplace_back( Hex( 3, -7 ), Hex( 3, -7 ) + end );
+            hexes += length + 1;
+        }
+
+        const string suffix = " (distance " + std::to_string( length ) + ")";
+
+        runner.RunBench( [&] {
+            for ( const auto& line : lines ) {
+                DoNotOptimize( HexLine( line.first, line.second, false, 0 ).back() );
+            }
+        }, "HexLine" + suffix, hexes );
+
+        runner.RunBench( [&] {
+            for ( const auto& line : lines ) {
+                int sum = 0;
+                for ( const Hex& hex : HexLineWalker( line.first, line.second ) ) {
+                    sum += hex.Q();
+                }
+                DoNotOptimize( sum );
+            }
+        }, "HexLineWalker" + suffix, hexes );
+    }
+}
+
+// ================================================================
+// Подсчёт точек по гексам: по точке против HexBinner (точек в секунду)
+// ================================================================
+void Bench_HexBinner( BenchRunner& runner ) {
+    if ( !runner.Enabled( "HexBinner" ) && !runner.Enabled( "per-point binning" ) ) {
+        return;
+    }
+
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 5, 5 ), Point( 0, 0 ) );
+    const size_t count = 1 << 22;
+    vector<double> x( count );
+    vector<double> y( count );
+    std::ostringstream text;
+    std::ostringstream binary;
+    unsigned seed = 4242;
+
+    // Треки: случайное блуждание со сменой начала (точки соседних индексов рядом)
+    double px = 0.0;
+    double py = 0.0;
+
+    for ( size_t i = 0; i != count; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+
+        if ( i % 10000 == 0 ) {
+            px = static_cast<double>( ( seed >> 8 ) % 100000 );
+            py = static_cast<double>( ( seed >> 12 ) % 100000 );
+        }
+
+        px += static_cast<double>( ( seed >> 8 ) % 2001 ) / 1000.0 - 1.0;
+        py += static_cast<double>( ( seed >> 16 ) % 2001 ) / 1000.0 - 1.0;
+        x[ i ] = px;
+        y[ i ] = py;
+    }
+
+    text.precision( 10 );
+
+    for ( size_t i = 0; i != count; ++i ) {
+        text << x[ i ] << ',' << y[ i ] << '\n';
+        binary.write( reinterpret_cast<const char*>( &x[ i ] ), sizeof( double ) );
+        binary.write( reinterpret_cast<const char*>( &y[ i ] ), sizeof( double ) );
+    }
+
+    const string text_data = text.str();
+    const string binary_data = binary.str();
+
+    runner.RunBench( [&] {
+        std::unordered_map<Hex, uint64_t> histogram;
+        for ( size_t i = 0; i != count; ++i ) {
+            ++histogram[ PixelToHex( layout, Point( x[ i ], y[ i ] ) ).Round( HEX_ROUND_DEFAULT ) ];
+        }
+        DoNotOptimize( histogram.size() );
+    }, "per-point binning (unordered_map)", count );
+
+    HexThreadPool pool;
+
+    for ( HexThreadPool* binner_pool : { static_cast<HexThreadPool*>( nullptr ), &pool } ) {
+        const string suffix = ( binner_pool == nullptr ? " (no pool)" : " (pool x" + std::to_string( pool.ThreadCount() ) + ")" );
+
+        runner.RunBench( [&] {
+            HexBinner binner( layout, binner_pool );
+            binner.Add( x.data(), y.data(), count );
+            DoNotOptimize( binner.Histogram().ChunkCount() );
+        }, "HexBinner Add" + suffix, count );
+
+        runner.RunBench( [&] {
+            HexBinner binner( layout, binner_pool );
+            std::istringstream input( text_data );
+            binner.ReadText( input );
+            DoNotOptimize( binner.Histogram().ChunkCount() );
+        }, "HexBinner ReadText" + suffix, count );
+
+        runner.RunBench( [&] {
+            HexBinner binner( layout, binner_pool );
+            std::istringstream input( binary_data );
+            binner.ReadBinary( input );
+            DoNotOptimize( binner.Histogram().ChunkCount() );
+        }, "HexBinner ReadBinary" + suffix, count );
+    }
+}
+
+// ================================================================
+// Шаг диффузии: HexStencil против обхода HexMap с соседями-гексами
+// ================================================================
+void Bench_HexStencil( BenchRunner& runner ) {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 1, 1 ), Point( 0, 0 ) );
+    const float rate = 0.1f;
+
+    const auto diffusion = [rate]( const HexStencilCell<float, 1>& cell ) {
+        cell.Next() = cell() + rate * ( cell.NeighborSum() - 6.0f * cell() );
+    };
+
+    if ( runner.Enabled( "HexMap diffusion" ) ) {
+        const HexMapShape shape = HexMapShape::Rectangle( layout, 1024, 1024 );
+        HexMap<float> map( shape, 1.0f );
+        HexMap<float> next( shape );
+
+        runner.RunBench( [&] {
+            for ( auto cell : map ) {
+                float sum = 0.0f;
+                for ( const Hex& direction : HEX_DIRECTIONS ) {
+                    const float* neighbor = map.Find( cell.hex + direction );
+                    sum += ( neighbor != nullptr ? *neighbor : 0.0f );
+                }
+                next[ cell.hex ] = cell.value + rate * ( sum - 6.0f * cell.value );
+            }
+            std::swap( map, next );
+        }, "HexMap diffusion (1024x1024, Hex neighbors)", shape.Size() );
+    }
+
+    HexThreadPool pool;
+
+    for ( int side : { 1024, 2048, 4096, 8192 } ) {
+        const string size = std::to_string( side ) + "x" + std::to_string( side );
+        const string name = "HexStencil diffusion (" + size + ")";
+        const string pool_name = "HexStencil diffusion (" + size + ", pool x" + std::to_string( pool.ThreadCount() ) + ")";
+
+        if ( !runner.Enabled( name ) && !runner.Enabled( pool_name ) ) {
+            continue;
+        }
+
+        HexStencil<float> stencil( HexMapShape::Rectangle( layout, side, side ) );
+        stencil.Fill( 1.0f );
+        stencil[ Offset_to_Cube( layout, OffsetHex( side / 2, side / 2 ) ) ] = 1000.0f;
+
+        runner.RunBench( [&] { stencil.Step( diffusion ); }, name, stencil.Size() );
+        runner.RunBench( [&] { stencil.Step( diffusion, &pool ); }, pool_name, stencil.Size() );
+    }
+}
+
+// ================================================================
+// Пространственный индекс: 500k объектов, перестроение и
+// пакетное обновление при разной доле перемещающихся объектов
+// ================================================================
+void Bench_HexSpatialIndex( BenchRunner& runner ) {
+    const size_t count = 500000;
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 1.0, 1.0 ), Point( 0.0, 0.0 ) );
+    vector<double> x( count );
+    vector<double> y( count );
+    unsigned seed = 12345;
+
+    // Около 2 объектов на гекс
+    for ( size_t i = 0; i != count; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        x[ i ] = ( ( seed >> 8 ) % 100000 ) / 100.0;
+        seed = seed * 1103515245U + 12345U;
+        y[ i ] = ( ( seed >> 8 ) % 100000 ) / 100.0;
+    }
+
+    HexThreadPool pool;
+    HexSpatialIndex index( count );
+
+    for ( int percent : { 1, 10, 100 } ) {
+        // Вызовы чередуют исходные положения и положения со сдвигом части объектов
+        vector<double> moved_x( x );
+        vector<double> moved_y( y );
+
+        for ( size_t i = 0; i < count; i += 100 / percent ) {
+            moved_x[ i ] += 2.5;
+            moved_y[ i ] += 1.5;
+        }
+
+        const string suffix = " 500k (" + std::to_string( percent ) + "% moved)";
+        bool toggle = false;
+
+        index.Rebuild( layout, x.data(), y.data(), count );
+        runner.RunBench( [&] {
+            toggle = !toggle;
+            index.Rebuild( layout, ( toggle ? moved_x : x ).data(), ( toggle ? moved_y : y ).data(), count, &pool );
+            DoNotOptimize( index.Size() );
+        }, "HexSpatialIndex Rebuild" + suffix, count );
+
+        toggle = false;
+        index.Rebuild( layout, x.data(), y.data(), count );
+        runner.RunBench( [&] {
+            toggle = !toggle;
+            index.Update( layout, ( toggle ? moved_x : x ).data(), ( toggle ? moved_y : y ).data(), count, &pool );
+            DoNotOptimize( index.Size() );
+        }, "HexSpatialIndex Update" + suffix, count );
+    }
+
+    // Запросы по индексу
+    index.Rebuild( layout, x.data(), y.data(), count );
+    vector<Hex> centers;
+
+    for ( size_t i = 0; i != 1024; ++i ) {
+        centers.push_back( index.HexOf( static_cast<uint32_t>( ( i * 7919 ) % count ) ) );
+    }
+
+    vector<uint32_t> result;
+
+    for ( int radius : { 2, 8 } ) {
+        runner.RunBench( [&] {
+            for ( const Hex& center : centers ) {
+                index.QueryRadius( center, radius, result );
+                DoNotOptimize( result.data() );
+            }
+        }, "HexSpatialIndex QueryRadius (radius " + std::to_string( radius ) + ")", centers.size() );
+    }
+
+    for ( size_t k : { 1, 16, 128 } ) {
+        runner.RunBench( [&] {
+            for ( const Hex& center : centers ) {
+                index.QueryNearest( center, k, result );
+                DoNotOptimize( result.data() );
+            }
+        }, "HexSpatialIndex QueryNearest (k = " + std::to_string( k ) + ")", centers.size() );
+    }
+}
+
+// ================================================================
+// Иерархия гексов: агрегаты на карте 1024x1024 и иерархический поиск пути
+// ================================================================
+void Bench_HexHierarchy( BenchRunner& runner ) {
+    const int size = 1024;
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), size, size );
+    const HexHierarchy hierarchy( shape, 5 );
+    HexMap<uint32_t> occupancy( shape, 0 );
+    unsigned seed = 12345;
+
+    for ( size_t i = 0; i != occupancy.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        occupancy.Cell( i ) = ( ( seed >> 16 ) % 4 == 0 ? 1 : 0 );
+    }
+
+    HexHierarchyAggregate<uint32_t> counts( hierarchy, HEX_AGGREGATE_SUM );
+
+    runner.RunBench( [&] {
+        counts.Build( occupancy );
+        DoNotOptimize( counts.Value( hierarchy.Levels(), 0 ) );
+    }, "HexHierarchyAggregate Build (1M cells, 5 levels)", occupancy.Size() );
+
+    vector<size_t> changes;
+
+    for ( size_t i = 0; i != 4096; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        changes.push_back( ( seed >> 4 ) % occupancy.Size() );
+    }
+
+    runner.RunBench( [&] {
+        for ( size_t index : changes ) {
+            counts.Set( index, counts.Value( 0, index ) ^ 1U );
+        }
+    }, "HexHierarchyAggregate Set (5 levels)", changes.size() );
+
+    // Занятость области радиуса 64 вокруг центра: по ячейкам уровня 0 и по ячейкам уровня k
+    // (область уровня k покрывает примерно ту же площадь)
+    const Hex center( size / 2, size / 2 );
+
+    for ( int level = 0; level <= hierarchy.Levels(); ++level ) {
+        const int radius = std::max( 1, static_cast<int>( 64 / std::pow( std::sqrt( 7.0 ), level ) ) );
+        const Hex coarse_center = HexParent( center, level );
+
+        runner.RunBench( [&] {
+            uint32_t total = 0;
+
+            for ( const Hex& hex : HexRange( coarse_center, radius ) ) {
+                const uint32_t* value = counts.Level( level ).Find( hex );
+                total += ( value != nullptr ? *value : 0 );
+            }
+
+            DoNotOptimize( total );
+        }, "HexHierarchyAggregate region query (level " + std::to_string( level ) + ")", 1 );
+    }
+
+    // Иерархический поиск пути по сравнению с A*
+    HexMap<float> costs( shape, 1.0f );
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned value = ( seed >> 16 ) % 16;
+        costs.Cell( i ) = ( value < 4 ? HEX_PATH_BLOCKED : 1.0f + value % 4 );
+    }
+
+    vector<std::pair<Hex, Hex>> queries;
+
+    while ( queries.size() != 8 ) {
+        seed = seed * 1103515245U + 12345U;
+        const size_t start = ( seed >> 4 ) % costs.Size();
+        seed = seed * 1103515245U + 12345U;
+        const size_t goal = ( seed >> 4 ) % costs.Size();
+
+        if ( costs.Cell( start ) < HEX_PATH_BLOCKED && costs.Cell( goal ) < HEX_PATH_BLOCKED ) {
+            queries.emplace_back( shape.HexAt( start ), shape.HexAt( goal ) );
+        }
+    }
+
+    HexPathfinder pathfinder( shape );
+    vector<Hex> path;
+    float optimal_cost = 0.0f;
+
+    for ( const auto& query : queries ) {
+        optimal_cost += pathfinder.FindPath( query.first, query.second, costs, path ).cost;
+    }
+
+    for ( int level = 2; level <= 4; ++level ) {
+        const string name = "HexHierarchicalPathfinder A* (1024x1024, level " + std::to_string( level ) + ")";
+
+        if ( !runner.Enabled( name ) ) {
+            continue;
+        }
+
+        HexHierarchicalPathfinder hierarchical( hierarchy, level );
+        hierarchical.Build( costs );
+        size_t expanded = 0;
+        float cost = 0.0f;
+
+        for ( const auto& query : queries ) {
+            const HexPathStats stats = hierarchical.FindPath( query.first, query.second, costs, path );
+            expanded += stats.nodes_expanded;
+            cost += stats.cost;
+        }
+
+        runner.Report( name, { { static_cast<double>( expanded ) / queries.size(), "nodes/query" },
+                               { cost / optimal_cost, "cost/optimal" } } );
+
+        runner.RunBench( [&] {
+            for ( const auto& query : queries ) {
+                DoNotOptimize( hierarchical.FindPath( query.first, query.second, costs, path ).cost );
+            }
+        }, name, queries.size() );
+    }
+}
+
+// ================================================================
+// benchmark [--json] [filter]
+// ================================================================
+// filter - подстрока названия бенчмарка, --json - результаты
+// в формате JSON Lines (см. BenchRunner)
+// ================================================================
+int main( int argc, char** argv ) {
+    string filter;
+    BenchFormat_t format = BENCH_FORMAT_TEXT;
+
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[ i ], "--json" ) == 0 ) {
+            format = BENCH_FORMAT_JSON;
+        } else if ( strcmp( argv[ i ], "--help" ) == 0 || strcmp( argv[ i ], "-h" ) == 0 ) {
+            printf( "Usage: benchmark [--json] [filter]\n" );
+            return 0;
+        } else {
+            filter = argv[ i ];
+        }
+    }
+
+    BenchRunner runner( filter, format );
+#if defined( __VERSION__ )
+    runner.Context( "compiler", __VERSION__ );
+#endif
+    runner.Context( "simd", HexBatchKernelName( HexBatchKernel() ) );
+    runner.Context( "threads", std::to_string( std::thread::hardware_concurrency() ) );
+    runner.Context( "profile", HexProfileEnabled() ? "on" : "off" );
+
+    Bench_HexValue( runner );
+    Bench_HexLayout( runner );
+    Bench_PixelToHexBatch( runner );
+    Bench_HexCornersBatch( runner );
+    Bench_OffsetCubeBatch( runner );
+    Bench_HexMap( runner );
+    Bench_HexMorton( runner );
+    Bench_HexMapFile( runner );
+    Bench_HexChunkMap( runner );
+    Bench_HexKey( runner );
+    Bench_HexRange( runner );
+    Bench_HexPathfinder( runner );
+    Bench_HexPathBatch( runner );
+    Bench_HexFlowField( runner );
+    Bench_HexHierarchy( runner );
+    Bench_HexLineWalker( runner );
+    Bench_HexVisibility( runner );
+    Bench_HexSpatialIndex( runner );
+    Bench_HexBinner( runner );
+    Bench_HexStencil( runner );
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * hexbin.cpp
+ *
+ * Подсчёт точек по гексам: потоковая обработка файла или стандартного ввода
+ */
+
+#include "HexGrid.h"
+#include "HexBinner.h"
+#include "HexKey.h"
+#include "HexThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+using std::string;
+
+static void Usage() {
+    fprintf( stderr,
+             "Usage: hexbin [options] [input]\n"
+             "Counts points ( x y per line, or pairs of double with --binary ) per hex.\n"
+             "Input - file or standard input ( '-' or omitted ), output - lines \"q r count\".\n"
+             "  --size X[,Y]          hex size ( default 1 )\n"
+             "  --origin X,Y          plane origin ( default 0,0 )\n"
+             "  --orientation NAME    flat | pointy ( default pointy )\n"
+             "  --binary              input is pairs of double ( host byte order )\n"
+             "  --threads N           worker threads ( default - hardware threads )\n"
+             "  --chunk N             points per read chunk ( default %zu )\n"
+             "  --output FILE         output file ( default standard output )\n",
+             HexBinner::DEFAULT_CHUNK_POINTS );
+}
+
+// Пара чисел "X,Y" (или одно число "X" => X,X)
+static bool ParsePair( const char* text, double& x, double& y ) {
+    char* end = nullptr;
+    x = strtod( text, &end );
+
+    if ( end == text ) {
+        return false;
+    }
+
+    if ( *end == '\0' ) {
+        y = x;
+        return true;
+    }
+
+    if ( *end != ',' ) {
+        return false;
+    }
+
+    const char* second = end + 1;
+    y = strtod( second, &end );
+    return ( end != second && *end == '\0' );
+}
+
+int main( int argc, char** argv ) {
+    double size_x = 1.0;
+    double size_y = 1.0;
+    double origin_x = 0.0;
+    double origin_y = 0.0;
+    HexOrientation_t orientation = HEX_ORIENTATION_POINTY;
+    bool binary = false;
+    unsigned threads = 0;
+    size_t chunk_points = HexBinner::DEFAULT_CHUNK_POINTS;
+    string input_path = "-";
+    string output_path;
+
+    for ( int i = 1; i < argc; ++i ) {
+        const string arg = argv[ i ];
+        const bool has_value = ( i + 1 < argc );
+        bool valid = true;
+
+        if ( arg == "--help" || arg == "-h" ) {
+            Usage();
+            return 0;
+        } else if ( arg == "--binary" ) {
+            binary = true;
+        } else if ( arg == "--size" && has_value ) {
+            valid = ParsePair( argv[ ++i ], size_x, size_y );
+        } else if ( arg == "--origin" && has_value ) {
+            valid = ParsePair( argv[ ++i ], origin_x, origin_y );
+        } else if ( arg == "--orientation" && has_value ) {
+            const string name = argv[ ++i ];
+            valid = ( name == "flat" || name == "pointy" );
+            orientation = ( name == "flat" ? HEX_ORIENTATION_FLAT : HEX_ORIENTATION_POINTY );
+        } else if ( arg == "--threads" && has_value ) {
+            threads = static_cast<unsigned>( strtoul( argv[ ++i ], nullptr, 10 ) );
+        } else if ( arg == "--chunk" && has_value ) {
+            chunk_points = static_cast<size_t>( strtoull( argv[ ++i ], nullptr, 10 ) );
+            valid = ( chunk_points != 0 );
+        } else if ( arg == "--output" && has_value ) {
+            output_path = argv[ ++i ];
+        } else if ( arg.size() > 1 && arg[ 0 ] == '-' ) {
+            valid = false;
+        } else {
+            input_path = arg;
+        }
+
+        if ( !valid ) {
+            fprintf( stderr, "hexbin: invalid argument %s\n", arg.c_str() );
+            Usage();
+            return 2;
+        }
+    }
+
+    std::ifstream file;
+
+    if ( input_path != "-" ) {
+        file.open( input_path, binary ? std::ios::binary : std::ios::in );
+
+        if ( !file ) {
+            fprintf( stderr, "hexbin: cannot open %s\n", input_path.c_str() );
+            return 1;
+        }
+    }
+
+    std::istream& input = ( input_path != "-" ? file : std::cin );
+    std::ios::sync_with_stdio( false );
+
+    const auto start = std::chrono::steady_clock::now();
+    const HexLayout layout( orientation, OFFSET_TYPE_ODD, Point( size_x, size_y ), Point( origin_x, origin_y ) );
+    HexThreadPool pool( threads );
+    HexBinner binner( layout, &pool, chunk_points );
+
+    if ( binary ) {
+        binner.ReadBinary( input );
+    } else {
+        binner.ReadText( input );
+    }
+
+    if ( input.bad() ) {
+        fprintf( stderr, "hexbin: read error\n" );
+        return 1;
+    }
+
+    // Гексы с точками в порядке ( Q, R )
+    vector<std::pair<Hex, uint64_t>> bins;
+
+    binner.Histogram().ForEachChunk( [&bins]( const Hex& origin, uint64_t* cells ) {
+        for ( size_t i = 0; i != HexChunkMap<uint64_t>::CHUNK_SIZE; ++i ) {
+            if ( cells[ i ] != 0 ) {
+                bins.emplace_back( HexChunkMap<uint64_t>::ChunkCellHex( origin, i ), cells[ i ] );
+            }
+        }
+    } );
+
+    std::sort( bins.begin(), bins.end(), []( const std::pair<Hex, uint64_t>& a, const std::pair<Hex, uint64_t>& b ) {
+        return a.first < b.first;
+    } );
+
+    FILE* output = ( output_path.empty() ? stdout : fopen( output_path.c_str(), "w" ) );
+
+    if ( output == nullptr ) {
+        fprintf( stderr, "hexbin: cannot create %s\n", output_path.c_str() );
+        return 1;
+    }
+
+    for ( const auto& bin : bins ) {
+        fprintf( output, "%d %d %llu\n", bin.first.Q(), bin.first.R(), static_cast<unsigned long long>( bin.second ) );
+    }
+
+    const bool written = ( output == stdout ? fflush( output ) == 0 : fclose( output ) == 0 );
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    fprintf( stderr, "hexbin: %llu points, %llu rejected lines, %zu hexes, %.3f s, %.2f Mpoints/s\n",
+             static_cast<unsigned long long>( binner.Points() ), static_cast<unsigned long long>( binner.Rejected() ),
+             bins.size(), seconds, binner.Points() / seconds / 1e6 );
+
+    return ( written ? 0 : 1 );
+}
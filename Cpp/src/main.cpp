@@ -6,18 +6,104 @@
 
 #include "test_runner.h"
 #include "HexGrid.h"
+#include "HexBatch.h"
+#include "HexBinner.h"
+#include "HexChunkMap.h"
+#include "HexFlowField.h"
+#include "HexHierarchicalPathfinder.h"
+#include "HexHierarchy.h"
+#include "HexKey.h"
+#include "HexLineWalker.h"
+#include "HexMap.h"
+#include "HexMapFile.h"
+#include "HexMorton.h"
+#include "HexPathBatch.h"
+#include "HexPathfinder.h"
+#include "HexProfile.h"
+#include "HexRange.h"
+#include "HexSpatialIndex.h"
+#include "HexStencil.h"
+#include "HexThreadPool.h"
+#include "HexVisibility.h"
+
+#include <atomic>
+#include <bitset>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+// ================================================================
+// Подсчёт выделений памяти текущего потока (см. Test_HexNoAllocation),
+// выделения передаются и в счётчики HexProfile (см. Test_HexProfile)
+// ================================================================
+thread_local size_t test_allocated_bytes = 0;
+
+// Замены не встраиваются: иначе GCC сопоставляет malloc / free
+// в вызывающем коде с new / delete ( -Wmismatched-new-delete )
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void* operator new( std::size_t size ) {
+    test_allocated_bytes += size;
+    HexProfileAllocation();
+
+    if ( void* data = std::malloc( size != 0 ? size : 1 ) ) {
+        return data;
+    }
+
+    throw std::bad_alloc();
+}
+
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void operator delete( void* data ) noexcept {
+    std::free( data );
+}
+
+#if defined( __GNUC__ )
+__attribute__( ( noinline ) )
+#endif
+void operator delete( void* data, std::size_t ) noexcept {
+    std::free( data );
+}
 
 void Test_HexArithmetic() {
     AssertEqual( Hex( 1, -3 ) + Hex( 3, -7 ), Hex( 4, -10 ), "Hex + Hex" );
     AssertEqual( Hex( 1, -3 ) - Hex( 3, -7 ), Hex( -2, 4 ), "Hex - Hex" );
 }
 
+void Test_HexValue() {
+    constexpr Hex a( 1, -3 );
+    static_assert( a.S() == 2, "constexpr Hex" );
+    static_assert( a + Hex( 3, -7 ) == Hex( 4, -10 ), "constexpr Hex + Hex" );
+
+    Hex b;
+    AssertEqual( b, Hex( 0, 0 ), "Hex()" );
+    b = a;
+    AssertEqual( b, a, "Hex = Hex" );
+
+    FractionalHex c( 0.5L, -0.25L );
+    c = FractionalHex( 1.0L, -1.0L, 0.0L );
+    AssertEqual( c.Round( 0 ), Hex( 1, -1 ), "FractionalHex = FractionalHex" );
+}
+
 void Test_HexDirection() {
     AssertEqual( HexDirection( 2 ), Hex( 0, -1 ), "HexDirection" );
 }
 
 void Test_HexNeighbor() {
     AssertEqual( Hex( 1, -2 ).HexNeighbor( 2 ), Hex( 1, -3 ), "HexNeighbor" );
+    AssertEqual( Hex( 1, -2 ).HexNeighbor( -1 ), Hex( 1, -2 ).HexNeighbor( 5 ), "HexNeighbor negative" );
 }
 
 void Test_HexDiagonal() {
@@ -71,12 +157,92 @@ void Test_HexRound() {
     AssertEqual( FractionalHex( q2, r2, s2 ).Round( 2 ), c.Round( 2 ), "HexRound 5 (2)" );
 }
 
+vector<int> HexRoundSequence( unsigned seed ) {
+    HexRoundSeed( seed );
+    vector<int> sequence;
+
+    for ( int i = 0; i < 32; ++i ) {
+        sequence.push_back( HexRoundAlgorithm( HEX_ROUND_RANDOM ) );
+    }
+
+    return sequence;
+}
+
+void Test_HexRoundAlgorithm() {
+    AssertEqual( HexRoundAlgorithm( HEX_ROUND_S ), 2, "HexRoundAlgorithm fixed" );
+
+    const vector<int> sequence = HexRoundSequence( 42 );
+    AssertEqual( HexRoundSequence( 42 ), sequence, "HexRoundAlgorithm reseed" );
+    Assert( HexRoundSequence( 7 ) != sequence, "HexRoundAlgorithm other seed" );
+
+    vector<int> thread_sequence;
+    std::thread( [&thread_sequence] { thread_sequence = HexRoundSequence( 42 ); } ).join();
+    AssertEqual( thread_sequence, sequence, "HexRoundAlgorithm thread" );
+
+    HexRoundSeed( 1 );
+    const vector<Hex> line = HexLine( Hex( 0, 0 ), Hex( 3, -7 ), false, 0, HEX_ROUND_RANDOM );
+    HexRoundSeed( 1 );
+    AssertEqual( HexLine( Hex( 0, 0 ), Hex( 3, -7 ), false, 0, HEX_ROUND_RANDOM ), line, "HexLine reproducible" );
+}
+
 void Test_HexLine() {
     AssertEqual( HexLine( Hex( 0, 0 ), Hex( 1, -5 ), false, 0 ),
                 vector<Hex> { Hex( 0, 0 ), Hex( 0, -1 ), Hex( 0, -2 ),
                 Hex( 1, -3 ), Hex( 1, -4 ), Hex( 1, -5 )}, "HexLine" );
 }
 
+void Test_HexNoAllocation() {
+    const HexLayout layout( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 10, 15 ), Point( 35, 71 ) );
+    const Hex hex( 3, -7 );
+    const vector<Hex> neighbors = hex.HexNeighbors();
+    const vector<Hex> diagonals = hex.HexDiagonals();
+    const vector<Point> corners = hex.HexCorners( layout );
+    const vector<Hex> line = HexLine( hex, Hex( -4, 9 ), false, 0, HEX_ROUND_Q );
+    const vector<Hex> short_line = HexLine( hex, Hex( -4, 9 ), true, 5, HEX_ROUND_Q );
+
+    // Буферы результатов и первый вызов (инициализация счётчиков потока HexProfile)
+    Hex neighbor_out[ HEX_DIRECTION_COUNT ], diagonal_out[ HEX_DIRECTION_COUNT ], line_out[ 64 ];
+    Point corner_out[ HEX_CORNER_COUNT ];
+    vector<Hex> buffer, short_buffer;
+    buffer.reserve( 64 );
+    short_buffer.reserve( 64 );
+    hex.HexNeighbors( neighbor_out );
+
+    size_t allocated = test_allocated_bytes;
+    AssertEqual( hex.HexNeighbors().size(), HEX_DIRECTION_COUNT, "HexNeighbors vector" );
+    Assert( test_allocated_bytes != allocated, "vector results allocate" );
+
+    // Проверки выделяют память (строки подсказок), поэтому выполняются после замера
+    allocated = test_allocated_bytes;
+
+    hex.HexNeighbors( neighbor_out );
+    const array<Hex, HEX_DIRECTION_COUNT> neighbor_array = hex.HexNeighborsArray();
+    hex.HexDiagonals( diagonal_out );
+    const array<Hex, HEX_DIRECTION_COUNT> diagonal_array = hex.HexDiagonalsArray();
+    hex.HexCorners( layout, corner_out );
+    const array<Point, HEX_CORNER_COUNT> corner_array = hex.HexCornersArray( layout );
+    const size_t line_size = HexLine( hex, Hex( -4, 9 ), false, 0, line_out, HEX_ROUND_Q );
+    HexLine( hex, Hex( -4, 9 ), false, 0, buffer, HEX_ROUND_Q );
+    HexLine( hex, Hex( -4, 9 ), true, 5, short_buffer, HEX_ROUND_Q );
+
+    allocated = test_allocated_bytes - allocated;
+    AssertEqual( allocated, 0U, "allocated bytes" );
+
+    AssertEqual( vector<Hex>( neighbor_out, neighbor_out + HEX_DIRECTION_COUNT ), neighbors, "HexNeighbors( out )" );
+    Assert( std::equal( neighbor_array.begin(), neighbor_array.end(), neighbors.begin() ), "HexNeighborsArray" );
+    AssertEqual( vector<Hex>( diagonal_out, diagonal_out + HEX_DIRECTION_COUNT ), diagonals, "HexDiagonals( out )" );
+    Assert( std::equal( diagonal_array.begin(), diagonal_array.end(), diagonals.begin() ), "HexDiagonalsArray" );
+    AssertEqual( vector<Point>( corner_out, corner_out + HEX_CORNER_COUNT ), corners, "HexCorners( out )" );
+    Assert( std::equal( corner_array.begin(), corner_array.end(), corners.begin() ), "HexCornersArray" );
+
+    AssertEqual( HexLineSize( hex, Hex( -4, 9 ), false, 0 ), line.size(), "HexLineSize" );
+    AssertEqual( HexLineSize( hex, Hex( -4, 9 ), true, 5 ), short_line.size(), "HexLineSize range" );
+    AssertEqual( line_size, line.size(), "HexLine( out ) size" );
+    AssertEqual( vector<Hex>( line_out, line_out + line_size ), line, "HexLine( out )" );
+    AssertEqual( buffer, line, "HexLine( buffer )" );
+    AssertEqual( short_buffer, short_line, "HexLine( buffer ) range" );
+}
+
 void Test_HexLayout() {
     Hex hex( 3, 4 );
 
@@ -93,6 +259,208 @@ void Test_HexLayout() {
     AssertEqual( PixelToHex( pointy, hex.HexToPixel( pointy ) ).Round( 2 ), hex , "HexLayout Pointy" );
 }
 
+void Test_HexLayoutCache() {
+    HexLayout flat( HEX_ORIENTATION_FLAT, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    HexLayout pointy( HEX_ORIENTATION_POINTY, OFFSET_TYPE_EVEN, Point( 3, 2 ), Point( -5, 7 ) );
+
+    for ( const HexLayout& layout : { flat, pointy } ) {
+        AssertEqual( layout.QX(), HEX_ORIENTATION_MATRIX_1[ layout.orientation ][ 0 ], "HexLayout QX" );
+        AssertEqual( layout.RY(), HEX_ORIENTATION_MATRIX_1[ layout.orientation ][ 3 ], "HexLayout RY" );
+        AssertEqual( layout.XQ(), HEX_ORIENTATION_MATRIX_2[ layout.orientation ][ 0 ], "HexLayout XQ" );
+        AssertEqual( layout.YR(), HEX_ORIENTATION_MATRIX_2[ layout.orientation ][ 3 ], "HexLayout YR" );
+
+        // Смещения углов совпадают с вычислением через cos / sin
+        const Hex hex( 4, -9 );
+        const Point center = hex.HexToPixel( layout );
+
+        for ( int corner = 0; corner != static_cast<int>( HEX_CORNER_COUNT ); ++corner ) {
+            const double angle = 3.141592653589793L * ( layout.start_angle + corner ) / 3.0L;
+            const Point offset = layout.corners[ corner ];
+            Assert( std::abs( offset.x - layout.size.x * cos( angle ) ) < 1e-12, "HexLayout corners x" );
+            Assert( std::abs( offset.y - layout.size.y * sin( angle ) ) < 1e-12, "HexLayout corners y" );
+            AssertEqual( hex.HexCorner( layout, corner ), center + offset, "HexCorner" );
+            AssertEqual( hex.HexCorner( layout, corner - 6 ), center + offset, "HexCorner negative" );
+            AssertEqual( hex.HexCorner( layout, corner + 6 ), center + offset, "HexCorner wrap" );
+            Assert( layout.bounds_min.x <= offset.x && offset.x <= layout.bounds_max.x, "HexLayout bounds x" );
+            Assert( layout.bounds_min.y <= offset.y && offset.y <= layout.bounds_max.y, "HexLayout bounds y" );
+        }
+
+        // Отрезки строк развёртки: точки внутри отрезка принадлежат гексу, снаружи - нет
+        const double eps = 1e-6;
+        double x_min = 0.0, x_max = 0.0;
+        Assert( !layout.RowSpan( layout.bounds_max.y + eps, x_min, x_max ), "RowSpan above" );
+        Assert( !layout.RowSpan( layout.bounds_min.y - eps, x_min, x_max ), "RowSpan below" );
+        Assert( layout.RowSpan( 0.0, x_min, x_max ), "RowSpan center" );
+        Assert( std::abs( x_min - layout.bounds_min.x ) < 1e-9 && std::abs( x_max - layout.bounds_max.x ) < 1e-9, "RowSpan center width" );
+
+        for ( int i = -19; i <= 19; ++i ) {
+            const double dy = layout.bounds_max.y * i / 20.0;
+            Assert( layout.RowSpan( dy, x_min, x_max ), "RowSpan" );
+
+            for ( double dx : { x_min + eps, 0.5 * ( x_min + x_max ), x_max - eps } ) {
+                AssertEqual( PixelToHex( layout, Point( center.x + dx, center.y + dy ) ).Round( 0 ), hex, "RowSpan inside" );
+            }
+
+            for ( double dx : { x_min - eps, x_max + eps } ) {
+                Assert( PixelToHex( layout, Point( center.x + dx, center.y + dy ) ).Round( 0 ) != hex, "RowSpan outside" );
+            }
+        }
+    }
+}
+
+void Test_StaticHexLayout() {
+    constexpr HexLayoutPointyEven pointy( Point( 10, 15 ), Point( 35, 71 ) );
+    static_assert( pointy.Offset_to_Cube( pointy.Cube_to_Offset( Hex( 3, -4 ) ) ) == Hex( 3, -4 ), "constexpr StaticHexLayout" );
+
+    HexLayout flat_odd( HEX_ORIENTATION_FLAT, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    HexLayout pointy_even( HEX_ORIENTATION_POINTY, OFFSET_TYPE_EVEN, Point( 10, 15 ), Point( 35, 71 ) );
+
+    for ( const HexLayout& layout : { flat_odd, pointy_even } ) {
+        HexLayoutDispatch( layout, [&layout]( const auto& static_layout ) {
+            for ( int q = -5; q <= 5; ++q ) {
+                for ( int r = -5; r <= 5; ++r ) {
+                    const Hex hex( q, r );
+                    const Point pixel = hex.HexToPixel( layout );
+                    AssertEqual( static_layout.HexToPixel( hex ), pixel, "StaticHexLayout HexToPixel" );
+                    AssertEqual( PixelToHex( static_layout, pixel ).Round( 0 ), hex, "StaticHexLayout PixelToHex" );
+                    AssertEqual( static_layout.Cube_to_Offset( hex ), Cube_to_Offset( layout, hex ), "StaticHexLayout Cube_to_Offset" );
+                }
+            }
+        } );
+    }
+}
+
+void Test_PixelToHexBatch() {
+    // Точки на сетке с шагом 1/6 гекса (много точек на рёбрах и в углах) и произвольные точки
+    vector<double> x, y;
+
+    for ( int i = -30; i <= 30; ++i ) {
+        for ( int j = -30; j <= 30; ++j ) {
+            x.push_back( HEX_ORIENTATION_MATRIX_1[ HEX_ORIENTATION_POINTY ][ 0 ] * i / 6.0L
+                         + HEX_ORIENTATION_MATRIX_1[ HEX_ORIENTATION_POINTY ][ 1 ] * j / 6.0L );
+            y.push_back( 1.5L * j / 6.0L );
+            x.push_back( 0.37L * i * j + 0.11L * i );
+            y.push_back( -0.23L * i * j + 0.7L * j );
+        }
+    }
+
+    // Нечётная длина - проверка хвоста пакета
+    x.push_back( 1.0L );
+    y.push_back( -1.0L );
+
+    HexLayout pointy( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 1, 1 ), Point( 0, 0 ) );
+    HexLayout flat( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 10, 15 ), Point( 35, 71 ) );
+
+    for ( const HexLayout& layout : { pointy, flat } ) {
+        for ( int round_algorithm = HEX_ROUND_Q; round_algorithm <= HEX_ROUND_S; ++round_algorithm ) {
+            for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+                vector<int> q( x.size() ), r( x.size() );
+                PixelToHexBatch( layout, x.data(), y.data(), x.size(), q.data(), r.data(), round_algorithm, kernel );
+
+                for ( size_t i = 0; i != x.size(); ++i ) {
+                    AssertEqual( Hex( q[ i ], r[ i ] ), PixelToHex( layout, Point( x[ i ], y[ i ] ) ).Round( round_algorithm ),
+                                 string( "PixelToHexBatch " ) + HexBatchKernelName( HexBatchKernel( kernel ) ) );
+                }
+            }
+        }
+    }
+}
+
+void Test_HexCornersBatch() {
+    vector<int> q, r;
+
+    for ( int i = -20; i <= 20; ++i ) {
+        for ( int j = -20; j <= 20; ++j ) {
+            q.push_back( i );
+            r.push_back( j * 3 - i );
+        }
+    }
+
+    HexLayout pointy( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    HexLayout flat( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 3, 2 ), Point( -5, 7 ) );
+
+    for ( const HexLayout& layout : { pointy, flat } ) {
+        for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+            const string hint = HexBatchKernelName( HexBatchKernel( kernel ) );
+            vector<double> x( q.size() ), y( q.size() ), vertices( q.size() * HEX_CORNER_VERTEX_STRIDE );
+            HexToPixelBatch( layout, q.data(), r.data(), q.size(), x.data(), y.data(), kernel );
+            HexCornersBatch( layout, q.data(), r.data(), q.size(), vertices.data(), kernel );
+
+            for ( size_t i = 0; i != q.size(); ++i ) {
+                const Hex hex( q[ i ], r[ i ] );
+                AssertEqual( Point( x[ i ], y[ i ] ), hex.HexToPixel( layout ), "HexToPixelBatch " + hint );
+
+                const vector<Point> corners = hex.HexCorners( layout );
+
+                for ( size_t j = 0; j != corners.size(); ++j ) {
+                    const double* vertex = &vertices[ i * HEX_CORNER_VERTEX_STRIDE + 2 * j ];
+                    AssertEqual( Point( vertex[ 0 ], vertex[ 1 ] ), corners[ j ], "HexCornersBatch " + hint );
+                }
+            }
+        }
+    }
+}
+
+void Test_OffsetCubeBatch() {
+    // Отрицательные и положительные координаты всех чётностей и крайние значения
+    vector<int> a, b;
+
+    for ( int i = -25; i <= 25; ++i ) {
+        for ( int j = -25; j <= 25; ++j ) {
+            a.push_back( i );
+            b.push_back( j * 7 - i );
+        }
+    }
+
+    for ( int value : { INT_MIN / 4, INT_MIN / 4 + 1, -1, 0, 1, INT_MAX / 4 - 1, INT_MAX / 4 } ) {
+        for ( int other : { INT_MIN / 4, -3, 0, 2, INT_MAX / 4 } ) {
+            a.push_back( value );
+            b.push_back( other );
+        }
+    }
+
+    // Нечётная длина - проверка хвоста пакета
+    a.push_back( -7 );
+    b.push_back( 5 );
+
+    for ( HexOrientation_t orientation : { HEX_ORIENTATION_FLAT, HEX_ORIENTATION_POINTY } ) {
+        for ( OffsetType_t offset_type : { OFFSET_TYPE_ODD, OFFSET_TYPE_EVEN } ) {
+            const HexLayout layout( orientation, offset_type, Point( 1, 1 ), Point( 0, 0 ) );
+
+            for ( HexBatchKernel_t kernel : { HEX_BATCH_SCALAR, HEX_BATCH_SSE2, HEX_BATCH_AVX2 } ) {
+                const string hint = HexBatchKernelName( HexBatchKernel( kernel ) );
+                vector<int> q( a.size() ), r( a.size() ), col( a.size() ), row( a.size() );
+
+                // a, b - офсетные координаты
+                OffsetToCubeBatch( layout, a.data(), b.data(), a.size(), q.data(), r.data(), kernel );
+                CubeToOffsetBatch( layout, q.data(), r.data(), q.size(), col.data(), row.data(), kernel );
+
+                for ( size_t i = 0; i != a.size(); ++i ) {
+                    AssertEqual( Hex( q[ i ], r[ i ] ), Offset_to_Cube( layout, OffsetHex( a[ i ], b[ i ] ) ), "OffsetToCubeBatch " + hint );
+                    AssertEqual( OffsetHex( col[ i ], row[ i ] ), OffsetHex( a[ i ], b[ i ] ), "OffsetToCubeBatch round trip " + hint );
+                }
+
+                // a, b - кубические координаты
+                CubeToOffsetBatch( layout, a.data(), b.data(), a.size(), col.data(), row.data(), kernel );
+                OffsetToCubeBatch( layout, col.data(), row.data(), col.size(), q.data(), r.data(), kernel );
+
+                for ( size_t i = 0; i != a.size(); ++i ) {
+                    AssertEqual( OffsetHex( col[ i ], row[ i ] ), Cube_to_Offset( layout, Hex( a[ i ], b[ i ] ) ), "CubeToOffsetBatch " + hint );
+                    AssertEqual( Hex( q[ i ], r[ i ] ), Hex( a[ i ], b[ i ] ), "CubeToOffsetBatch round trip " + hint );
+                }
+
+                // Преобразование на месте
+                q = a;
+                r = b;
+                OffsetToCubeBatch( layout, q.data(), r.data(), q.size(), q.data(), r.data(), kernel );
+                CubeToOffsetBatch( layout, q.data(), r.data(), q.size(), q.data(), r.data(), kernel );
+                AssertEqual( q, a, "OffsetToCubeBatch in place " + hint );
+                AssertEqual( r, b, "OffsetToCubeBatch in place " + hint );
+            }
+        }
+    }
+}
+
 void Test_OffsetCubeConversion() {
     Hex a( 3, 4 );
     OffsetHex b( 1, -3 );
@@ -130,20 +498,1466 @@ void Test_OffsetToCube() {
     AssertEqual( Offset_to_Cube( odd, OffsetHex( 1, 2 ) ), Hex( 1, 2 ), "Offset_to_Cube odd-q" );
 }
 
+void Test_HexMapShape() {
+    HexLayout even_q( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 10, 10 ), Point( 0, 0 ) );
+    HexLayout odd_r( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 10 ), Point( 0, 0 ) );
+
+    for ( const HexLayout& layout : { even_q, odd_r } ) {
+        const HexMapShape rectangle = HexMapShape::Rectangle( layout, 7, 5 );
+        AssertEqual( rectangle.Size(), 35U, "HexMapShape Rectangle size" );
+
+        for ( int col = 0; col != 7; ++col ) {
+            for ( int row = 0; row != 5; ++row ) {
+                const Hex hex = Offset_to_Cube( layout, OffsetHex( col, row ) );
+                Assert( rectangle.Contains( hex ), "HexMapShape Rectangle contains" );
+                AssertEqual( rectangle.Index( hex ),
+                             static_cast<size_t>( layout.orientation == HEX_ORIENTATION_FLAT ? col * 5 + row : row * 7 + col ),
+                             "HexMapShape Rectangle index" );
+            }
+        }
+
+        Assert( !rectangle.Contains( Offset_to_Cube( layout, OffsetHex( 7, 0 ) ) ), "HexMapShape Rectangle col" );
+        Assert( !rectangle.Contains( Offset_to_Cube( layout, OffsetHex( 0, -1 ) ) ), "HexMapShape Rectangle row" );
+    }
+
+    const HexMapShape hexagon = HexMapShape::Hexagon( Hex( 2, -1 ), 3 );
+    AssertEqual( hexagon.Size(), 37U, "HexMapShape Hexagon size" );
+    AssertEqual( hexagon.QMin(), -1, "HexMapShape Hexagon QMin" );
+    AssertEqual( hexagon.RMax(), 2, "HexMapShape Hexagon RMax" );
+
+    for ( int q = -5; q <= 9; ++q ) {
+        for ( int r = -8; r <= 6; ++r ) {
+            AssertEqual( hexagon.Contains( Hex( q, r ) ), HexDistance( Hex( q, r ), Hex( 2, -1 ) ) <= 3, "HexMapShape Hexagon contains" );
+        }
+    }
+
+    const HexMapShape rhombus = HexMapShape::Rhombus( Hex( -3, 4 ), 6, 2 );
+    AssertEqual( rhombus.Index( Hex( -1, 5 ) ), 8U, "HexMapShape Rhombus index" );
+
+    for ( const HexMapShape& shape : { hexagon, rhombus } ) {
+        for ( size_t index = 0; index != shape.Size(); ++index ) {
+            AssertEqual( shape.Index( shape.HexAt( index ) ), index, "HexMapShape HexAt" );
+        }
+    }
+
+    // Карта без строк
+    const HexMapShape empty = HexMapShape::Rhombus( Hex( 3, 5 ), 0, 0 );
+    AssertEqual( empty.Size(), 0U, "HexMapShape empty size" );
+    Assert( empty.QMin() > empty.QMax(), "HexMapShape empty Q bounds" );
+    Assert( empty.RMin() > empty.RMax(), "HexMapShape empty R bounds" );
+    Assert( !empty.Contains( Hex( 3, 5 ) ), "HexMapShape empty contains" );
+}
+
+void Test_HexMap() {
+    HexMap<int> map( HexMapShape::Hexagon( Hex( 0, 0 ), 2 ), 1 );
+    AssertEqual( map.Size(), 19U, "HexMap size" );
+
+    size_t index = 0;
+
+    for ( auto cell : map ) {
+        AssertEqual( map.Index( cell.hex ), index++, "HexMap iteration order" );
+        cell.value = HexDistance( cell.hex, Hex( 0, 0 ) );
+    }
+
+    AssertEqual( index, map.Size(), "HexMap iteration count" );
+    AssertEqual( map[ Hex( 1, -2 ) ], 2, "HexMap operator[]" );
+    AssertEqual( *map.Neighbor( Hex( 1, -2 ), 3 ), 2, "HexMap Neighbor" );
+    Assert( map.Neighbor( Hex( 1, -2 ), 1 ) == nullptr, "HexMap Neighbor outside" );
+
+    int sum = 0, count = 0;
+    map.ForEachNeighbor( Hex( 2, 0 ), [&]( const Hex&, int& value ) { sum += value; ++count; } );
+    AssertEqual( count, 3, "HexMap ForEachNeighbor count" );
+    AssertEqual( sum, 5, "HexMap ForEachNeighbor sum" );
+
+    bool thrown = false;
+
+    try {
+        map.At( Hex( 3, 0 ) );
+    } catch ( std::out_of_range& ) {
+        thrown = true;
+    }
+
+    Assert( thrown, "HexMap At outside" );
+}
+
+void Test_HexMapFile() {
+    const string path = "Test_HexMapFile.hexmap";
+    const HexLayout flat( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 2.0, 3.0 ), Point( -5.0, 7.5 ) );
+    const HexLayout pointy( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 1.0, 1.0 ), Point( 0.0, 0.0 ) );
+
+    // Запись и чтение на месте для разных форм и порядков хранения
+    for ( const HexMapShape& shape : { HexMapShape::Rectangle( flat, 31, 17 ), HexMapShape::Hexagon( Hex( -3, 7 ), 12 ),
+                                       HexMapShape::Rhombus( Hex( 5, -9 ), 20, 13 ).WithOrder( HEX_MAP_ORDER_MORTON ) } ) {
+        HexMap<uint32_t> map( shape );
+
+        for ( auto cell : map ) {
+            cell.value = static_cast<uint32_t>( cell.hex.Q() * 1000 + cell.hex.R() );
+        }
+
+        HexMapFileSave( path, flat, map, 0x52313233 );
+        AssertEqual( static_cast<int>( HexMapFileValidate( path ) ), static_cast<int>( HEX_MAP_FILE_OK ), "HexMapFileValidate" );
+
+        const HexMapFileView<uint32_t> view( path, 0x52313233 );
+        AssertEqual( view.Size(), map.Size(), "HexMapFileView Size" );
+        AssertEqual( view.Shape().Rows(), shape.Rows(), "HexMapFileView Rows" );
+        AssertEqual( static_cast<int>( view.Shape().Order() ), static_cast<int>( shape.Order() ), "HexMapFileView Order" );
+        AssertEqual( static_cast<int>( view.Layout().orientation ), static_cast<int>( HEX_ORIENTATION_FLAT ), "HexMapFileView orientation" );
+        AssertEqual( static_cast<int>( view.Layout().offset_type ), static_cast<int>( OFFSET_TYPE_EVEN ), "HexMapFileView offset_type" );
+        Assert( view.Layout().size == flat.size && view.Layout().origin == flat.origin, "HexMapFileView layout" );
+        AssertEqual( reinterpret_cast<uintptr_t>( view.Data() ) % HEX_MAP_FILE_ALIGN, uintptr_t( 0 ), "HexMapFileView alignment" );
+        Assert( std::equal( map.Data(), map.Data() + map.Size(), view.Data() ), "HexMapFileView data" );
+
+        size_t count = 0;
+
+        for ( auto cell : view ) {
+            AssertEqual( cell.value, map[ cell.hex ], "HexMapFileView iteration" );
+            AssertEqual( view[ cell.hex ], map[ cell.hex ], "HexMapFileView []" );
+            ++count;
+        }
+
+        AssertEqual( count, map.Size(), "HexMapFileView iteration count" );
+        Assert( view.Find( Hex( 1000, 1000 ) ) == nullptr, "HexMapFileView Find outside" );
+    }
+
+    // Потоковая запись по одной ячейке
+    const HexMapShape shape = HexMapShape::Rectangle( pointy, 40, 25 );
+    {
+        HexMapFileWriter<float> writer( path, pointy, shape );
+
+        for ( size_t index = 0; index != shape.Size(); ++index ) {
+            writer.Write( static_cast<float>( index ) * 0.5f );
+        }
+
+        AssertEqual( writer.Written(), shape.Size(), "HexMapFileWriter Written" );
+        writer.Finish();
+    }
+
+    {
+        const HexMapFileView<float> view( path );
+        AssertEqual( view.Cell( 999 ), 499.5f, "HexMapFileWriter cell" );
+        AssertEqual( view.At( shape.HexAt( 10 ) ), 5.0f, "HexMapFileView At" );
+    }
+
+    // Неверный тип ячеек
+    bool thrown = false;
+
+    try {
+        HexMapFileView<double> view( path );
+    } catch ( const std::runtime_error& ) {
+        thrown = true;
+    }
+
+    Assert( thrown, "HexMapFileView cell type" );
+    AssertEqual( static_cast<int>( HexMapFileValidate( path, sizeof( double ), alignof( double ) ) ),
+                 static_cast<int>( HEX_MAP_FILE_BAD_CELL_TYPE ), "HexMapFileValidate cell type" );
+
+    // Повреждённые данные обнаруживает только полная проверка
+    FILE* file = fopen( path.c_str(), "r+b" );
+    fseek( file, -3, SEEK_END );
+    fputc( 0x5a, file );
+    fclose( file );
+
+    AssertEqual( static_cast<int>( HexMapFileValidate( path ) ), static_cast<int>( HEX_MAP_FILE_BAD_CHECKSUM ), "HexMapFileValidate checksum" );
+    AssertEqual( HexMapFileView<float>( path ).Size(), shape.Size(), "HexMapFileView without checksum" );
+
+    // Недописанный файл и лишние ячейки
+    {
+        HexMapFileWriter<float> writer( path, pointy, shape );
+        writer.Write( 1.0f );
+        thrown = false;
+
+        try {
+            writer.Finish();
+        } catch ( const std::runtime_error& ) {
+            thrown = true;
+        }
+
+        Assert( thrown, "HexMapFileWriter Finish incomplete" );
+    }
+
+    AssertEqual( static_cast<int>( HexMapFileValidate( path ) ), static_cast<int>( HEX_MAP_FILE_BAD_MAGIC ), "HexMapFileValidate incomplete" );
+
+    {
+        HexMapFileWriter<float> writer( path, pointy, HexMapShape::Hexagon( Hex( 0, 0 ), 1 ) );
+        const float values[ 8 ] = {};
+        thrown = false;
+
+        try {
+            writer.Write( values, 8 );
+        } catch ( const std::runtime_error& ) {
+            thrown = true;
+        }
+
+        Assert( thrown, "HexMapFileWriter too many cells" );
+    }
+
+    // Усечённый файл
+    {
+        HexMap<float> map( shape, 1.0f );
+        HexMapFileSave( path, pointy, map );
+        std::ifstream input( path, std::ios::binary );
+        const string bytes( ( std::istreambuf_iterator<char>( input ) ), std::istreambuf_iterator<char>() );
+        input.close();
+        std::ofstream output( path, std::ios::binary | std::ios::trunc );
+        output.write( bytes.data(), static_cast<std::streamsize>( bytes.size() - 4 ) );
+    }
+
+    AssertEqual( static_cast<int>( HexMapFileValidate( path ) ), static_cast<int>( HEX_MAP_FILE_TRUNCATED ), "HexMapFileValidate truncated" );
+    AssertEqual( static_cast<int>( HexMapFileValidate( path + ".missing" ) ), static_cast<int>( HEX_MAP_FILE_IO_ERROR ), "HexMapFileValidate missing" );
+    std::remove( path.c_str() );
+}
+
+void Test_HexKey() {
+    constexpr int min = std::numeric_limits<int>::min();
+    constexpr int max = std::numeric_limits<int>::max();
+    static_assert( HexUnpack( HexPack( Hex( -5, 7 ) ) ) == Hex( -5, 7 ), "constexpr HexPack" );
+
+    const vector<Hex> hexes = { Hex( 0, 0 ), Hex( 5, -3 ), Hex( -1, -1 ), Hex( -1, 0 ), Hex( 0, -1 ), Hex( 123456, -654321 ),
+                                Hex( min + 1, max ), Hex( max, min + 1 ), Hex( max, -max ), Hex( -max, 0 ) };
+
+    for ( const Hex& hex : hexes ) {
+        AssertEqual( HexUnpack( HexPack( hex ) ), hex, "HexUnpack( HexPack )" );
+    }
+
+    // Порядок ключей совпадает с operator <
+    for ( const Hex& a : hexes ) {
+        for ( const Hex& b : hexes ) {
+            AssertEqual( HexPack( a ) < HexPack( b ), a < b, "HexPack order" );
+            AssertEqual( a < b || b < a, a != b, "Hex operator < strict" );
+        }
+    }
+
+    // 32-битный ключ
+    for ( const Hex& hex : { Hex( 0, 0 ), Hex( -32768, 32767 ), Hex( 32767, -32768 ), Hex( -1, 1 ) } ) {
+        Assert( HexFitsPack32( hex ), "HexFitsPack32" );
+        AssertEqual( HexUnpack32( HexPack32( hex ) ), hex, "HexUnpack32( HexPack32 )" );
+    }
+
+    Assert( !HexFitsPack32( Hex( 32768, 0 ) ) && !HexFitsPack32( Hex( 0, -32769 ) ), "HexFitsPack32 range" );
+    Assert( HexPack32( Hex( -1, 5 ) ) < HexPack32( Hex( 0, -5 ) ), "HexPack32 order" );
+
+    // std::hash и упорядоченные контейнеры
+    std::unordered_set<Hex> hash_set;
+    std::set<Hex> tree_set;
+
+    for ( const Hex& hex : HexRange( Hex( 0, 0 ), 20 ) ) {
+        hash_set.insert( hex );
+        tree_set.insert( hex );
+    }
+
+    AssertEqual( hash_set.size(), tree_set.size(), "unordered_set<Hex> size" );
+    Assert( hash_set.count( Hex( 20, -20 ) ) == 1 && hash_set.count( Hex( 21, -20 ) ) == 0, "unordered_set<Hex> find" );
+    AssertEqual( *tree_set.begin(), Hex( -20, 0 ), "set<Hex> begin" );
+
+    // Младшие биты хеша равномерны для плотной области
+    const size_t buckets = 256;
+    vector<size_t> counts( buckets, 0 );
+    size_t total = 0;
+
+    for ( int q = -64; q < 64; ++q ) {
+        for ( int r = -64; r < 64; ++r ) {
+            ++counts[ HexHash()( Hex( q, r ) ) & ( buckets - 1 ) ];
+            ++total;
+        }
+    }
+
+    const size_t expected = total / buckets;
+    Assert( *std::max_element( counts.begin(), counts.end() ) < expected * 3 / 2, "HexHash distribution max" );
+    Assert( *std::min_element( counts.begin(), counts.end() ) > expected / 2, "HexHash distribution min" );
+    AssertEqual( HexKeyHash()( HexPack( Hex( 3, 4 ) ) ), HexHash()( Hex( 3, 4 ) ), "HexKeyHash" );
+    AssertEqual( std::hash<Hex>()( Hex( 3, 4 ) ), HexHash()( Hex( 3, 4 ) ), "std::hash<Hex>" );
+}
+
+void Test_HexMorton() {
+    for ( const Hex& hex : { Hex( 0, 0 ), Hex( 5, -3 ), Hex( -1, -1 ), Hex( 123456, -654321 ),
+                             Hex( std::numeric_limits<int>::min() + 1, std::numeric_limits<int>::max() ) } ) {
+        AssertEqual( HexMortonDecode( HexMortonEncode( hex ) ), hex, "HexMortonDecode( HexMortonEncode )" );
+    }
+
+    // Квадрат 2x2 по Q и R - четыре подряд идущих кода
+    AssertEqual( HexMortonEncode( Hex( 1, 0 ) ), HexMortonEncode( Hex( 0, 0 ) ) + 1, "HexMortonEncode Q" );
+    AssertEqual( HexMortonEncode( Hex( 0, 1 ) ), HexMortonEncode( Hex( 0, 0 ) ) + 2, "HexMortonEncode R" );
+    AssertEqual( HexMortonEncode( Hex( 1, 1 ) ), HexMortonEncode( Hex( 0, 0 ) ) + 3, "HexMortonEncode QR" );
+    Assert( HexMortonEncode( Hex( -1, 0 ) ) < HexMortonEncode( Hex( 0, 0 ) ), "HexMortonEncode negative" );
+
+    // k-й единичный бит совпадает с последовательным перебором битов
+    uint64_t bits_seed = 7;
+
+    for ( int round = 0; round != 2000; ++round ) {
+        bits_seed = bits_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        const uint64_t value = ( round == 0 ? ~uint64_t( 0 ) : bits_seed & ( bits_seed >> ( round % 29 ) ) );
+        AssertEqual( HexPopCount( value ), static_cast<int>( std::bitset<64>( value ).count() ), "HexPopCount" );
+        int k = 0;
+
+        for ( int bit = 0; bit != 64; ++bit ) {
+            if ( ( value >> bit ) & 1 ) {
+                AssertEqual( HexSelectBit( value, k++ ), bit, "HexSelectBit" );
+            }
+        }
+    }
+
+    // Порядок хранения по коду Мортона для разных форм
+    const HexLayout layout( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 1.0, 1.0 ), Point( 0.0, 0.0 ) );
+
+    for ( const HexMapShape& rows : { HexMapShape::Hexagon( Hex( -3, 7 ), 20 ),
+                                      HexMapShape::Rhombus( Hex( -9, -17 ), 37, 11 ),
+                                      HexMapShape::Rectangle( layout, 30, 21 ) } ) {
+        const HexMapShape morton = rows.WithOrder( HEX_MAP_ORDER_MORTON );
+        AssertEqual( morton.Size(), rows.Size(), "HexMapShape Morton Size" );
+        AssertEqual( static_cast<int>( morton.Order() ), static_cast<int>( HEX_MAP_ORDER_MORTON ), "HexMapShape Order" );
+
+        vector<uint64_t> codes;
+        vector<bool> used( rows.Size(), false );
+
+        for ( size_t i = 0; i != rows.Size(); ++i ) {
+            const Hex hex = rows.HexAt( i );
+            const size_t index = morton.Index( hex );
+            Assert( index < morton.Size() && !used[ index ], "HexMapShape Morton Index unique" );
+            used[ index ] = true;
+            AssertEqual( morton.HexAt( index ), hex, "HexMapShape Morton HexAt" );
+        }
+
+        // Обход в порядке хранения, коды Мортона возрастают
+        HexMap<int> map( morton, 0 );
+        size_t index = 0;
+
+        for ( auto cell : map ) {
+            AssertEqual( map.Index( cell.hex ), index++, "HexMap Morton iteration order" );
+            codes.push_back( HexMortonEncode( cell.hex ) );
+            cell.value = 1;
+        }
+
+        AssertEqual( index, map.Size(), "HexMap Morton iteration count" );
+        Assert( std::is_sorted( codes.begin(), codes.end() ), "HexMap Morton order" );
+        Assert( std::all_of( map.Data(), map.Data() + map.Size(), []( int value ) { return value == 1; } ), "HexMap Morton cells" );
+        AssertEqual( morton.WithOrder( HEX_MAP_ORDER_ROWS ).Index( rows.HexAt( 5 ) ), 5U, "HexMapShape WithOrder rows" );
+    }
+
+    // Поиск пути и поле движения не зависят от порядка хранения
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), 40, 30 );
+    const HexMapShape morton = shape.WithOrder( HEX_MAP_ORDER_MORTON );
+    HexMap<float> costs( shape, 1.0f );
+    HexMap<float> morton_costs( morton, 1.0f );
+    unsigned seed = 3;
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned value = ( seed >> 8 ) % 8;
+        costs.Cell( i ) = ( value < 2 ? HEX_PATH_BLOCKED : 1.0f + value % 3 );
+        morton_costs[ shape.HexAt( i ) ] = costs.Cell( i );
+    }
+
+    HexPathfinder pathfinder( shape );
+    HexPathfinder morton_pathfinder( morton );
+    vector<Hex> path;
+
+    for ( int query = 0; query != 20; ++query ) {
+        seed = seed * 1103515245U + 12345U;
+        const Hex start = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+        seed = seed * 1103515245U + 12345U;
+        const Hex goal = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+        const HexPathStats stats = pathfinder.FindPath( start, goal, costs, path );
+        const HexPathStats morton_stats = morton_pathfinder.FindPath( start, goal, morton_costs, path );
+        AssertEqual( morton_stats.found, stats.found, "HexPathfinder Morton found" );
+        AssertEqual( morton_stats.cost, stats.cost, "HexPathfinder Morton cost" );
+    }
+
+    HexFlowField field( shape );
+    HexFlowField morton_field( morton );
+    field.Compute( { Hex( 20, 15 ) }, costs );
+    morton_field.Compute( { Hex( 20, 15 ) }, morton_costs );
+
+    for ( size_t i = 0; i != shape.Size(); ++i ) {
+        AssertEqual( morton_field.Distance( shape.HexAt( i ) ), field.Distance( shape.HexAt( i ) ), "HexFlowField Morton Distance" );
+        AssertEqual( morton_field.Direction( shape.HexAt( i ) ), field.Direction( shape.HexAt( i ) ), "HexFlowField Morton Direction" );
+    }
+}
+
+void Test_HexChunkMap() {
+    typedef HexChunkMap<int, 2> ChunkMap;
+    ChunkMap map( -1 );
+    AssertEqual( ChunkMap::ChunkOrigin( Hex( -1, 5 ) ), Hex( -4, 4 ), "HexChunkMap ChunkOrigin" );
+    Assert( map.Find( Hex( 100, -100 ) ) == nullptr, "HexChunkMap Find missing" );
+    AssertEqual( map.Get( Hex( 100, -100 ) ), -1, "HexChunkMap Get missing" );
+
+    // Разреженные гексы во всех квадрантах (с перестройкой хеш-таблицы)
+    vector<Hex> hexes;
+
+    for ( int i = -50; i <= 50; ++i ) {
+        hexes.push_back( Hex( i * 37, -i * 11 + 3 ) );
+        hexes.push_back( Hex( -i * 1001, i * 7 ) );
+    }
+
+    for ( size_t i = 0; i != hexes.size(); ++i ) {
+        map[ hexes[ i ] ] = i;
+    }
+
+    for ( size_t i = 0; i != hexes.size(); ++i ) {
+        AssertEqual( map.Get( hexes[ i ] ), static_cast<int>( i ), "HexChunkMap Get" );
+    }
+
+    // Соседи на границе чанков
+    ChunkMap border( 0 );
+    border[ Hex( 4, 0 ) ] = 20;
+    border[ Hex( 3, 1 ) ] = 30;
+    border[ Hex( 2, 0 ) ] = 40;
+    int sum = 0, count = 0;
+    border.ForEachNeighbor( Hex( 3, 0 ), [&]( const Hex&, int value ) { sum += value; ++count; } );
+    AssertEqual( sum, 90, "HexChunkMap ForEachNeighbor sum" );
+    AssertEqual( count, 4, "HexChunkMap ForEachNeighbor count" );
+    AssertEqual( *border.Neighbor( Hex( 3, 0 ), 0 ), 20, "HexChunkMap Neighbor" );
+
+    // Вытеснение чанков
+    size_t evicted_cells = 0;
+    map.SetEvictionCallback( [&evicted_cells]( const Hex& origin, int* cells ) {
+        for ( size_t i = 0; i != ChunkMap::CHUNK_SIZE; ++i ) {
+            if ( cells[ i ] >= 0 ) {
+                AssertEqual( ChunkMap::ChunkOrigin( ChunkMap::ChunkCellHex( origin, i ) ), origin, "HexChunkMap ChunkCellHex" );
+                ++evicted_cells;
+            }
+        }
+    } );
+
+    const size_t chunks = map.ChunkCount();
+    const size_t memory = map.MemoryUsage();
+    Assert( map.EvictChunk( hexes[ 0 ] ), "HexChunkMap EvictChunk" );
+    Assert( !map.HasChunk( hexes[ 0 ] ), "HexChunkMap HasChunk" );
+    AssertEqual( map.ChunkCount(), chunks - 1, "HexChunkMap ChunkCount" );
+    Assert( map.MemoryUsage() < memory, "HexChunkMap MemoryUsage" );
+    AssertEqual( evicted_cells, 1U, "HexChunkMap EvictChunk callback" );
+
+    // Все гексы, кроме hexes[ 0 ], лежат в разных чанках
+    const size_t evicted = map.EvictChunks( []( const Hex& origin, int* ) { return origin.Q() >= 1000; } );
+    size_t far = 0;
+
+    for ( size_t i = 1; i != hexes.size(); ++i ) {
+        far += ( hexes[ i ].Q() >= 1000 );
+        AssertEqual( map.HasChunk( hexes[ i ] ), hexes[ i ].Q() < 1000, "HexChunkMap EvictChunks remaining" );
+    }
+
+    AssertEqual( evicted, far, "HexChunkMap EvictChunks" );
+
+    map.Clear();
+    AssertEqual( map.ChunkCount(), 0U, "HexChunkMap Clear" );
+    AssertEqual( evicted_cells, hexes.size(), "HexChunkMap Clear callback" );
+}
+
+void Test_HexRange() {
+    const Hex center( 3, -5 );
+
+    for ( int radius = 0; radius <= 6; ++radius ) {
+        // Диапазон
+        vector<Hex> range( HexRange( center, radius ).begin(), HexRange( center, radius ).end() );
+        AssertEqual( range.size(), HexRangeSize( radius ), "HexRange size" );
+        vector<Hex> buffer( HexRangeSize( radius ) );
+        AssertEqual( HexRange( center, radius ).CopyTo( buffer.data() ), range.size(), "HexRange CopyTo size" );
+        AssertEqual( buffer, range, "HexRange CopyTo" );
+        HexMap<int> seen( HexMapShape::Hexagon( center, radius ), 0 );
+
+        for ( const Hex& hex : range ) {
+            Assert( seen.Contains( hex ) && seen[ hex ]++ == 0, "HexRange unique" );
+        }
+
+        // Кольцо
+        vector<Hex> ring;
+
+        for ( const Hex& hex : HexRing( center, radius ) ) {
+            AssertEqual( HexDistance( hex, center ), static_cast<unsigned>( radius ), "HexRing distance" );
+            Assert( ring.empty() || HexDistance( ring.back(), hex ) == 1, "HexRing adjacent" );
+            ring.push_back( hex );
+        }
+
+        AssertEqual( ring.size(), HexRingSize( radius ), "HexRing size" );
+        buffer.assign( HexRingSize( radius ), Hex() );
+        HexRing( center, radius ).CopyTo( buffer.data() );
+        AssertEqual( buffer, ring, "HexRing CopyTo" );
+
+        // Спираль
+        vector<Hex> spiral( HexSpiral( center, radius ).begin(), HexSpiral( center, radius ).end() );
+        vector<Hex> rings;
+
+        for ( int ring_radius = 0; ring_radius <= radius; ++ring_radius ) {
+            rings.insert( rings.end(), HexRing( center, ring_radius ).begin(), HexRing( center, ring_radius ).end() );
+        }
+
+        AssertEqual( spiral, rings, "HexSpiral" );
+        buffer.assign( HexRangeSize( radius ), Hex() );
+        HexSpiral( center, radius ).CopyTo( buffer.data() );
+        AssertEqual( buffer, spiral, "HexSpiral CopyTo" );
+
+        // Стандартные алгоритмы и постфиксный инкремент
+        const HexSpiral spiral_range( center, radius );
+        AssertEqual( static_cast<size_t>( std::distance( spiral_range.begin(), spiral_range.end() ) ), spiral.size(),
+                     "HexSpiral distance" );
+        AssertEqual( *std::next( spiral_range.begin(), spiral.size() - 1 ), spiral.back(), "HexSpiral next" );
+        AssertEqual( static_cast<size_t>( std::distance( HexRange( center, radius ).begin(), HexRange( center, radius ).end() ) ),
+                     range.size(), "HexRange distance" );
+        AssertEqual( *std::next( HexRing( center, radius ).begin(), ring.size() - 1 ), ring.back(), "HexRing next" );
+        vector<Hex> postfix;
+
+        for ( auto it = HexRange( center, radius ).begin(), end = HexRange( center, radius ).end(); it != end; ) {
+            postfix.push_back( *it++ );
+        }
+
+        AssertEqual( postfix, range, "HexRange postfix" );
+        postfix.clear();
+
+        for ( auto it = HexRing( center, radius ).begin(), end = HexRing( center, radius ).end(); it != end; ) {
+            postfix.push_back( *it++ );
+        }
+
+        AssertEqual( postfix, ring, "HexRing postfix" );
+        postfix.clear();
+
+        for ( auto it = spiral_range.begin(); it != spiral_range.end(); ) {
+            postfix.push_back( *it++ );
+        }
+
+        AssertEqual( postfix, spiral, "HexSpiral postfix" );
+    }
+
+    static_assert( std::is_same<std::iterator_traits<HexRange::Iterator>::iterator_category, std::input_iterator_tag>::value,
+                   "HexRange iterator category" );
+}
+
+// Проверка пути: соседние проходимые ячейки от start до goal, стоимость совпадает
+void AssertHexPath( const vector<Hex>& path, const Hex& start, const Hex& goal, const HexMap<float>& costs,
+                    const HexPathStats& stats, const string& hint ) {
+    Assert( stats.found, hint + " found" );
+    AssertEqual( path.front(), start, hint + " start" );
+    AssertEqual( path.back(), goal, hint + " goal" );
+    float cost = 0.0f;
+
+    for ( size_t i = 1; i < path.size(); ++i ) {
+        AssertEqual( HexDistance( path[ i - 1 ], path[ i ] ), 1U, hint + " adjacent" );
+        Assert( costs.Contains( path[ i ] ) && costs[ path[ i ] ] < HEX_PATH_BLOCKED, hint + " passable" );
+        cost += costs[ path[ i ] ];
+    }
+
+    AssertEqual( cost, stats.cost, hint + " cost" );
+}
+
+void Test_HexPathfinder() {
+    const HexPathAlgorithm_t algorithms[] = { HEX_PATH_ASTAR, HEX_PATH_DIJKSTRA,
+                                              HEX_PATH_BIDIRECTIONAL_ASTAR, HEX_PATH_BIDIRECTIONAL_DIJKSTRA };
+
+    // Стена с одним проходом
+    HexMap<float> costs( HexMapShape::Hexagon( Hex( 0, 0 ), 5 ), 1.0f );
+
+    for ( int r = -5; r <= 4; ++r ) {
+        if ( costs.Contains( Hex( 0, r ) ) ) {
+            costs[ Hex( 0, r ) ] = HEX_PATH_BLOCKED;
+        }
+    }
+
+    HexPathfinder pathfinder( costs.Shape() );
+    vector<Hex> path;
+
+    for ( HexPathAlgorithm_t algorithm : algorithms ) {
+        const string hint = "HexPathfinder algorithm " + std::to_string( algorithm );
+
+        HexPathStats stats = pathfinder.FindPath( Hex( -3, 0 ), Hex( 3, 0 ), costs, path, algorithm );
+        AssertHexPath( path, Hex( -3, 0 ), Hex( 3, 0 ), costs, stats, hint );
+        AssertEqual( stats.cost, 13.0f, hint + " cost around wall" );
+        Assert( stats.nodes_expanded > 0, hint + " nodes expanded" );
+
+        // Начальная ячейка может быть непроходимой, её стоимость не учитывается
+        stats = pathfinder.FindPath( Hex( 0, 0 ), Hex( 1, 0 ), costs, path, algorithm );
+        AssertHexPath( path, Hex( 0, 0 ), Hex( 1, 0 ), costs, stats, hint + " from blocked" );
+        AssertEqual( stats.cost, 1.0f, hint + " from blocked cost" );
+
+        stats = pathfinder.FindPath( Hex( 2, 1 ), Hex( 2, 1 ), costs, path, algorithm );
+        Assert( stats.found && stats.cost == 0.0f && path == vector<Hex>{ Hex( 2, 1 ) }, hint + " start == goal" );
+
+        stats = pathfinder.FindPath( Hex( -3, 0 ), Hex( 0, 0 ), costs, path, algorithm );
+        Assert( !stats.found && path.empty(), hint + " blocked goal" );
+
+        stats = pathfinder.FindPath( Hex( -3, 0 ), Hex( 9, 0 ), costs, path, algorithm );
+        Assert( !stats.found && path.empty(), hint + " goal out of map" );
+    }
+
+    // Проход закрыт: пути нет
+    costs[ Hex( 0, 5 ) ] = HEX_PATH_BLOCKED;
+
+    for ( HexPathAlgorithm_t algorithm : algorithms ) {
+        const HexPathStats stats = pathfinder.FindPath( Hex( -3, 0 ), Hex( 3, 0 ), costs, path, algorithm );
+        Assert( !stats.found && path.empty(), "HexPathfinder unreachable " + std::to_string( algorithm ) );
+    }
+
+    // Пользовательская функция стоимости
+    const HexPathStats stats = pathfinder.FindPath( Hex( -3, 0 ), Hex( 3, 0 ),
+        []( const Hex& hex, size_t ) { return ( hex.R() == 0 ? 1.0f : 2.0f ); }, path );
+    AssertEqual( stats.cost, 6.0f, "HexPathfinder cost function" );
+
+    // Случайные карты: все алгоритмы находят пути одинаковой стоимости
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( -10, -10 ), 24, 20 );
+    HexMap<float> terrain( shape, 1.0f );
+    HexPathfinder random_pathfinder( shape );
+    unsigned seed = 7;
+
+    for ( int map = 0; map != 20; ++map ) {
+        for ( size_t i = 0; i != terrain.Size(); ++i ) {
+            seed = seed * 1103515245U + 12345U;
+            const unsigned value = ( seed >> 16 ) % 10;
+            terrain.Cell( i ) = ( value < 3 ? HEX_PATH_BLOCKED : 1.0f + value % 3 );
+        }
+
+        for ( int query = 0; query != 10; ++query ) {
+            seed = seed * 1103515245U + 12345U;
+            const Hex start = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+            seed = seed * 1103515245U + 12345U;
+            const Hex goal = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+
+            const HexPathStats reference = random_pathfinder.FindPath( start, goal, terrain, path, HEX_PATH_DIJKSTRA );
+
+            for ( HexPathAlgorithm_t algorithm : algorithms ) {
+                const string hint = "HexPathfinder random " + std::to_string( algorithm );
+                const HexPathStats stats = random_pathfinder.FindPath( start, goal, terrain, path, algorithm );
+                AssertEqual( stats.found, reference.found, hint + " found" );
+
+                if ( reference.found ) {
+                    AssertHexPath( path, start, goal, terrain, stats, hint );
+                    AssertEqual( stats.cost, reference.cost, hint + " optimal" );
+                }
+            }
+        }
+    }
+}
+
+void Test_HexProfile() {
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10, 15 ), Point( 35, 71 ) );
+    HexProfileReset();
+
+    const vector<Hex> line = HexLine( Hex( 0, 0 ), Hex( 4, -2 ), false, 0, HEX_ROUND_Q );
+    PixelToHex( layout, Point( 3, 4 ) ).Round( HEX_ROUND_Q );
+    Hex( 1, 2 ).HexCorners( layout );
+
+    // Счётчики потоков, которые уже завершились, сохраняются
+    std::thread thread( [] { Hex( 0, 0 ).HexNeighbors(); } );
+    thread.join();
+
+    const string json = HexProfileJSON();
+    Assert( json.find( "\"name\": \"HexLine\"" ) != string::npos, "HexProfileJSON HexLine" );
+    AssertEqual( string( HexProfilePointName( HEX_PROFILE_ROUND ) ), string( "FractionalHex::Round" ), "HexProfilePointName" );
+
+    if ( !HexProfileEnabled() ) {
+        AssertEqual( HexProfileGet( HEX_PROFILE_HEX_LINE ).calls, 0U, "HexProfile disabled" );
+        Assert( json.find( "\"enabled\": false" ) != string::npos, "HexProfileJSON disabled" );
+        return;
+    }
+
+    Assert( json.find( "\"enabled\": true" ) != string::npos, "HexProfileJSON enabled" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_LINE ).calls, 1U, "HexProfile HexLine calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_ROUND ).calls, line.size() + 1, "HexProfile Round calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_PIXEL_TO_HEX ).calls, 1U, "HexProfile PixelToHex calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_CORNERS ).calls, 1U, "HexProfile HexCorners calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_TO_PIXEL ).calls, 1U, "HexProfile HexToPixel calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_NEIGHBORS ).calls, 1U, "HexProfile other thread" );
+
+    // Время HexLine включает вложенные округления
+    Assert( HexProfileGet( HEX_PROFILE_HEX_LINE ).nanoseconds >= HexProfileGet( HEX_PROFILE_ROUND ).nanoseconds / 2, "HexProfile time" );
+
+    // Выделения памяти сообщает приложение
+    {
+        HEX_PROFILE_SCOPE( HEX_PROFILE_HEX_DIAGONALS );
+        HexProfileAllocation();
+        HexProfileAllocation();
+    }
+
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_DIAGONALS ).allocations, 2U, "HexProfile allocations" );
+
+    HexProfileReset();
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_LINE ).calls, 0U, "HexProfileReset" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_NEIGHBORS ).calls, 0U, "HexProfileReset other thread" );
+
+    // Регистрация счётчиков новых потоков (выделяет память) не учитывается
+    // в их первом замере; потоки работают одновременно, чтобы список
+    // счётчиков потоков вырос
+    const unsigned fresh_count = 32;
+    std::atomic<unsigned> fresh_done( 0 );
+    vector<std::thread> fresh;
+
+    for ( unsigned i = 0; i != fresh_count; ++i ) {
+        fresh.emplace_back( [&fresh_done, fresh_count] {
+            Hex out[ HEX_DIRECTION_COUNT ];
+            Hex( 1, 2 ).HexNeighbors( out );
+            ++fresh_done;
+
+            while ( fresh_done.load() != fresh_count ) {
+                std::this_thread::yield();
+            }
+        } );
+    }
+
+    for ( std::thread& thread : fresh ) {
+        thread.join();
+    }
+
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_NEIGHBORS ).calls, uint64_t( fresh_count ), "HexProfile new thread calls" );
+    AssertEqual( HexProfileGet( HEX_PROFILE_HEX_NEIGHBORS ).allocations, 0U, "HexProfile new thread allocations" );
+}
+
+void Test_HexThreadPool() {
+    for ( unsigned threads : { 1U, 2U, 3U, 8U } ) {
+        HexThreadPool pool( threads );
+        AssertEqual( pool.ThreadCount(), threads, "HexThreadPool ThreadCount" );
+
+        for ( size_t grain : { 1U, 7U, 1000U } ) {
+            for ( size_t count : { 0U, 1U, 5U, 1000U } ) {
+                // Каждый индекс обрабатывается ровно один раз
+                vector<std::atomic<int>> visits( count );
+                std::atomic<bool> valid_thread( true );
+
+                pool.ParallelFor( count, [&]( size_t index, unsigned thread ) {
+                    ++visits[ index ];
+                    valid_thread = valid_thread && thread < threads;
+                }, grain );
+
+                for ( size_t index = 0; index != count; ++index ) {
+                    AssertEqual( visits[ index ].load(), 1, "HexThreadPool ParallelFor " + std::to_string( count ) );
+                }
+
+                Assert( valid_thread, "HexThreadPool thread" );
+            }
+        }
+    }
+}
+
+void Test_HexPathBatch() {
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( 0, 0 ), 32, 32 );
+    HexMap<float> costs( shape, 1.0f );
+    unsigned seed = 11;
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        costs.Cell( i ) = ( ( seed >> 16 ) % 4 == 0 ? HEX_PATH_BLOCKED : 1.0f + ( seed >> 20 ) % 3 );
+    }
+
+    vector<HexPathQuery> queries;
+
+    for ( int i = 0; i != 100; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const Hex start = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+        seed = seed * 1103515245U + 12345U;
+        queries.push_back( { start, shape.HexAt( ( seed >> 8 ) % shape.Size() ) } );
+    }
+
+    // Результаты в порядке запросов совпадают с последовательным поиском
+    HexPathfinder pathfinder( shape );
+    HexThreadPool pool( 4 );
+    HexPathBatch batch( shape, pool );
+    vector<HexPathResult> results;
+    vector<Hex> path;
+
+    for ( int repeat = 0; repeat != 2; ++repeat ) {
+        batch.Solve( queries, costs, results );
+        AssertEqual( results.size(), queries.size(), "HexPathBatch results size" );
+
+        for ( size_t i = 0; i != queries.size(); ++i ) {
+            const HexPathStats stats = pathfinder.FindPath( queries[ i ].start, queries[ i ].goal, costs, path );
+            AssertEqual( results[ i ].stats.found, stats.found, "HexPathBatch found" );
+            AssertEqual( results[ i ].stats.cost, stats.cost, "HexPathBatch cost" );
+            AssertEqual( results[ i ].path, path, "HexPathBatch path" );
+        }
+    }
+}
+
+void Test_HexFlowField() {
+    const HexMapShape shape = HexMapShape::Hexagon( Hex( 0, 0 ), 12 );
+    HexMap<float> costs( shape, 1.0f );
+    unsigned seed = 3;
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        costs.Cell( i ) = ( ( seed >> 16 ) % 4 == 0 ? HEX_PATH_BLOCKED : 1.0f + ( seed >> 20 ) % 3 );
+    }
+
+    const vector<Hex> goals = { Hex( 0, 0 ), Hex( 7, -3 ), Hex( -5, 9 ), Hex( 20, 0 ) };
+
+    for ( const Hex& goal : goals ) {
+        if ( costs.Contains( goal ) ) {
+            costs[ goal ] = 1.0f;
+        }
+    }
+
+    HexThreadPool pool( 3 );
+    HexFlowField field( shape );
+    HexPathfinder pathfinder( shape );
+    vector<Hex> path;
+
+    // Проверка поля: расстояния равны кратчайшим путям, направления ведут к цели
+    const auto check_field = [&]( const HexFlowField& checked, const string& hint ) {
+        for ( const auto& cell : checked.Distances() ) {
+            float best = HEX_PATH_BLOCKED;
+
+            if ( costs[ cell.hex ] < HEX_PATH_BLOCKED ) {
+                for ( const Hex& goal : goals ) {
+                    if ( costs.Contains( goal ) ) {
+                        best = std::min( best, pathfinder.FindPath( cell.hex, goal, costs, path ).cost );
+                    }
+                }
+            }
+
+            AssertEqual( cell.value, best, hint + " distance" );
+            const Hex next = checked.Next( cell.hex );
+
+            if ( cell.value == 0.0f || !( cell.value < HEX_PATH_BLOCKED ) ) {
+                AssertEqual( checked.Direction( cell.hex ), static_cast<int>( HEX_FLOW_NONE ), hint + " no direction" );
+            } else {
+                AssertEqual( checked.Distance( next ) + costs[ next ], cell.value, hint + " direction" );
+            }
+        }
+    };
+
+    field.Compute( goals, costs );
+    check_field( field, "HexFlowField Compute" );
+
+    HexFlowField parallel_field( shape );
+    parallel_field.Compute( goals, costs, &pool );
+    Assert( std::equal( parallel_field.Distances().Data(), parallel_field.Distances().Data() + shape.Size(),
+                        field.Distances().Data() ), "HexFlowField parallel distances" );
+    Assert( std::equal( parallel_field.Directions().Data(), parallel_field.Directions().Data() + shape.Size(),
+                        field.Directions().Data() ), "HexFlowField parallel directions" );
+
+    // Параллельные волны на большой карте с дробными стоимостями совпадают с алгоритмом Дейкстры
+    const HexMapShape rhombus = HexMapShape::Rhombus( Hex( -20, 5 ), 120, 90 );
+    HexMap<float> fractional( rhombus, 1.0f );
+
+    for ( size_t i = 0; i != fractional.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        fractional.Cell( i ) = ( ( seed >> 16 ) % 5 == 0 ? HEX_PATH_BLOCKED : 0.3f + 0.37f * ( ( seed >> 20 ) % 11 ) );
+    }
+
+    const vector<Hex> rhombus_goals = { rhombus.HexAt( 0 ), rhombus.HexAt( 5000 ), rhombus.HexAt( 9000 ) };
+    HexFlowField sequential( rhombus );
+    sequential.Compute( rhombus_goals, fractional );
+
+    for ( unsigned threads : { 1U, 2U, 4U } ) {
+        HexThreadPool wave_pool( threads );
+        HexFlowField wave_field( rhombus );
+        wave_field.Compute( rhombus_goals, fractional, &wave_pool );
+        const string hint = "HexFlowField waves " + std::to_string( threads ) + " threads";
+        Assert( std::equal( wave_field.Distances().Data(), wave_field.Distances().Data() + rhombus.Size(),
+                            sequential.Distances().Data() ), hint + " distances" );
+        Assert( std::equal( wave_field.Directions().Data(), wave_field.Directions().Data() + rhombus.Size(),
+                            sequential.Directions().Data() ), hint + " directions" );
+    }
+
+    // Пересчёт после изменений совпадает с полным вычислением
+    HexFlowField full( shape );
+
+    for ( int round = 0; round != 30; ++round ) {
+        vector<Hex> changed;
+
+        for ( int i = 0; i != 1 + round % 5; ++i ) {
+            seed = seed * 1103515245U + 12345U;
+            const Hex hex = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+            seed = seed * 1103515245U + 12345U;
+            costs[ hex ] = ( ( seed >> 16 ) % 3 == 0 ? HEX_PATH_BLOCKED : 1.0f + ( seed >> 20 ) % 3 );
+            changed.push_back( hex );
+        }
+
+        field.Update( changed, costs );
+        full.Compute( goals, costs );
+        const string hint = "HexFlowField Update " + std::to_string( round );
+        Assert( std::equal( field.Distances().Data(), field.Distances().Data() + shape.Size(),
+                            full.Distances().Data() ), hint + " distances" );
+        Assert( std::equal( field.Directions().Data(), field.Directions().Data() + shape.Size(),
+                            full.Directions().Data() ), hint + " directions" );
+    }
+
+    check_field( field, "HexFlowField Update" );
+}
+
+void Test_HexLineWalker() {
+    // Полный перебор: те же гексы, что и HexLine, для всех алгоритмов округления
+    for ( const Hex& center : { Hex( 0, 0 ), Hex( 1000, -537 ), Hex( -40000, 12345 ) } ) {
+        for ( const Hex& hex_a : HexRange( center, 6 ) ) {
+            for ( const Hex& hex_b : HexRange( center, 14 ) ) {
+                for ( int round_algorithm = HEX_ROUND_Q; round_algorithm <= HEX_ROUND_S; ++round_algorithm ) {
+                    const vector<Hex> line = HexLine( hex_a, hex_b, false, 0, round_algorithm );
+                    const HexLineWalker walker( hex_a, hex_b, round_algorithm );
+                    AssertEqual( walker.Count() + 1, static_cast<int>( line.size() ), "HexLineWalker Count" );
+                    AssertEqual( vector<Hex>( walker.begin(), walker.end() ), line, "HexLineWalker == HexLine" );
+                }
+            }
+        }
+    }
+
+    // Длинные линии
+    unsigned seed = 9;
+
+    for ( int i = 0; i != 200; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const Hex hex_a( static_cast<int>( seed >> 20 ) - 2048, static_cast<int>( seed & 0xfff ) - 2048 );
+        seed = seed * 1103515245U + 12345U;
+        const Hex hex_b( static_cast<int>( seed >> 20 ) - 2048, static_cast<int>( seed & 0xfff ) - 2048 );
+        const HexLineWalker walker( hex_a, hex_b );
+        AssertEqual( vector<Hex>( walker.begin(), walker.end() ), HexLine( hex_a, hex_b, false, 0 ), "HexLineWalker long line" );
+    }
+
+    // Досрочная остановка
+    HexLineWalker walker( Hex( 0, 0 ), Hex( 10, -5 ) );
+    Assert( walker.Walk( []( const Hex& hex ) { return hex.Q() == 4; } ), "HexLineWalker Walk stopped" );
+    AssertEqual( walker.Current().Q(), 4, "HexLineWalker Walk current" );
+    AssertEqual( walker.Index(), 4, "HexLineWalker Walk index" );
+    Assert( !walker.Walk( []( const Hex& hex ) { return hex.Q() == 20; } ), "HexLineWalker Walk to end" );
+    Assert( walker.Done(), "HexLineWalker Done" );
+
+    const HexLineWalker point( Hex( 3, 3 ), Hex( 3, 3 ) );
+    AssertEqual( vector<Hex>( point.begin(), point.end() ), vector<Hex>{ Hex( 3, 3 ) }, "HexLineWalker point" );
+}
+
+void Test_HexLineOfSight() {
+    const auto nothing = []( const Hex& ) { return false; };
+    const auto wall = []( const Hex& hex ) { return hex.Q() == 0; };
+    Assert( HexLineOfSight( Hex( -3, 1 ), Hex( 4, -2 ), nothing ), "HexLineOfSight open" );
+    Assert( !HexLineOfSight( Hex( -3, 1 ), Hex( 4, -2 ), wall ), "HexLineOfSight wall" );
+    Assert( HexLineOfSight( Hex( -1, 0 ), Hex( 0, 0 ), wall ), "HexLineOfSight ends are not checked" );
+    Assert( HexLineOfSight( Hex( 1, 3 ), Hex( 1, -3 ), wall ), "HexLineOfSight along wall" );
+    Assert( HexLineOfSight( Hex( 5, 5 ), Hex( 5, 5 ), wall ), "HexLineOfSight same hex" );
+}
+
+void Test_HexVisibility() {
+    const Hex viewer( 1, 2 );
+    HexVisibility visibility;
+    vector<Hex> visible;
+
+    // Без препятствий виден весь диапазон в порядке спирали
+    for ( int radius = 0; radius <= 5; ++radius ) {
+        visibility.FieldOfView( viewer, radius, []( const Hex& ) { return false; }, visible );
+        AssertEqual( visible, vector<Hex>( HexSpiral( viewer, radius ).begin(), HexSpiral( viewer, radius ).end() ),
+                     "HexVisibility open" );
+    }
+
+    visibility.FieldOfView( viewer, -1, []( const Hex& ) { return false; }, visible );
+    Assert( visible.empty(), "HexVisibility negative radius" );
+
+    // Замкнутое кольцо препятствий: видно только внутри и само кольцо
+    visibility.FieldOfView( viewer, 6, [&viewer]( const Hex& hex ) { return HexDistance( hex, viewer ) == 2; }, visible );
+    AssertEqual( visible.size(), HexRangeSize( 2 ), "HexVisibility closed ring" );
+
+    // Одиночное препятствие скрывает гексы за собой (в том числе в направлении начала кольца)
+    for ( int direction = 0; direction != 6; ++direction ) {
+        const Hex blocker = viewer + HexDirection( direction );
+        visibility.FieldOfView( viewer, 5, [&blocker]( const Hex& hex ) { return hex == blocker; }, visible );
+        const auto is_visible = [&visible]( const Hex& hex ) {
+            return std::find( visible.begin(), visible.end(), hex ) != visible.end();
+        };
+
+        const string hint = "HexVisibility blocker " + std::to_string( direction );
+        Assert( is_visible( blocker ), hint + " visible" );
+        Assert( !is_visible( viewer + HexDirection( direction ) * 2 ), hint + " behind" );
+        Assert( !is_visible( viewer + HexDirection( direction ) * 5 ), hint + " far behind" );
+        Assert( is_visible( viewer + HexDirection( direction + 1 ) * 5 ), hint + " side" );
+        // Соседнее препятствие скрывает сектор 60 градусов: 1 + 3 + 3 + 5 гексов колец 2..5
+        AssertEqual( visible.size(), HexRangeSize( 5 ) - 12, hint + " hidden count" );
+    }
+
+    // Карта препятствий: гексы вне карты перекрывают обзор
+    HexMap<uint8_t> blockers( HexMapShape::Hexagon( viewer, 3 ), 0 );
+    visibility.FieldOfView( viewer, 10, blockers, visible );
+    AssertEqual( visible.size(), HexRangeSize( 4 ), "HexVisibility map border" );
+
+    // Пакетный режим совпадает с одиночным
+    unsigned seed = 5;
+    HexMap<uint8_t> terrain( HexMapShape::Rhombus( Hex( 0, 0 ), 40, 40 ), 0 );
+
+    for ( size_t i = 0; i != terrain.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        terrain.Cell( i ) = ( ( seed >> 16 ) % 5 == 0 );
+    }
+
+    vector<Hex> viewers;
+
+    for ( int i = 0; i != 50; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        viewers.push_back( terrain.Shape().HexAt( ( seed >> 8 ) % terrain.Size() ) );
+    }
+
+    HexThreadPool pool( 3 );
+    HexVisibilityBatch batch( pool );
+    vector<vector<Hex>> batch_visible;
+    batch.FieldOfView( viewers, 8, terrain, batch_visible );
+    AssertEqual( batch_visible.size(), viewers.size(), "HexVisibilityBatch size" );
+
+    for ( size_t i = 0; i != viewers.size(); ++i ) {
+        visibility.FieldOfView( viewers[ i ], 8, terrain, visible );
+        AssertEqual( batch_visible[ i ], visible, "HexVisibilityBatch" );
+
+        for ( const Hex& hex : visible ) {
+            Assert( HexDistance( hex, viewers[ i ] ) <= 8, "HexVisibility radius" );
+        }
+    }
+}
+
+void Test_HexBinner() {
+    const HexLayout layout( HEX_ORIENTATION_FLAT, OFFSET_TYPE_ODD, Point( 3.0, 2.0 ), Point( 10.0, -4.0 ) );
+    const size_t count = 50000;
+    vector<double> x( count );
+    vector<double> y( count );
+    std::unordered_map<Hex, uint64_t> expected;
+    std::ostringstream text;
+    std::ostringstream binary;
+    unsigned seed = 17;
+
+    text << "x,y\n";
+
+    for ( size_t i = 0; i != count; ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        x[ i ] = static_cast<double>( ( seed >> 8 ) % 20000 ) / 16.0 - 600.0;
+        seed = seed * 1103515245U + 12345U;
+        y[ i ] = static_cast<double>( ( seed >> 8 ) % 20000 ) / 16.0 - 600.0;
+        ++expected[ PixelToHex( layout, Point( x[ i ], y[ i ] ) ).Round( HEX_ROUND_DEFAULT ) ];
+
+        text.precision( 17 );
+        text << x[ i ] << ( i % 3 == 0 ? ", " : i % 3 == 1 ? "\t" : ";" ) << y[ i ] << ( i % 100 == 0 ? "\n\n" : "\n" );
+        binary.write( reinterpret_cast<const char*>( &x[ i ] ), sizeof( double ) );
+        binary.write( reinterpret_cast<const char*>( &y[ i ] ), sizeof( double ) );
+    }
+
+    // Точка 0 повторяется в конце, неполная запись и неверная строка отвергаются
+    text << "1 2 3\n" << x[ 0 ] << ' ' << y[ 0 ];
+    binary.write( reinterpret_cast<const char*>( &x[ 0 ] ), sizeof( double ) );
+    binary.write( reinterpret_cast<const char*>( &y[ 0 ] ), sizeof( double ) );
+    binary.write( reinterpret_cast<const char*>( &x[ 1 ] ), sizeof( double ) );
+    ++expected[ PixelToHex( layout, Point( x[ 0 ], y[ 0 ] ) ).Round( HEX_ROUND_DEFAULT ) ];
+
+    // Гистограмма совпадает с подсчётом по точкам
+    const auto check = [&expected, count]( HexBinner& binner, const char* hint ) {
+        HexChunkMap<uint64_t>& histogram = binner.Histogram();
+        uint64_t total = 0;
+
+        for ( const auto& bin : expected ) {
+            AssertEqual( histogram.Get( bin.first ), bin.second, hint );
+            total += bin.second;
+        }
+
+        AssertEqual( binner.Points(), uint64_t( count + 1 ), hint );
+        AssertEqual( total, binner.Points(), hint );
+    };
+
+    HexThreadPool pool( 3 );
+
+    for ( HexThreadPool* binner_pool : { static_cast<HexThreadPool*>( nullptr ), &pool } ) {
+        HexBinner binner( layout, binner_pool, 5000 );
+        std::istringstream input( text.str() );
+        AssertEqual( binner.ReadText( input ), uint64_t( count + 1 ), "HexBinner ReadText points" );
+        AssertEqual( binner.Rejected(), uint64_t( 2 ), "HexBinner ReadText rejected" );
+        check( binner, "HexBinner ReadText" );
+
+        binner.Clear();
+        AssertEqual( binner.Points(), uint64_t( 0 ), "HexBinner Clear" );
+        binner.Add( x.data(), y.data(), count );
+        binner.Add( x.data(), y.data(), 1 );
+        check( binner, "HexBinner Add" );
+
+        binner.Clear();
+        std::istringstream binary_input( binary.str() );
+        AssertEqual( binner.ReadBinary( binary_input ), uint64_t( count + 1 ), "HexBinner ReadBinary points" );
+        check( binner, "HexBinner ReadBinary" );
+    }
+
+    // Строка длиннее блока чтения
+    HexBinner binner( layout, nullptr, 1 );
+    std::istringstream input( string( 200000, ' ' ) + "1.5 2.5\n" );
+    AssertEqual( binner.ReadText( input ), uint64_t( 1 ), "HexBinner ReadText long line" );
+    AssertEqual( binner.Histogram().Get( PixelToHex( layout, Point( 1.5, 2.5 ) ).Round( HEX_ROUND_DEFAULT ) ), uint64_t( 1 ),
+                 "HexBinner long line bin" );
+
+    // Строка с одним числом: второе число не берётся из следующей строки
+    binner.Clear();
+    std::istringstream split_input( "1.0\n2.0 3.0\n4.0" );
+    AssertEqual( binner.ReadText( split_input ), uint64_t( 1 ), "HexBinner ReadText single number" );
+    AssertEqual( binner.Rejected(), uint64_t( 2 ), "HexBinner ReadText single number rejected" );
+    AssertEqual( binner.Histogram().Get( PixelToHex( layout, Point( 2.0, 3.0 ) ).Round( HEX_ROUND_DEFAULT ) ), uint64_t( 1 ),
+                 "HexBinner single number bin" );
+}
+
+void Test_HexStencil() {
+    const HexLayout flat( HEX_ORIENTATION_FLAT, OFFSET_TYPE_EVEN, Point( 1.0, 1.0 ), Point( 0.0, 0.0 ) );
+    const HexLayout pointy( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 1.0, 1.0 ), Point( 0.0, 0.0 ) );
+    HexThreadPool pool( 3 );
+
+    for ( const HexMapShape& shape : { HexMapShape::Hexagon( Hex( 4, -2 ), 9 ), HexMapShape::Rectangle( flat, 23, 14 ),
+                                       HexMapShape::Rectangle( pointy, 17, 20 ), HexMapShape::Rhombus( Hex( -5, 3 ), 8, 5 ),
+                                       HexMapShape::Hexagon( Hex( 0, 0 ), 0 ) } ) {
+        // Диффузия с границей outside: сравнение с вычислением по гексам
+        const float outside = -2.0f;
+        HexMap<float> expected( shape.WithOrder( HEX_MAP_ORDER_MORTON ) );
+        unsigned seed = 5;
+
+        for ( auto cell : expected ) {
+            seed = seed * 1103515245U + 12345U;
+            cell.value = static_cast<float>( ( seed >> 8 ) % 100 );
+        }
+
+        HexStencil<float> stencil( shape, outside );
+        stencil.Load( expected );
+        AssertEqual( stencil.Size(), shape.Size(), "HexStencil Size" );
+
+        for ( int step = 0; step != 3; ++step ) {
+            HexMap<float> next( expected.Shape() );
+
+            for ( auto cell : expected ) {
+                float sum = 0.0f;
+
+                for ( const Hex& direction : HEX_DIRECTIONS ) {
+                    const float* neighbor = expected.Find( cell.hex + direction );
+                    sum += ( neighbor != nullptr ? *neighbor : outside );
+                }
+
+                next[ cell.hex ] = cell.value * 0.25f + sum * 0.125f;
+            }
+
+            std::swap( expected, next );
+            stencil.Step( []( const HexStencilCell<float, 1>& cell ) {
+                float sum = 0.0f;
+
+                for ( int direction = 0; direction != 6; ++direction ) {
+                    sum += cell.Neighbor( direction );
+                }
+
+                cell.Next() = cell() * 0.25f + sum * 0.125f;
+            }, ( step == 1 ? &pool : nullptr ) );
+        }
+
+        HexMap<float> result( expected.Shape() );
+        stencil.Store( result );
+
+        for ( auto cell : result ) {
+            AssertEqual( cell.value, expected[ cell.hex ], "HexStencil Step" );
+            AssertEqual( stencil[ cell.hex ], cell.value, "HexStencil []" );
+        }
+    }
+
+    // Несколько полей: направление соседа, значение которого переносится в ячейку
+    const HexMapShape shape = HexMapShape::Rectangle( pointy, 64, 48 );
+    HexStencil<int, 2> stencil( shape, -1 );
+    HexMap<int> values( shape );
+
+    for ( size_t index = 0; index != values.Size(); ++index ) {
+        values.Cell( index ) = static_cast<int>( index );
+    }
+
+    stencil.Load( values, 0 );
+    stencil.Fill( 4, 1 );
+    stencil.Step( []( const HexStencilCell<int, 2>& cell ) {
+        cell.Next( 0 ) = cell.Neighbor( cell( 1 ), 0 );
+        cell.Next( 1 ) = ( cell( 1 ) + 1 ) % 6;
+    }, &pool );
+
+    for ( size_t index = 0; index != values.Size(); ++index ) {
+        const Hex hex = shape.HexAt( index );
+        const int* neighbor = values.Find( hex + HexDirection( 4 ) );
+        AssertEqual( stencil.At( 0, hex ), ( neighbor != nullptr ? *neighbor : -1 ), "HexStencil fields" );
+        AssertEqual( stencil.At( 1, hex ), 5, "HexStencil second field" );
+    }
+}
+
+void Test_HexSpatialIndex() {
+    HexSpatialIndex index;
+    const Hex center( 5, -2 );
+
+    // По одному объекту на каждый гекс спирали радиуса 4 и ещё один в центре
+    vector<Hex> spiral( HexSpiral( center, 4 ).begin(), HexSpiral( center, 4 ).end() );
+
+    for ( size_t id = 0; id != spiral.size(); ++id ) {
+        index.Insert( static_cast<uint32_t>( id ), spiral[ id ] );
+    }
+
+    const uint32_t extra = static_cast<uint32_t>( spiral.size() );
+    index.Insert( extra, center );
+    AssertEqual( index.Size(), spiral.size() + 1, "HexSpatialIndex Size" );
+    AssertEqual( index.HexOf( 7 ), spiral[ 7 ], "HexSpatialIndex HexOf" );
+
+    vector<uint32_t> result;
+    index.QueryRadius( center, 2, result );
+    AssertEqual( result.size(), HexRangeSize( 2 ) + 1, "HexSpatialIndex QueryRadius" );
+
+    for ( uint32_t id : result ) {
+        Assert( HexDistance( index.HexOf( id ), center ) <= 2, "HexSpatialIndex QueryRadius distance" );
+    }
+
+    // k ближайших упорядочены по расстоянию
+    index.QueryNearest( center + HexDirection( 0 ), 10, result );
+    AssertEqual( result.size(), 10U, "HexSpatialIndex QueryNearest size" );
+
+    for ( size_t i = 1; i != result.size(); ++i ) {
+        Assert( HexDistance( index.HexOf( result[ i - 1 ] ), center + HexDirection( 0 ) )
+                <= HexDistance( index.HexOf( result[ i ] ), center + HexDirection( 0 ) ), "HexSpatialIndex QueryNearest order" );
+    }
+
+    index.QueryNearest( center, 1000, result );
+    AssertEqual( result.size(), index.Size(), "HexSpatialIndex QueryNearest all" );
+    index.QueryNearest( center + HexDirection( 1 ) * 20, 5, result, 10 );
+    Assert( result.empty(), "HexSpatialIndex QueryNearest max_radius" );
+
+    // Перемещение и удаление
+    index.Move( extra, Hex( 100, 100 ) );
+    index.QueryRadius( center, 0, result );
+    AssertEqual( result, vector<uint32_t>{ 0 }, "HexSpatialIndex Move from" );
+    index.QueryRadius( Hex( 100, 100 ), 1, result );
+    AssertEqual( result, vector<uint32_t>{ extra }, "HexSpatialIndex Move to" );
+    index.Remove( 0 );
+    index.Remove( 0 );
+    Assert( !index.Contains( 0 ), "HexSpatialIndex Remove" );
+    AssertEqual( index.First( center ), HexSpatialIndex::NONE, "HexSpatialIndex Remove head" );
+    AssertEqual( index.Size(), spiral.size(), "HexSpatialIndex Remove size" );
+
+    // Удалённый и отсутствующий объекты не перемещаются
+    index.Move( 0, Hex( 100, 100 ) );
+    index.Move( static_cast<uint32_t>( index.Capacity() ), Hex( 100, 100 ) );
+    Assert( !index.Contains( 0 ), "HexSpatialIndex Move removed" );
+    index.QueryRadius( Hex( 100, 100 ), 1, result );
+    AssertEqual( result, vector<uint32_t>{ extra }, "HexSpatialIndex Move removed list" );
+    index.Insert( 0, center );
+    index.QueryRadius( center, 0, result );
+    AssertEqual( result, vector<uint32_t>{ 0 }, "HexSpatialIndex Insert after Remove" );
+    index.Remove( 0 );
+
+    // Пакетное обновление совпадает с перестроением и с поштучным добавлением
+    const HexLayout layout( HEX_ORIENTATION_POINTY, OFFSET_TYPE_ODD, Point( 10.0, 10.0 ), Point( 3.0, -7.0 ) );
+    const size_t count = 10000;
+    vector<double> x( count );
+    vector<double> y( count );
+    unsigned seed = 17;
+    HexThreadPool pool( 3 );
+    HexSpatialIndex updated;
+    HexSpatialIndex rebuilt;
+
+    for ( int tick = 0; tick != 3; ++tick ) {
+        for ( size_t i = 0; i != count; ++i ) {
+            seed = seed * 1103515245U + 12345U;
+            x[ i ] = ( ( seed >> 8 ) % 20000 ) / 10.0 - 1000.0;
+            seed = seed * 1103515245U + 12345U;
+            y[ i ] = ( ( seed >> 8 ) % 20000 ) / 10.0 - 1000.0;
+        }
+
+        updated.Update( layout, x.data(), y.data(), count, &pool );
+        rebuilt.Rebuild( layout, x.data(), y.data(), count );
+        AssertEqual( updated.Size(), count, "HexSpatialIndex Update size" );
+        AssertEqual( rebuilt.Size(), count, "HexSpatialIndex Rebuild size" );
+
+        for ( uint32_t id = 0; id < count; id += 97 ) {
+            const Hex hex = PixelToHex( layout, Point( x[ id ], y[ id ] ) ).Round( HEX_ROUND_DEFAULT );
+            AssertEqual( updated.HexOf( id ), hex, "HexSpatialIndex Update hex" );
+            AssertEqual( rebuilt.HexOf( id ), hex, "HexSpatialIndex Rebuild hex" );
+
+            vector<uint32_t> updated_result;
+            vector<uint32_t> rebuilt_result;
+            updated.QueryRadius( hex, 3, updated_result );
+            rebuilt.QueryRadius( hex, 3, rebuilt_result );
+            std::sort( updated_result.begin(), updated_result.end() );
+            std::sort( rebuilt_result.begin(), rebuilt_result.end() );
+            AssertEqual( updated_result, rebuilt_result, "HexSpatialIndex Update == Rebuild" );
+            Assert( std::binary_search( updated_result.begin(), updated_result.end(), id ), "HexSpatialIndex QueryRadius self" );
+        }
+    }
+
+    rebuilt.Clear();
+    AssertEqual( rebuilt.Size(), 0U, "HexSpatialIndex Clear" );
+    Assert( rebuilt.Compact() > 0, "HexSpatialIndex Compact" );
+}
+
+void Test_HexHierarchy() {
+    // Родитель и дочерние гексы
+    for ( const Hex& hex : HexRange( Hex( 3, -5 ), 30 ) ) {
+        const Hex parent = HexParent( hex );
+        AssertEqual( HexChild( parent, HexChildIndex( hex ) ), hex, "HexChild( HexParent )" );
+        AssertEqual( HexParent( hex, 2 ), HexParent( parent ), "HexParent levels" );
+    }
+
+    for ( const Hex& parent : HexRange( Hex( -2, 1 ), 5 ) ) {
+        AssertEqual( HexChildIndex( HexCenterChild( parent ) ), 0, "HexCenterChild index" );
+
+        for ( int child = 0; child != HEX_HIERARCHY_APERTURE; ++child ) {
+            AssertEqual( HexParent( HexChild( parent, child ) ), parent, "HexParent( HexChild )" );
+            AssertEqual( HexChildIndex( HexChild( parent, child ) ), child, "HexChildIndex" );
+        }
+
+        // Соседние родители - соседние гексы
+        for ( const Hex& direction : HEX_DIRECTIONS ) {
+            AssertEqual( HexDistance( HexCenterChild( parent ), HexCenterChild( parent + direction ) ), 3U, "HexCenterChild neighbor" );
+        }
+    }
+
+    // Уровни карты
+    const HexMapShape shape = HexMapShape::Rhombus( Hex( -10, 4 ), 50, 40 );
+    const HexHierarchy hierarchy( shape, 3 );
+    AssertEqual( hierarchy.Levels(), 3, "HexHierarchy Levels" );
+
+    for ( int level = 1; level <= hierarchy.Levels(); ++level ) {
+        const HexMapShape& fine = hierarchy.Shape( level - 1 );
+        const HexMapShape& coarse = hierarchy.Shape( level );
+        size_t children = 0;
+        size_t cells = 0;
+
+        for ( size_t index = 0; index != coarse.Size(); ++index ) {
+            Assert( hierarchy.ChildCount( level, index ) <= static_cast<size_t>( HEX_HIERARCHY_APERTURE ), "HexHierarchy ChildCount" );
+            children += hierarchy.ChildCount( level, index );
+            cells += hierarchy.CellCount( level, index );
+
+            for ( const uint32_t* child = hierarchy.ChildrenBegin( level, index ); child != hierarchy.ChildrenEnd( level, index ); ++child ) {
+                AssertEqual( hierarchy.Parent( level - 1, *child ), index, "HexHierarchy Parent" );
+                AssertEqual( HexParent( fine.HexAt( *child ) ), coarse.HexAt( index ), "HexHierarchy child hex" );
+            }
+        }
+
+        AssertEqual( children, fine.Size(), "HexHierarchy children" );
+        AssertEqual( cells, shape.Size(), "HexHierarchy CellCount" );
+    }
+
+    // Агрегаты совпадают с прямым вычислением и после изменений
+    HexMap<int> values( shape, 0 );
+    unsigned seed = 5;
+
+    for ( size_t i = 0; i != values.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        values.Cell( i ) = static_cast<int>( ( seed >> 8 ) % 1000 );
+    }
+
+    HexHierarchyAggregate<int> sums( hierarchy, HEX_AGGREGATE_SUM );
+    HexHierarchyAggregate<int> mins( hierarchy, HEX_AGGREGATE_MIN );
+    HexHierarchyAggregate<int> maxs( hierarchy, HEX_AGGREGATE_MAX );
+    sums.Build( values );
+    mins.Build( values );
+    maxs.Build( values );
+
+    for ( int step = 0; step != 3; ++step ) {
+        for ( int level = 0; level <= hierarchy.Levels(); ++level ) {
+            const HexMapShape& coarse = hierarchy.Shape( level );
+            vector<int> sum( coarse.Size(), 0 );
+            vector<int> min( coarse.Size(), std::numeric_limits<int>::max() );
+            vector<int> max( coarse.Size(), std::numeric_limits<int>::lowest() );
+
+            for ( size_t i = 0; i != values.Size(); ++i ) {
+                const size_t index = coarse.Index( HexParent( shape.HexAt( i ), level ) );
+                AssertEqual( hierarchy.Ancestor( i, level ), index, "HexHierarchy Ancestor" );
+                sum[ index ] += values.Cell( i );
+                min[ index ] = std::min( min[ index ], values.Cell( i ) );
+                max[ index ] = std::max( max[ index ], values.Cell( i ) );
+            }
+
+            for ( size_t index = 0; index != coarse.Size(); ++index ) {
+                AssertEqual( sums.Value( level, index ), sum[ index ], "HexHierarchyAggregate SUM" );
+                AssertEqual( mins.Value( level, index ), min[ index ], "HexHierarchyAggregate MIN" );
+                AssertEqual( maxs.Value( level, index ), max[ index ], "HexHierarchyAggregate MAX" );
+            }
+        }
+
+        for ( int change = 0; change != 200; ++change ) {
+            seed = seed * 1103515245U + 12345U;
+            const size_t i = ( seed >> 8 ) % values.Size();
+            seed = seed * 1103515245U + 12345U;
+            values.Cell( i ) = static_cast<int>( ( seed >> 8 ) % 2000 ) - 500;
+            sums.Set( shape.HexAt( i ), values.Cell( i ) );
+            mins.Set( i, values.Cell( i ) );
+            maxs.Set( i, values.Cell( i ) );
+        }
+    }
+
+    // Иерархический поиск пути: путь допустим и не короче кратчайшего
+    HexMap<float> costs( shape, 1.0f );
+
+    for ( size_t i = 0; i != costs.Size(); ++i ) {
+        seed = seed * 1103515245U + 12345U;
+        const unsigned value = ( seed >> 8 ) % 10;
+        costs.Cell( i ) = ( value < 3 ? HEX_PATH_BLOCKED : 1.0f + value % 3 );
+    }
+
+    HexHierarchicalPathfinder hierarchical( hierarchy, 2 );
+    HexPathfinder pathfinder( shape );
+    hierarchical.Build( costs );
+
+    // Пошаговое обновление агрегатов совпадает с полным вычислением
+    vector<Hex> changed;
+
+    for ( int change = 0; change != 100; ++change ) {
+        seed = seed * 1103515245U + 12345U;
+        const size_t i = ( seed >> 8 ) % costs.Size();
+        costs.Cell( i ) = ( costs.Cell( i ) < HEX_PATH_BLOCKED ? HEX_PATH_BLOCKED : 2.0f );
+        changed.push_back( shape.HexAt( i ) );
+    }
+
+    hierarchical.Update( changed, costs );
+    HexHierarchicalPathfinder rebuilt( hierarchy, 2 );
+    rebuilt.Build( costs );
+
+    for ( size_t index = 0; index != hierarchy.Shape( 2 ).Size(); ++index ) {
+        AssertEqual( hierarchical.CoarseCost( index ), rebuilt.CoarseCost( index ), "HexHierarchicalPathfinder Update" );
+    }
+
+    vector<Hex> path;
+    vector<Hex> expected;
+
+    for ( int query = 0; query != 50; ++query ) {
+        seed = seed * 1103515245U + 12345U;
+        const Hex start = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+        seed = seed * 1103515245U + 12345U;
+        const Hex goal = shape.HexAt( ( seed >> 8 ) % shape.Size() );
+
+        const HexPathStats stats = hierarchical.FindPath( start, goal, costs, path );
+        const HexPathStats optimal = pathfinder.FindPath( start, goal, costs, expected );
+        AssertEqual( stats.found, optimal.found, "HexHierarchicalPathfinder found" );
+
+        if ( optimal.found ) {
+            Assert( stats.cost >= optimal.cost, "HexHierarchicalPathfinder cost" );
+            AssertEqual( path.front(), start, "HexHierarchicalPathfinder start" );
+            AssertEqual( path.back(), goal, "HexHierarchicalPathfinder goal" );
+            float cost = 0.0f;
+
+            for ( size_t i = 1; i != path.size(); ++i ) {
+                AssertEqual( HexDistance( path[ i - 1 ], path[ i ] ), 1U, "HexHierarchicalPathfinder step" );
+                cost += costs[ path[ i ] ];
+            }
+
+            AssertEqual( cost, stats.cost, "HexHierarchicalPathfinder path cost" );
+        }
+    }
+}
+
 int main() {
     TestRunner runner;
     runner.RunTest( Test_HexArithmetic, "Test_HexArithmetic" );
+    runner.RunTest( Test_HexValue, "Test_HexValue" );
     runner.RunTest( Test_HexDirection, "Test_HexDirection" );
     runner.RunTest( Test_HexNeighbor, "Test_HexNeighbor" );
     runner.RunTest( Test_HexDiagonal, "Test_HexDiagonal" );
     runner.RunTest( Test_HexDistance, "Test_HexDistance" );
     runner.RunTest( Test_HexRotate, "Test_HexRotate" );
     runner.RunTest( Test_HexRound, "Test_HexRound" );
+    runner.RunTest( Test_HexRoundAlgorithm, "Test_HexRoundAlgorithm" );
     runner.RunTest( Test_HexLine, "Test_HexLine" );
+    runner.RunTest( Test_HexNoAllocation, "Test_HexNoAllocation" );
     runner.RunTest( Test_HexLayout, "Test_HexLayout" );
+    runner.RunTest( Test_HexLayoutCache, "Test_HexLayoutCache" );
+    runner.RunTest( Test_StaticHexLayout, "Test_StaticHexLayout" );
+    runner.RunTest( Test_PixelToHexBatch, "Test_PixelToHexBatch" );
+    runner.RunTest( Test_HexCornersBatch, "Test_HexCornersBatch" );
+    runner.RunTest( Test_OffsetCubeBatch, "Test_OffsetCubeBatch" );
     runner.RunTest( Test_OffsetCubeConversion, "Test_OffsetCubeConversion" );
     runner.RunTest( Test_CubeToOffset, "Test_CubeToOffset" );
     runner.RunTest( Test_OffsetToCube, "Test_OffsetToCube" );
+    runner.RunTest( Test_HexMapShape, "Test_HexMapShape" );
+    runner.RunTest( Test_HexMap, "Test_HexMap" );
+    runner.RunTest( Test_HexKey, "Test_HexKey" );
+    runner.RunTest( Test_HexMorton, "Test_HexMorton" );
+    runner.RunTest( Test_HexMapFile, "Test_HexMapFile" );
+    runner.RunTest( Test_HexChunkMap, "Test_HexChunkMap" );
+    runner.RunTest( Test_HexRange, "Test_HexRange" );
+    runner.RunTest( Test_HexPathfinder, "Test_HexPathfinder" );
+    runner.RunTest( Test_HexThreadPool, "Test_HexThreadPool" );
+    runner.RunTest( Test_HexProfile, "Test_HexProfile" );
+    runner.RunTest( Test_HexPathBatch, "Test_HexPathBatch" );
+    runner.RunTest( Test_HexFlowField, "Test_HexFlowField" );
+    runner.RunTest( Test_HexLineWalker, "Test_HexLineWalker" );
+    runner.RunTest( Test_HexLineOfSight, "Test_HexLineOfSight" );
+    runner.RunTest( Test_HexVisibility, "Test_HexVisibility" );
+    runner.RunTest( Test_HexSpatialIndex, "Test_HexSpatialIndex" );
+    runner.RunTest( Test_HexBinner, "Test_HexBinner" );
+    runner.RunTest( Test_HexStencil, "Test_HexStencil" );
+    runner.RunTest( Test_HexHierarchy, "Test_HexHierarchy" );
 
     return 0;
 }